@@ -0,0 +1,503 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ *
+ * Copyright (C) 2016, 2017, Joshua Saxby joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "saxbospiral.h"
+#include "serialise.h"
+#include "archive.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+// constants related to how archives are packed in files - measured in bytes
+const size_t SXBP_ARCHIVE_HEADER_SIZE = (
+    4 + // 'sxba' file magic number
+    6 // file version, 3x 16-bit uints
+);
+const size_t SXBP_ARCHIVE_ENTRY_PACK_SIZE = (
+    8 + // hash of the serialised spiral, 64 bit uint
+    8 + // offset of the serialised spiral, 64 bit uint
+    8 // size of the serialised spiral, 64 bit uint
+);
+const size_t SXBP_ARCHIVE_FOOTER_SIZE = (
+    8 + // offset of the index, 64 bit uint
+    4 + // count of entries in the index, 32 bit uint
+    4 // 'sxbi' index magic number
+);
+// the number of entries which memory is first allocated for when writing
+#define INITIAL_CAPACITY 64
+
+/*
+ * NOTE: Like the spiral file format, archives use big-endian representation
+ * for all of their integers.
+ */
+
+// loads an unsigned integer of the given number of bytes from bytes
+static uint64_t load_uint(const uint8_t* bytes, uint8_t size) {
+    uint64_t value = 0;
+    for(uint8_t i = 0; i < size; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// dumps an unsigned integer of value to the given number of bytes of bytes
+static void dump_uint(uint64_t value, uint8_t* bytes, uint8_t size) {
+    for(uint8_t i = 0; i < size; i++) {
+        bytes[size - 1 - i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+uint64_t sxbp_hash_spiral_data(sxbp_buffer_t buffer) {
+    // preconditional assertions
+    assert(buffer.bytes != NULL);
+    // FNV-1a, 64-bit variant
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(size_t i = 0; i < buffer.size; i++) {
+        hash ^= buffer.bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// private function, rotates value left by the given number of bits
+static uint64_t rotate_left(uint64_t value, uint8_t bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/*
+ * private function, calculates a second hash of the buffer for de-duplicating,
+ * which shares nothing with FNV-1a so that data colliding under one is very
+ * unlikely to also collide under the other. It multiplies and rotates in each
+ * 8-byte word and finishes with the 64-bit mixer from MurmurHash3.
+ */
+static uint64_t check_spiral_data(sxbp_buffer_t buffer) {
+    uint64_t hash = (uint64_t)buffer.size * 0x9e3779b97f4a7c15ULL;
+    for(size_t i = 0; i < buffer.size; i += 8) {
+        uint64_t word = 0;
+        for(size_t j = i; j < i + 8 && j < buffer.size; j++) {
+            word |= (uint64_t)buffer.bytes[j] << (8 * (j - i));
+        }
+        word *= 0x87c37b91114253d5ULL;
+        word = rotate_left(word, 31) * 0x4cf5ad432745937fULL;
+        hash = rotate_left(hash ^ word, 27) * 5 + 0x52dce729;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// private function, frees the memory held by an archive writer
+static void free_writer(sxbp_archive_writer_t* writer) {
+    free(writer->entries);
+    free(writer->table);
+    free(writer->checks);
+    writer->entries = NULL;
+    writer->table = NULL;
+    writer->checks = NULL;
+}
+
+/*
+ * private function, writes bytes through the writer's callback and keeps
+ * track of how many have been written. Returns whether it succeeded.
+ */
+static bool write_bytes(
+    sxbp_archive_writer_t* writer, const uint8_t* bytes, size_t size
+) {
+    if(writer->write_callback(bytes, size, writer->user_data) != size) {
+        return false;
+    }
+    writer->offset += size;
+    return true;
+}
+
+/*
+ * private function, returns the slot of the writer's hash table which holds
+ * the duplicate of the given entry with the given second hash, or the empty
+ * slot where it should go
+ */
+static uint32_t find_slot(
+    const sxbp_archive_writer_t* writer, sxbp_archive_entry_t entry,
+    uint64_t check
+) {
+    uint32_t mask = writer->table_size - 1;
+    uint32_t slot = (uint32_t)entry.hash & mask;
+    // linear probing - the table is never allowed to become full
+    while(writer->table[slot] != 0) {
+        uint32_t index = writer->table[slot] - 1;
+        sxbp_archive_entry_t other = writer->entries[index];
+        if(
+            other.hash == entry.hash && other.size == entry.size &&
+            writer->checks[index] == check
+        ) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*
+ * private function, doubles the size of the writer's hash table and re-inserts
+ * all of the entries into it. Returns SXBP_MALLOC_REFUSED on failure.
+ */
+static sxbp_status_t grow_table(sxbp_archive_writer_t* writer) {
+    uint32_t* old_table = writer->table;
+    uint32_t old_size = writer->table_size;
+    // the table's size must still fit in 32 bits once doubled
+    if(old_size > UINT32_MAX / 2) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    uint32_t* table = calloc(old_size * 2, sizeof(uint32_t));
+    if(table == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    writer->table = table;
+    writer->table_size = old_size * 2;
+    for(uint32_t i = 0; i < old_size; i++) {
+        if(old_table[i] != 0) {
+            uint32_t index = old_table[i] - 1;
+            uint32_t slot = find_slot(
+                writer, writer->entries[index], writer->checks[index]
+            );
+            writer->table[slot] = old_table[i];
+        }
+    }
+    free(old_table);
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_begin_archive(
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data, bool deduplicate, sxbp_archive_writer_t* writer
+) {
+    // preconditional assertions
+    assert(write_callback != NULL);
+    writer->write_callback = write_callback;
+    writer->user_data = user_data;
+    writer->offset = 0;
+    writer->count = 0;
+    writer->capacity = INITIAL_CAPACITY;
+    writer->table = NULL;
+    writer->table_size = 0;
+    writer->checks = NULL;
+    writer->entries = calloc(writer->capacity, sizeof(sxbp_archive_entry_t));
+    if(writer->entries == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    if(deduplicate) {
+        // twice the capacity keeps the table at most half full
+        writer->table_size = writer->capacity * 2;
+        writer->table = calloc(writer->table_size, sizeof(uint32_t));
+        writer->checks = calloc(writer->capacity, sizeof(uint64_t));
+        if(writer->table == NULL || writer->checks == NULL) {
+            free_writer(writer);
+            return SXBP_MALLOC_REFUSED;
+        }
+    }
+    uint8_t header[10];
+    memcpy(header, "sxba", 4);
+    dump_uint(LIB_SXBP_VERSION.major, header + 4, 2);
+    dump_uint(LIB_SXBP_VERSION.minor, header + 6, 2);
+    dump_uint(LIB_SXBP_VERSION.patch, header + 8, 2);
+    if(!write_bytes(writer, header, SXBP_ARCHIVE_HEADER_SIZE)) {
+        // the writer can't be finished without a header, so free it now
+        free_writer(writer);
+        return SXBP_OPERATION_FAIL;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_archive_append(
+    sxbp_archive_writer_t* writer, sxbp_buffer_t spiral_data
+) {
+    // preconditional assertions
+    assert(writer->entries != NULL);
+    assert(spiral_data.bytes != NULL);
+    sxbp_archive_entry_t entry = {
+        .hash = sxbp_hash_spiral_data(spiral_data),
+        .offset = writer->offset,
+        .size = spiral_data.size,
+    };
+    uint64_t check = 0;
+    uint32_t slot = 0;
+    if(writer->table != NULL) {
+        check = check_spiral_data(spiral_data);
+        slot = find_slot(writer, entry, check);
+        if(writer->table[slot] != 0) {
+            // it's a duplicate, so there's nothing to write
+            return SXBP_OPERATION_OK;
+        }
+    }
+    // entry indexes plus one must fit in the hash table
+    if(writer->count == UINT32_MAX - 1) {
+        return SXBP_OPERATION_FAIL;
+    }
+    /*
+     * keep the table at most half full, so probe sequences stay short and
+     * always end. It is grown before anything is written, so that if growing
+     * it fails, the spiral has not been added to the archive at all.
+     */
+    if(writer->table != NULL && writer->count + 1 > writer->table_size / 2) {
+        sxbp_status_t status = grow_table(writer);
+        if(status != SXBP_OPERATION_OK) {
+            return status;
+        }
+        // the spiral's slot moves along with everything else in the table
+        slot = find_slot(writer, entry, check);
+    }
+    // make room for the new entry if needed
+    if(writer->count == writer->capacity) {
+        uint32_t capacity = (
+            (writer->capacity > UINT32_MAX / 2) ?
+            UINT32_MAX : writer->capacity * 2
+        );
+        sxbp_archive_entry_t* entries = realloc(
+            writer->entries, capacity * sizeof(sxbp_archive_entry_t)
+        );
+        if(entries == NULL) {
+            return SXBP_MALLOC_REFUSED;
+        }
+        writer->entries = entries;
+        if(writer->checks != NULL) {
+            uint64_t* checks = realloc(
+                writer->checks, capacity * sizeof(uint64_t)
+            );
+            if(checks == NULL) {
+                return SXBP_MALLOC_REFUSED;
+            }
+            writer->checks = checks;
+        }
+        writer->capacity = capacity;
+    }
+    if(!write_bytes(writer, spiral_data.bytes, spiral_data.size)) {
+        return SXBP_OPERATION_FAIL;
+    }
+    writer->entries[writer->count] = entry;
+    if(writer->checks != NULL) {
+        writer->checks[writer->count] = check;
+    }
+    writer->count++;
+    if(writer->table != NULL) {
+        writer->table[slot] = writer->count;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+// private function, orders archive entries by hash for qsort()
+static int compare_entries(const void* a, const void* b) {
+    uint64_t hash_a = ((const sxbp_archive_entry_t*)a)->hash;
+    uint64_t hash_b = ((const sxbp_archive_entry_t*)b)->hash;
+    return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+sxbp_status_t sxbp_finish_archive(sxbp_archive_writer_t* writer) {
+    // preconditional assertions
+    assert(writer->entries != NULL);
+    sxbp_status_t result = SXBP_OPERATION_OK;
+    uint64_t index_offset = writer->offset;
+    // the index is sorted by hash so that readers can binary search it
+    qsort(
+        writer->entries, writer->count, sizeof(sxbp_archive_entry_t),
+        compare_entries
+    );
+    for(uint32_t i = 0; i < writer->count; i++) {
+        uint8_t packed[24];
+        dump_uint(writer->entries[i].hash, packed, 8);
+        dump_uint(writer->entries[i].offset, packed + 8, 8);
+        dump_uint(writer->entries[i].size, packed + 16, 8);
+        if(!write_bytes(writer, packed, SXBP_ARCHIVE_ENTRY_PACK_SIZE)) {
+            result = SXBP_OPERATION_FAIL;
+            break;
+        }
+    }
+    if(result == SXBP_OPERATION_OK) {
+        uint8_t footer[16];
+        dump_uint(index_offset, footer, 8);
+        dump_uint(writer->count, footer + 8, 4);
+        memcpy(footer + 12, "sxbi", 4);
+        if(!write_bytes(writer, footer, SXBP_ARCHIVE_FOOTER_SIZE)) {
+            result = SXBP_OPERATION_FAIL;
+        }
+    }
+    free_writer(writer);
+    return result;
+}
+
+sxbp_serialise_result_t sxbp_open_archive(
+    sxbp_buffer_t buffer, sxbp_archive_t* archive
+) {
+    // preconditional assertions
+    assert(buffer.bytes != NULL);
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_FAIL, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    if(buffer.size < SXBP_ARCHIVE_HEADER_SIZE + SXBP_ARCHIVE_FOOTER_SIZE) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_HEADER_SIZE;
+        return result;
+    }
+    const uint8_t* footer = buffer.bytes + buffer.size - SXBP_ARCHIVE_FOOTER_SIZE;
+    if(
+        (memcmp(buffer.bytes, "sxba", 4) != 0) ||
+        (memcmp(footer + 12, "sxbi", 4) != 0)
+    ) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_MAGIC_NUMBER;
+        return result;
+    }
+    sxbp_version_t archive_version = {
+        .major = (uint16_t)load_uint(buffer.bytes + 4, 2),
+        .minor = (uint16_t)load_uint(buffer.bytes + 6, 2),
+        .patch = (uint16_t)load_uint(buffer.bytes + 8, 2),
+    };
+    // archives were introduced in v0.27.0
+    sxbp_version_t min_version = { .major = 0, .minor = 27, .patch = 0, };
+    if(sxbp_version_less_than(archive_version, min_version)) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_VERSION;
+        return result;
+    }
+    uint64_t index_offset = load_uint(footer, 8);
+    uint32_t count = (uint32_t)load_uint(footer + 8, 4);
+    // the index must sit exactly between the spirals and the footer
+    uint64_t index_end = buffer.size - SXBP_ARCHIVE_FOOTER_SIZE;
+    if(
+        (index_offset < SXBP_ARCHIVE_HEADER_SIZE) ||
+        (index_offset > index_end) ||
+        ((index_end - index_offset) / SXBP_ARCHIVE_ENTRY_PACK_SIZE != count) ||
+        ((index_end - index_offset) % SXBP_ARCHIVE_ENTRY_PACK_SIZE != 0)
+    ) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE;
+        return result;
+    }
+    archive->buffer = buffer;
+    archive->index_offset = (size_t)index_offset;
+    archive->count = count;
+    result.status = SXBP_OPERATION_OK;
+    return result;
+}
+
+sxbp_serialise_result_t sxbp_archive_get(
+    const sxbp_archive_t* archive, uint32_t entry_index,
+    sxbp_buffer_t* spiral_data, sxbp_archive_entry_t* entry
+) {
+    // preconditional assertions
+    assert(entry_index < archive->count);
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_OK, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    const uint8_t* packed = (
+        archive->buffer.bytes + archive->index_offset +
+        ((size_t)entry_index * SXBP_ARCHIVE_ENTRY_PACK_SIZE)
+    );
+    sxbp_archive_entry_t found = {
+        .hash = load_uint(packed, 8),
+        .offset = load_uint(packed + 8, 8),
+        .size = load_uint(packed + 16, 8),
+    };
+    // spirals may only be stored between the header and the index
+    if(
+        (found.offset < SXBP_ARCHIVE_HEADER_SIZE) ||
+        (found.offset > archive->index_offset) ||
+        (found.size > archive->index_offset - found.offset)
+    ) {
+        result.status = SXBP_OPERATION_FAIL;
+        result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE;
+        return result;
+    }
+    spiral_data->bytes = archive->buffer.bytes + found.offset;
+    spiral_data->size = (size_t)found.size;
+    if(entry != NULL) {
+        *entry = found;
+    }
+    return result;
+}
+
+sxbp_serialise_result_t sxbp_archive_find(
+    const sxbp_archive_t* archive, uint64_t hash, sxbp_buffer_t* spiral_data
+) {
+    // binary search for the first entry with a hash at least as high
+    uint32_t low = 0;
+    uint32_t high = archive->count;
+    while(low < high) {
+        uint32_t middle = low + ((high - low) / 2);
+        uint64_t middle_hash = load_uint(
+            archive->buffer.bytes + archive->index_offset +
+            ((size_t)middle * SXBP_ARCHIVE_ENTRY_PACK_SIZE),
+            8
+        );
+        if(middle_hash < hash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    sxbp_archive_entry_t entry;
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_FAIL, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    if(low == archive->count) {
+        return result;
+    }
+    result = sxbp_archive_get(archive, low, spiral_data, &entry);
+    if(result.status == SXBP_OPERATION_OK && entry.hash != hash) {
+        result.status = SXBP_OPERATION_FAIL;
+    }
+    return result;
+}
+
+sxbp_status_t sxbp_archive_for_each(
+    const sxbp_archive_t* archive,
+    sxbp_status_t(* callback)(
+        sxbp_buffer_t spiral_data, uint32_t entry_index, void* user_data
+    ),
+    void* user_data
+) {
+    // preconditional assertions
+    assert(callback != NULL);
+    sxbp_status_t result = SXBP_OPERATION_OK;
+    #ifdef LIBSXBP_OPENMP_SUPPORT
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for(uint32_t i = 0; i < archive->count; i++) {
+        sxbp_buffer_t spiral_data;
+        sxbp_status_t status = sxbp_archive_get(
+            archive, i, &spiral_data, NULL
+        ).status;
+        if(status == SXBP_OPERATION_OK) {
+            status = callback(spiral_data, i, user_data);
+        }
+        if(status != SXBP_OPERATION_OK) {
+            #ifdef LIBSXBP_OPENMP_SUPPORT
+            #pragma omp critical
+            #endif
+            {
+                // only keep hold of the first error
+                if(result == SXBP_OPERATION_OK) {
+                    result = status;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
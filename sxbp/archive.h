@@ -0,0 +1,318 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ */
+
+/**
+ * @file
+ *
+ * @brief This compilation unit provides an archive file format for storing
+ * many serialised spirals together in one file.
+ *
+ * @details An archive holds serialised spirals (in any of the formats which
+ * sxbp_load_spiral() accepts) back to back, followed by an index of where
+ * each is stored, keyed by a hash of its contents. Archives are written
+ * sequentially through a callback, and read from a buffer (which may be
+ * memory mapped from a file) without copying the spirals out of it.
+ *
+ * @author Joshua Saxby <joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ * @date 2016, 2017
+ *
+ * @copyright Copyright (C) Joshua Saxby 2016, 2017
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef SAXBOPHONE_SAXBOSPIRAL_ARCHIVE_H
+#define SAXBOPHONE_SAXBOSPIRAL_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "saxbospiral.h"
+#include "serialise.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/**
+ * @brief Describes where one serialised spiral is stored in an archive.
+ */
+typedef struct sxbp_archive_entry_t {
+    /** @brief hash of the serialised spiral, see sxbp_hash_spiral_data() */
+    uint64_t hash;
+    /** @brief offset of the serialised spiral from the start of the archive */
+    uint64_t offset;
+    /** @brief size of the serialised spiral in bytes */
+    uint64_t size;
+} sxbp_archive_entry_t;
+
+/**
+ * @brief An archive which is being written.
+ * @details All fields are private, an archive writer should only be
+ * manipulated with the functions in this compilation unit.
+ */
+typedef struct sxbp_archive_writer_t {
+    /**
+     * @brief the callback which the archive is written through
+     * @private
+     */
+    size_t(* write_callback)(
+        const uint8_t* bytes, size_t size, void* user_data
+    );
+    /**
+     * @brief the user data to pass to the write callback
+     * @private
+     */
+    void* user_data;
+    /**
+     * @brief the number of bytes written so far
+     * @private
+     */
+    uint64_t offset;
+    /**
+     * @brief the entries appended so far
+     * @private
+     */
+    sxbp_archive_entry_t* entries;
+    /**
+     * @brief the count of entries appended so far
+     * @private
+     */
+    uint32_t count;
+    /**
+     * @brief the count of entries which memory is allocated for
+     * @private
+     */
+    uint32_t capacity;
+    /**
+     * @brief open-addressed hash table of entry indexes plus one (or zero for
+     * empty slots), used to find duplicates (NULL if not de-duplicating)
+     * @private
+     */
+    uint32_t* table;
+    /**
+     * @brief the number of slots in the hash table, always a power of two
+     * @private
+     */
+    uint32_t table_size;
+    /**
+     * @brief a second hash of each entry, made in a different way to the one
+     * in the index, which must also match for spirals to be duplicates (NULL if
+     * not de-duplicating)
+     * @private
+     */
+    uint64_t* checks;
+} sxbp_archive_writer_t;
+
+/**
+ * @brief An archive which is open for reading.
+ */
+typedef struct sxbp_archive_t {
+    /**
+     * @brief the buffer holding the archive
+     * @private
+     */
+    sxbp_buffer_t buffer;
+    /**
+     * @brief the offset of the index from the start of the archive
+     * @private
+     */
+    size_t index_offset;
+    /** @brief the number of spirals in the archive */
+    uint32_t count;
+} sxbp_archive_t;
+
+/** @brief The size of the archive file header in bytes */
+extern const size_t SXBP_ARCHIVE_HEADER_SIZE;
+/** @brief The size in bytes of one entry of the index of an archive */
+extern const size_t SXBP_ARCHIVE_ENTRY_PACK_SIZE;
+/** @brief The size of the archive file footer in bytes */
+extern const size_t SXBP_ARCHIVE_FOOTER_SIZE;
+
+/**
+ * @brief Calculates the hash which archives key serialised spirals by.
+ * @details This is the 64-bit FNV-1a hash of the bytes of the buffer.
+ *
+ * @param buffer The buffer holding the serialised spiral.
+ * @return The hash of the buffer's contents.
+ *
+ * @note Asserts:
+ * - That buffer.bytes is not NULL
+ */
+uint64_t sxbp_hash_spiral_data(sxbp_buffer_t buffer);
+
+/**
+ * @brief Starts writing a new archive.
+ * @details The archive header is written immediately. Spirals are then added
+ * with sxbp_archive_append() and the archive is completed with
+ * sxbp_finish_archive(), which writes the index.
+ *
+ * @param write_callback A function pointer as accepted by
+ * sxbp_dump_spiral_stream(), which the archive is written through.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle.
+ * @param deduplicate Whether spirals which are identical to one already in
+ * the archive should be skipped, rather than stored again.
+ * @param[out] writer The archive writer to initialise.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the callback failed to write the header.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ * @note On failure, no resources are left held by the writer.
+ *
+ * @note Asserts:
+ * - That write_callback is not NULL
+ */
+sxbp_status_t sxbp_begin_archive(
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data, bool deduplicate, sxbp_archive_writer_t* writer
+);
+
+/**
+ * @brief Appends a serialised spiral to an archive being written.
+ * @details When de-duplicating, spirals are taken to be identical if their
+ * sizes, their hashes and a second, independent 64-bit hash kept only in
+ * memory all match, and the data of a duplicate is not written. The data
+ * already written can't be read back to compare, so two different spirals
+ * would only be merged if both hashes collided at once.
+ *
+ * @param[in,out] writer The archive writer to append to.
+ * @param spiral_data A buffer holding the serialised spiral.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the callback failed to write the data, or
+ * the archive already holds the maximum number of spirals.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ * @note On memory allocation failure, nothing has been written and the
+ * spiral has not been added, so the writer may still be used or finished.
+ *
+ * @note Asserts:
+ * - That writer->entries is not NULL
+ * - That spiral_data.bytes is not NULL
+ */
+sxbp_status_t sxbp_archive_append(
+    sxbp_archive_writer_t* writer, sxbp_buffer_t spiral_data
+);
+
+/**
+ * @brief Completes an archive by writing its index, and frees the resources
+ * held by the archive writer.
+ * @details The resources are freed whether or not the index could be written.
+ *
+ * @param[in,out] writer The archive writer to finish.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the callback failed to write the index.
+ *
+ * @note Asserts:
+ * - That writer->entries is not NULL
+ */
+sxbp_status_t sxbp_finish_archive(sxbp_archive_writer_t* writer);
+
+/**
+ * @brief Opens an archive held in a buffer for reading.
+ * @details Only the header and footer of the archive are read, so this takes
+ * constant time regardless of the size of the archive. The buffer may be
+ * memory which the caller has mapped from a file.
+ *
+ * @param buffer The buffer holding the archive. Its bytes must remain valid
+ * for as long as the archive is used.
+ * @param[out] archive The archive to initialise.
+ * @return For information on return values, see the documentation of the return
+ * types.
+ *
+ * @note Asserts:
+ * - That buffer.bytes is not NULL
+ *
+ * @see sxbp_status_t for generic error return codes and
+ * sxbp_deserialise_diagnostic_t for file-specific error return codes.
+ */
+sxbp_serialise_result_t sxbp_open_archive(
+    sxbp_buffer_t buffer, sxbp_archive_t* archive
+);
+
+/**
+ * @brief Gets one of the serialised spirals stored in an archive.
+ * @details Entries are ordered by hash. This only reads from the archive, so
+ * it may be called from multiple threads at once, for example to process the
+ * spirals of an archive in parallel by splitting up the range of entries.
+ *
+ * @param archive The archive to read from.
+ * @param entry_index The index of the entry to get, less than archive->count.
+ * @param[out] spiral_data A buffer which is set to point to the serialised
+ * spiral within the archive's buffer. It must not be freed.
+ * @param[out] entry An optional pointer to a struct to write the index entry
+ * of the spiral to.
+ * @return For information on return values, see the documentation of the return
+ * types.
+ * @return A result with status SXBP_OPERATION_FAIL and diagnostic
+ * SXBP_DESERIALISE_BAD_DATA_SIZE if the entry lies outside of the archive.
+ *
+ * @note Asserts:
+ * - That entry_index is less than archive->count
+ */
+sxbp_serialise_result_t sxbp_archive_get(
+    const sxbp_archive_t* archive, uint32_t entry_index,
+    sxbp_buffer_t* spiral_data, sxbp_archive_entry_t* entry
+);
+
+/**
+ * @brief Finds a serialised spiral in an archive by its hash.
+ * @details This is a binary search of the archive's index, so takes time
+ * logarithmic in the number of spirals in the archive.
+ *
+ * @param archive The archive to search.
+ * @param hash The hash to find, as given by sxbp_hash_spiral_data().
+ * @param[out] spiral_data A buffer which is set to point to the serialised
+ * spiral within the archive's buffer. It must not be freed.
+ * @return A result with status SXBP_OPERATION_OK if the spiral was found.
+ * @return A result with status SXBP_OPERATION_FAIL and diagnostic
+ * SXBP_DESERIALISE_OK if no spiral with the given hash is in the archive.
+ * @return Any failure result which sxbp_archive_get() may return.
+ */
+sxbp_serialise_result_t sxbp_archive_find(
+    const sxbp_archive_t* archive, uint64_t hash, sxbp_buffer_t* spiral_data
+);
+
+/**
+ * @brief Calls a function for every serialised spiral stored in an archive.
+ * @details When the library is built with OpenMP support, the spirals are
+ * shared out between multiple threads, so the callback must be safe to call
+ * from multiple threads at once.
+ *
+ * @param archive The archive to read from.
+ * @param callback A function pointer with the following signature:
+ * @code
+ * sxbp_status_t callback_name(
+ *     sxbp_buffer_t spiral_data, uint32_t entry_index, void* user_data
+ * )
+ * @endcode
+ * It is given each serialised spiral in the archive along with its index, and
+ * should return SXBP_OPERATION_OK on success.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback.
+ * @return SXBP_OPERATION_OK if every call of the callback succeeded.
+ * @return SXBP_OPERATION_FAIL if an entry lies outside of the archive.
+ * @return Otherwise, a failure status returned by one of the calls of the
+ * callback. All spirals are still visited in this case.
+ *
+ * @note Asserts:
+ * - That callback is not NULL
+ */
+sxbp_status_t sxbp_archive_for_each(
+    const sxbp_archive_t* archive,
+    sxbp_status_t(* callback)(
+        sxbp_buffer_t spiral_data, uint32_t entry_index, void* user_data
+    ),
+    void* user_data
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+// end of header file
+#endif
@@ -0,0 +1,185 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ *
+ * Copyright (C) 2016, 2017, Joshua Saxby joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "saxbospiral.h"
+#include "file.h"
+#include "serialise.h"
+#include "solve.h"
+#include "checkpoint.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/*
+ * private type, used as the user data of the progress callback which
+ * sxbp_plot_spiral_checkpointed() gives to sxbp_plot_spiral(), so that it can
+ * write checkpoints and then forward progress on to the caller's own callback.
+ */
+typedef struct checkpoint_state_t {
+    sxbp_checkpoint_t checkpoint;
+    // solved_count of the spiral when the last checkpoint was written
+    uint32_t last_solved_count;
+    // wall-clock time when the last checkpoint was written
+    time_t last_time;
+    // status of the first failed checkpoint write, or SXBP_OPERATION_OK
+    sxbp_status_t status;
+    void(* progress_callback)(
+        sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+        void* progress_callback_user_data
+    );
+    void* progress_callback_user_data;
+} checkpoint_state_t;
+
+/*
+ * private function, writes a checkpoint of the spiral and updates the state
+ * to record when it was written and whether it was written successfully.
+ */
+static void write_checkpoint(
+    sxbp_spiral_t* spiral, checkpoint_state_t* state
+) {
+    sxbp_status_t result = sxbp_save_checkpoint(
+        *spiral, state->checkpoint.path
+    );
+    // only keep hold of the first error, later ones are likely the same
+    if(result != SXBP_OPERATION_OK && state->status == SXBP_OPERATION_OK) {
+        state->status = result;
+    }
+    state->last_solved_count = spiral->solved_count;
+    state->last_time = time(NULL);
+}
+
+/*
+ * private function, progress callback given to sxbp_plot_spiral() which
+ * writes a checkpoint whenever one of the configured intervals has elapsed.
+ */
+static void checkpoint_progress_callback(
+    sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+    void* progress_callback_user_data
+) {
+    checkpoint_state_t* state = (checkpoint_state_t*)progress_callback_user_data;
+    // check the cheap line count trigger first, and the clock only if needed
+    bool due = (
+        (state->checkpoint.line_interval != 0) &&
+        (
+            spiral->solved_count - state->last_solved_count >=
+            state->checkpoint.line_interval
+        )
+    );
+    if(!due && state->checkpoint.seconds_interval != 0) {
+        due = (
+            difftime(time(NULL), state->last_time) >=
+            (double)state->checkpoint.seconds_interval
+        );
+    }
+    if(due) {
+        write_checkpoint(spiral, state);
+    }
+    // forward progress on to the caller's callback if they gave one
+    if(state->progress_callback != NULL) {
+        state->progress_callback(
+            spiral, latest_line, target_line,
+            state->progress_callback_user_data
+        );
+    }
+}
+
+/*
+ * private function, writer for sxbp_write_file_atomic_with() which streams
+ * the spiral pointed to by user_data out to the file
+ */
+static sxbp_status_t write_spiral(FILE* file_handle, void* user_data) {
+    return sxbp_dump_spiral_stream(
+        *(sxbp_spiral_t*)user_data, sxbp_file_write_callback,
+        (void*)file_handle
+    ).status;
+}
+
+sxbp_status_t sxbp_save_checkpoint(sxbp_spiral_t spiral, const char* path) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(path != NULL);
+    // stream straight to the file to avoid a full in-memory copy of the spiral
+    return sxbp_write_file_atomic_with(path, write_spiral, (void*)&spiral);
+}
+
+sxbp_serialise_result_t sxbp_load_checkpoint(
+    const char* path, sxbp_spiral_t* spiral
+) {
+    // preconditional assertions
+    assert(path != NULL);
+    assert(spiral->lines == NULL);
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_FAIL, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    FILE* file_handle = fopen(path, "rb");
+    if(file_handle == NULL) {
+        return result;
+    }
+    result = sxbp_load_spiral_stream(
+        sxbp_file_read_callback, (void*)file_handle, spiral
+    );
+    fclose(file_handle);
+    // the compact and native formats can't be streamed, so read them whole
+    if(result.status == SXBP_NOT_IMPLEMENTED) {
+        sxbp_buffer_t buffer = { .bytes = NULL, .size = 0, };
+        result.status = sxbp_read_file(path, &buffer);
+        if(result.status == SXBP_OPERATION_OK) {
+            result = sxbp_load_spiral(buffer, spiral);
+            free(buffer.bytes);
+        }
+    }
+    return result;
+}
+
+sxbp_status_t sxbp_plot_spiral_checkpointed(
+    sxbp_spiral_t* spiral, sxbp_length_t perfection_threshold, uint32_t max_line,
+    sxbp_checkpoint_t checkpoint,
+    void(* progress_callback)(
+        sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+        void* progress_callback_user_data
+    ),
+    void* progress_callback_user_data
+) {
+    // preconditional assertions
+    assert(spiral->lines != NULL);
+    assert(checkpoint.path != NULL);
+    checkpoint_state_t state = {
+        .checkpoint = checkpoint,
+        .last_solved_count = spiral->solved_count,
+        .last_time = time(NULL),
+        .status = SXBP_OPERATION_OK,
+        .progress_callback = progress_callback,
+        .progress_callback_user_data = progress_callback_user_data,
+    };
+    sxbp_status_t result = sxbp_plot_spiral(
+        spiral, perfection_threshold, max_line,
+        checkpoint_progress_callback, (void*)&state
+    );
+    // errors from solving take priority over errors from checkpointing
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    // always leave a checkpoint of the finished state behind
+    write_checkpoint(spiral, &state);
+    return state.status;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
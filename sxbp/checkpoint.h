@@ -0,0 +1,143 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ */
+
+/**
+ * @file
+ *
+ * @brief This compilation unit provides functions for periodically saving the
+ * progress of a spiral being solved to a file, and for resuming from it.
+ *
+ * @author Joshua Saxby <joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ * @date 2016, 2017
+ *
+ * @copyright Copyright (C) Joshua Saxby 2016, 2017
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef SAXBOPHONE_SAXBOSPIRAL_CHECKPOINT_H
+#define SAXBOPHONE_SAXBOSPIRAL_CHECKPOINT_H
+
+#include <stdint.h>
+
+#include "saxbospiral.h"
+#include "serialise.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/**
+ * @brief Describes where and how often checkpoints should be written whilst
+ * solving a spiral.
+ * @details A checkpoint is written whenever either of the intervals has
+ * elapsed since the last one was written. Setting an interval to 0 disables
+ * that trigger. A final checkpoint is always written when solving finishes.
+ */
+typedef struct sxbp_checkpoint_t {
+    /** @brief path of the file to write checkpoints to */
+    const char* path;
+    /** @brief number of solved lines between checkpoints (0 to disable) */
+    uint32_t line_interval;
+    /**
+     * @brief number of wall-clock seconds between checkpoints (0 to disable)
+     * @note Unlike the `seconds_spent` field of sxbp_spiral_t, this is
+     * measured in real time, as it is intended to bound how much work can be
+     * lost if the process is killed.
+     */
+    uint32_t seconds_interval;
+} sxbp_checkpoint_t;
+
+/**
+ * @brief Writes a checkpoint of a spiral to a file.
+ * @details The spiral is serialised with sxbp_dump_spiral(), so the checkpoint
+ * file may be loaded with sxbp_load_spiral() like any other spiral file. The
+ * file is replaced atomically, so a checkpoint file is always either the
+ * previous complete checkpoint or the new complete one.
+ *
+ * @param spiral The spiral to checkpoint.
+ * @param path The path of the file to write the checkpoint to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the checkpoint file could not be written.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That path is not NULL
+ */
+sxbp_status_t sxbp_save_checkpoint(sxbp_spiral_t spiral, const char* path);
+
+/**
+ * @brief Loads a spiral from the latest checkpoint written to a file.
+ * @details Solving may be resumed by passing the loaded spiral to
+ * sxbp_plot_spiral() or sxbp_plot_spiral_checkpointed(), which will carry on
+ * from the spiral's `solved_count`.
+ * The file may be in any of the formats which sxbp_load_spiral() accepts.
+ * Files in the standard format are streamed in, others are read whole.
+ *
+ * @param path The path of the checkpoint file to load.
+ * @param[out] spiral The spiral to write the spiral data to.
+ * @return A result with status SXBP_OPERATION_OK on success.
+ * @return A result with status SXBP_OPERATION_FAIL and diagnostic
+ * SXBP_DESERIALISE_OK if the checkpoint file could not be read (for example,
+ * because no checkpoint has been written yet).
+ * @return Any result which sxbp_load_spiral() may return, if the checkpoint
+ * file could not be de-serialised.
+ *
+ * @note Asserts:
+ * - That path is not NULL
+ * - That spiral->lines is NULL
+ */
+sxbp_serialise_result_t sxbp_load_checkpoint(
+    const char* path, sxbp_spiral_t* spiral
+);
+
+/**
+ * @brief Solve the given incomplete spiral, periodically writing checkpoints
+ * of its progress to a file.
+ * @details This behaves identically to sxbp_plot_spiral(), except that
+ * checkpoints are written as described by the checkpoint parameter. If the
+ * process solving the spiral is killed, the work done up until the last
+ * checkpoint may be recovered with sxbp_load_checkpoint().
+ *
+ * @param[in,out] spiral The spiral to solve. Function operates on the spiral
+ * in-place (mutating operation).
+ * @param perfection_threshold The maximum line length of colliding lines at
+ * which aggressive optimisations are allowed (or 0 to disable these
+ * optimisations completely).
+ * @param max_line The index of the highest line to plot to.
+ * @param checkpoint Where and how often checkpoints should be written.
+ * @param progress_callback An optional progress callback, as accepted by
+ * sxbp_plot_spiral().
+ * @param progress_callback_user_data An optional void pointer to pass to the
+ * progress callback, as accepted by sxbp_plot_spiral().
+ * @return SXBP_OPERATION_OK on success.
+ * @return The status of the first checkpoint which could not be written, if
+ * any could not be. Solving still continues to completion in this case.
+ * @return Any other failure code which sxbp_plot_spiral() may return.
+ *
+ * @note Asserts:
+ * - That spiral->lines is not NULL
+ * - That checkpoint.path is not NULL
+ */
+sxbp_status_t sxbp_plot_spiral_checkpointed(
+    sxbp_spiral_t* spiral, sxbp_length_t perfection_threshold, uint32_t max_line,
+    sxbp_checkpoint_t checkpoint,
+    void(* progress_callback)(
+        sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+        void* progress_callback_user_data
+    ),
+    void* progress_callback_user_data
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+// end of header file
+#endif
@@ -0,0 +1,364 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ *
+ * Copyright (C) 2016, 2017, Joshua Saxby joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/*
+ * POSIX and Windows can both create a file only if it doesn't exist yet, which
+ * is how temporary files are made safely - the feature test macro is needed
+ * for open(), fdopen() and getpid() when building as strict C99
+ */
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__APPLE__) && defined(__MACH__))
+#define SXBP_POSIX_FILES
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#elif defined(_WIN32)
+#define SXBP_WINDOWS_FILES
+#endif
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(SXBP_POSIX_FILES)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(SXBP_WINDOWS_FILES)
+#include <errno.h>
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#endif
+
+#include "saxbospiral.h"
+#include "file.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+// how many different temporary file names to try before giving up
+#define SXBP_TEMPORARY_ATTEMPTS 64
+
+// counts temporary file names made by this process, so none are made twice
+static unsigned long temporary_count = 0;
+
+#ifndef SXBP_POSIX_FILES
+/*
+ * private function, returns true if a file exists at the given path, which is
+ * taken to be the case if it can be opened for reading
+ */
+static bool file_exists(const char* path) {
+    FILE* file_handle = fopen(path, "rb");
+    if(file_handle == NULL) {
+        return false;
+    }
+    fclose(file_handle);
+    return true;
+}
+#endif
+
+/*
+ * private function, returns the next value of temporary_count, atomically
+ * where the compiler allows it so that threads never get the same value
+ */
+static unsigned long next_temporary_count(void) {
+    #if defined(__GNUC__)
+    return __atomic_fetch_add(&temporary_count, 1, __ATOMIC_RELAXED);
+    #else
+    // files are still created exclusively, so a race only costs a retry
+    return temporary_count++;
+    #endif
+}
+
+/*
+ * private function, returns a number identifying this process, so that
+ * temporary file names made by different processes differ
+ */
+static unsigned long process_id(void) {
+    #if defined(SXBP_POSIX_FILES)
+    return (unsigned long)getpid();
+    #elif defined(SXBP_WINDOWS_FILES)
+    return (unsigned long)_getpid();
+    #else
+    // without process IDs, the time is the best that can be done
+    return (unsigned long)time(NULL);
+    #endif
+}
+
+/*
+ * private function, returns the size of the string needed to hold the path of
+ * a temporary file next to the given path, including the null-terminator
+ */
+static size_t temporary_path_size(const char* path) {
+    // ".", 2 names of up to 8 hex digits split by "-", ".tmp" and a null
+    return strlen(path) + 1 + 8 + 1 + 8 + 4 + 1;
+}
+
+/*
+ * private function, writes into result (of temporary_path_size() chars) the
+ * path of a temporary file next to the given one. This is the given path with
+ * the process ID, a count unique within the process and `.tmp` appended, so
+ * no two calls in any threads or processes give the same path.
+ */
+static void temporary_path(const char* path, char* result) {
+    snprintf(
+        result, temporary_path_size(path), "%s.%lx-%lx.tmp", path,
+        process_id() & 0xffffffffUL, next_temporary_count() & 0xffffffffUL
+    );
+}
+
+/*
+ * private function, creates and opens a file for writing in binary mode only
+ * if no file exists at path yet, checking and creating in one step wherever
+ * the platform allows. Returns NULL on failure, setting taken to whether it
+ * was because a file already exists at path.
+ */
+static FILE* create_file(const char* path, bool* taken) {
+    *taken = false;
+    #if defined(SXBP_POSIX_FILES)
+    int file_descriptor = open(path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if(file_descriptor < 0) {
+        *taken = (errno == EEXIST);
+        return NULL;
+    }
+    FILE* file_handle = fdopen(file_descriptor, "wb");
+    if(file_handle == NULL) {
+        close(file_descriptor);
+        remove(path);
+    }
+    return file_handle;
+    #elif defined(SXBP_WINDOWS_FILES)
+    int file_descriptor = _open(
+        path, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE
+    );
+    if(file_descriptor < 0) {
+        *taken = (errno == EEXIST);
+        return NULL;
+    }
+    FILE* file_handle = _fdopen(file_descriptor, "wb");
+    if(file_handle == NULL) {
+        _close(file_descriptor);
+        remove(path);
+    }
+    return file_handle;
+    #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    // C11 can open exclusively, failing if the file already exists
+    FILE* file_handle = fopen(path, "wbx");
+    if(file_handle == NULL) {
+        *taken = file_exists(path);
+    }
+    return file_handle;
+    #else
+    // elsewhere, the best that can be done is to check first
+    if(file_exists(path)) {
+        *taken = true;
+        return NULL;
+    }
+    return fopen(path, "wb");
+    #endif
+}
+
+/*
+ * private function, creates a new temporary file next to the given path and
+ * opens it for writing in binary mode, storing its handle in file_handle and
+ * its newly allocated path in temporary
+ */
+static sxbp_status_t open_temporary(
+    const char* path, char** temporary, FILE** file_handle
+) {
+    *temporary = malloc(temporary_path_size(path));
+    if(*temporary == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    for(size_t i = 0; i < SXBP_TEMPORARY_ATTEMPTS; i++) {
+        temporary_path(path, *temporary);
+        bool taken;
+        *file_handle = create_file(*temporary, &taken);
+        if(*file_handle != NULL) {
+            return SXBP_OPERATION_OK;
+        }
+        // only try again if the name was taken, not on other failures
+        if(!taken) {
+            break;
+        }
+    }
+    free(*temporary);
+    *temporary = NULL;
+    return SXBP_OPERATION_FAIL;
+}
+
+/*
+ * private function, renames the file at temporary over the one at path.
+ * On POSIX systems rename() replaces the destination atomically, so any
+ * failure is a real one. Some other platforms refuse to rename over an
+ * existing file, so there the destination is moved aside to another temporary
+ * path first and only removed once the new file is in its place. This
+ * fallback is not atomic, as nothing is at path for a moment, but the old data
+ * is put back if the new file can't be moved in.
+ */
+static bool replace_file(const char* temporary, const char* path) {
+    if(rename(temporary, path) == 0) {
+        return true;
+    }
+    #ifdef SXBP_POSIX_FILES
+    return false;
+    #else
+    // any failure other than the destination being there is a real one
+    if(!file_exists(path)) {
+        return false;
+    }
+    char* backup = malloc(temporary_path_size(path));
+    if(backup == NULL) {
+        return false;
+    }
+    bool success = false;
+    temporary_path(path, backup);
+    if(!file_exists(backup) && rename(path, backup) == 0) {
+        if(rename(temporary, path) == 0) {
+            remove(backup);
+            success = true;
+        } else {
+            // the old data must not be lost, so try to move it back
+            rename(backup, path);
+        }
+    }
+    free(backup);
+    return success;
+    #endif
+}
+
+sxbp_status_t sxbp_read_file(const char* path, sxbp_buffer_t* buffer) {
+    // preconditional assertions
+    assert(path != NULL);
+    assert(buffer->bytes == NULL);
+    FILE* file_handle = fopen(path, "rb");
+    if(file_handle == NULL) {
+        return SXBP_OPERATION_FAIL;
+    }
+    // seek to the end of the file to find out how big it is
+    if(fseek(file_handle, 0, SEEK_END) != 0) {
+        fclose(file_handle);
+        return SXBP_OPERATION_FAIL;
+    }
+    long file_size = ftell(file_handle);
+    if(file_size < 0 || fseek(file_handle, 0, SEEK_SET) != 0) {
+        fclose(file_handle);
+        return SXBP_OPERATION_FAIL;
+    }
+    buffer->size = (size_t)file_size;
+    // allocate at least one byte so that empty files still give a valid buffer
+    buffer->bytes = malloc(buffer->size > 0 ? buffer->size : 1);
+    if(buffer->bytes == NULL) {
+        fclose(file_handle);
+        return SXBP_MALLOC_REFUSED;
+    }
+    size_t bytes_read = fread(buffer->bytes, 1, buffer->size, file_handle);
+    fclose(file_handle);
+    // a short read means the file changed underneath us or could not be read
+    if(bytes_read != buffer->size) {
+        free(buffer->bytes);
+        buffer->bytes = NULL;
+        buffer->size = 0;
+        return SXBP_OPERATION_FAIL;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+/*
+ * private function, writer for sxbp_write_file_atomic_with() which writes out
+ * the whole of the sxbp_buffer_t pointed to by user_data
+ */
+static sxbp_status_t write_buffer(FILE* file_handle, void* user_data) {
+    sxbp_buffer_t* buffer = (sxbp_buffer_t*)user_data;
+    if(fwrite(buffer->bytes, 1, buffer->size, file_handle) != buffer->size) {
+        return SXBP_OPERATION_FAIL;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_write_file_atomic(sxbp_buffer_t buffer, const char* path) {
+    // preconditional assertions
+    assert(buffer.bytes != NULL);
+    assert(path != NULL);
+    return sxbp_write_file_atomic_with(path, write_buffer, (void*)&buffer);
+}
+
+sxbp_status_t sxbp_write_file_atomic_with(
+    const char* path,
+    sxbp_status_t(* writer)(FILE* file_handle, void* user_data),
+    void* user_data
+) {
+    // preconditional assertions
+    assert(path != NULL);
+    assert(writer != NULL);
+    char* temporary = NULL;
+    FILE* file_handle = NULL;
+    sxbp_status_t result = open_temporary(path, &temporary, &file_handle);
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    result = writer(file_handle, user_data);
+    // fclose() flushes, so a failure here also means the data isn't all there
+    if(fclose(file_handle) != 0 && result == SXBP_OPERATION_OK) {
+        result = SXBP_OPERATION_FAIL;
+    }
+    if(result != SXBP_OPERATION_OK) {
+        remove(temporary);
+        free(temporary);
+        return result;
+    }
+    /*
+     * the destination is never removed before the new data is in its place -
+     * if it can't be replaced, the complete temporary file is left behind so
+     * that neither copy of the data is lost
+     */
+    if(!replace_file(temporary, path)) {
+        free(temporary);
+        return SXBP_OPERATION_FAIL;
+    }
+    free(temporary);
+    return SXBP_OPERATION_OK;
+}
+
+size_t sxbp_file_read_callback(uint8_t* bytes, size_t size, void* file_handle) {
+    return fread(bytes, 1, size, (FILE*)file_handle);
+}
+
+size_t sxbp_file_read_at_callback(
+    uint8_t* bytes, size_t size, size_t offset, void* file_handle
+) {
+    // fseek() only takes a long, so offsets beyond it can't be reached
+    if(offset > (size_t)LONG_MAX) {
+        return 0;
+    }
+    if(fseek((FILE*)file_handle, (long)offset, SEEK_SET) != 0) {
+        return 0;
+    }
+    return fread(bytes, 1, size, (FILE*)file_handle);
+}
+
+size_t sxbp_file_write_callback(
+    const uint8_t* bytes, size_t size, void* file_handle
+) {
+    return fwrite(bytes, 1, size, (FILE*)file_handle);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,164 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ */
+
+/**
+ * @file
+ *
+ * @brief This compilation unit provides functions for reading and writing the
+ * contents of buffers to and from files.
+ *
+ * @author Joshua Saxby <joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ * @date 2016, 2017
+ *
+ * @copyright Copyright (C) Joshua Saxby 2016, 2017
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef SAXBOPHONE_SAXBOSPIRAL_FILE_H
+#define SAXBOPHONE_SAXBOSPIRAL_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "saxbospiral.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/**
+ * @brief Reads the entire contents of a file into a buffer.
+ *
+ * @param path The path of the file to read.
+ * @param[out] buffer The buffer to write the file's contents to. Memory for
+ * the buffer is allocated by this function.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the file could not be opened or read.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That path is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_read_file(const char* path, sxbp_buffer_t* buffer);
+
+/**
+ * @brief Atomically replaces the contents of a file with those of a buffer.
+ * @details The data is first written in full to a temporary file next to the
+ * destination (the destination path with the process ID, a count and `.tmp`
+ * appended), which is then renamed over the destination. The temporary file
+ * is only ever created if no file exists at its path yet, trying another name
+ * if one does, so writers to the same path in any threads or processes never
+ * share a temporary file. On POSIX systems this means that the destination file is
+ * never observed in a partially-written state, even if the process is killed
+ * part-way through writing.
+ * On platforms where a file can't be renamed over an existing one, the
+ * destination is first moved aside and only removed once the new file is in
+ * its place. This is not atomic, as there is briefly no file at the
+ * destination, but the old data is never lost.
+ * The destination is never removed if it can't be replaced. Instead, the
+ * complete temporary file is left next to it and SXBP_OPERATION_FAIL is
+ * returned.
+ *
+ * @param buffer The buffer containing the data to write.
+ * @param path The path of the file to write.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the file could not be written or renamed.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That buffer.bytes is not NULL
+ * - That path is not NULL
+ */
+sxbp_status_t sxbp_write_file_atomic(sxbp_buffer_t buffer, const char* path);
+
+/**
+ * @brief Atomically replaces the contents of a file with data written by a
+ * callback.
+ * @details This works in the same way as sxbp_write_file_atomic(), except
+ * that the data is written to the temporary file by the given callback, so it
+ * does not need to be held in memory all at once.
+ *
+ * @param path The path of the file to write.
+ * @param writer A function pointer with the following signature:
+ * @code
+ * sxbp_status_t callback_name(FILE* file_handle, void* user_data)
+ * @endcode
+ * It should write the data to the given file handle, which is open for
+ * writing in binary mode, and return SXBP_OPERATION_OK on success or any
+ * other status on failure, in which case the destination is left untouched.
+ * @param user_data An optional void pointer which is passed on to the writer.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the file could not be written or renamed.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ * @return Any other status which the writer returned.
+ *
+ * @note Asserts:
+ * - That path is not NULL
+ * - That writer is not NULL
+ */
+sxbp_status_t sxbp_write_file_atomic_with(
+    const char* path,
+    sxbp_status_t(* writer)(FILE* file_handle, void* user_data),
+    void* user_data
+);
+
+/**
+ * @brief A read callback for the streaming functions of the library, which
+ * reads from a file.
+ * @details For example, to load a spiral from an open file:
+ * @code
+ * sxbp_load_spiral_stream(sxbp_file_read_callback, file_handle, &spiral);
+ * @endcode
+ *
+ * @param[out] bytes The array to read bytes into.
+ * @param size The maximum number of bytes to read.
+ * @param file_handle A FILE pointer, opened for reading in binary mode.
+ * @return The number of bytes read, 0 at the end of the file or on error.
+ */
+size_t sxbp_file_read_callback(uint8_t* bytes, size_t size, void* file_handle);
+
+/**
+ * @brief A read callback for the functions of the library which read from
+ * arbitrary offsets, which reads from a file.
+ * @details For example, to index a spiral stored in an open file:
+ * @code
+ * sxbp_index_spiral(sxbp_file_read_at_callback, file_handle, &index);
+ * @endcode
+ *
+ * @param[out] bytes The array to read bytes into.
+ * @param size The maximum number of bytes to read.
+ * @param offset The offset from the start of the file to read from.
+ * @param file_handle A FILE pointer, opened for reading in binary mode.
+ * @return The number of bytes read, 0 at the end of the file or on error.
+ */
+size_t sxbp_file_read_at_callback(
+    uint8_t* bytes, size_t size, size_t offset, void* file_handle
+);
+
+/**
+ * @brief A write callback for the streaming functions of the library, which
+ * writes to a file.
+ *
+ * @param bytes The bytes to write.
+ * @param size The number of bytes to write.
+ * @param file_handle A FILE pointer, opened for writing in binary mode.
+ * @return The number of bytes written, which is less than size on error.
+ */
+size_t sxbp_file_write_callback(
+    const uint8_t* bytes, size_t size, void* file_handle
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+// end of header file
+#endif
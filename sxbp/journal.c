@@ -0,0 +1,346 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ *
+ * Copyright (C) 2016, 2017, Joshua Saxby joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "saxbospiral.h"
+#include "checkpoint.h"
+#include "file.h"
+#include "initialise.h"
+#include "serialise.h"
+#include "journal.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+// constants related to how journals are packed in files - measured in bytes
+const size_t SXBP_JOURNAL_HEADER_SIZE = (
+    4 + // 'sxbj' file magic number
+    6 + // file version, 3x 16-bit uints
+    4 // total number of lines of the journalled spiral, 32 bit uint
+);
+/*
+ * the size of the fixed part of each record, which is followed by 'count'
+ * 32-bit line lengths
+ */
+static const size_t JOURNAL_RECORD_HEADER_SIZE = (
+    4 + // number of lines solved, 32 bit uint
+    4 + // number of seconds spent solving, 32 bit uint
+    4 + // number of seconds accuracy of solve time, 32 bit uint
+    4 + // index of the first line length in this record, 32 bit uint
+    4 // count of line lengths in this record, 32 bit uint
+);
+
+/*
+ * NOTE: Like the spiral file format, journals use big-endian representation
+ * for all of their integers.
+ */
+
+// loads a 32-bit unsigned integer from bytes starting at given index
+static uint32_t load_uint32_t(const uint8_t* bytes, size_t start_index) {
+    return (
+        ((uint32_t)bytes[start_index] << 24) |
+        ((uint32_t)bytes[start_index + 1] << 16) |
+        ((uint32_t)bytes[start_index + 2] << 8) |
+        (uint32_t)bytes[start_index + 3]
+    );
+}
+
+// dumps a 32-bit unsigned integer of value to bytes at given index
+static void dump_uint32_t(uint32_t value, uint8_t* bytes, size_t start_index) {
+    bytes[start_index] = (uint8_t)(value >> 24);
+    bytes[start_index + 1] = (uint8_t)(value >> 16);
+    bytes[start_index + 2] = (uint8_t)(value >> 8);
+    bytes[start_index + 3] = (uint8_t)value;
+}
+
+// writes a 32-bit unsigned integer to a file, returns whether it succeeded
+static bool write_uint32_t(uint32_t value, FILE* file_handle) {
+    uint8_t bytes[4];
+    dump_uint32_t(value, bytes, 0);
+    return fwrite(bytes, 1, 4, file_handle) == 4;
+}
+
+/*
+ * private function, builds the header of a new journal for a spiral of the
+ * given size into the given array, which must be SXBP_JOURNAL_HEADER_SIZE long
+ */
+static void build_journal_header(uint32_t spiral_size, uint8_t* header) {
+    memcpy(header, "sxbj", 4);
+    header[4] = (uint8_t)(LIB_SXBP_VERSION.major >> 8);
+    header[5] = (uint8_t)(LIB_SXBP_VERSION.major % 256);
+    header[6] = (uint8_t)(LIB_SXBP_VERSION.minor >> 8);
+    header[7] = (uint8_t)(LIB_SXBP_VERSION.minor % 256);
+    header[8] = (uint8_t)(LIB_SXBP_VERSION.patch >> 8);
+    header[9] = (uint8_t)(LIB_SXBP_VERSION.patch % 256);
+    dump_uint32_t(spiral_size, header, 10);
+}
+
+sxbp_status_t sxbp_open_journal(
+    const char* path, sxbp_spiral_t spiral, sxbp_journal_t* journal
+) {
+    // preconditional assertions
+    assert(path != NULL);
+    assert(spiral.lines != NULL);
+    assert(journal->file == NULL);
+    // open for reading (to check an existing journal) and appending
+    FILE* file_handle = fopen(path, "a+b");
+    if(file_handle == NULL) {
+        return SXBP_OPERATION_FAIL;
+    }
+    uint8_t header[14];
+    if(fseek(file_handle, 0, SEEK_END) != 0) {
+        fclose(file_handle);
+        return SXBP_OPERATION_FAIL;
+    }
+    if(ftell(file_handle) == 0) {
+        // new journal, write the header
+        build_journal_header(spiral.size, header);
+        if(
+            fwrite(header, 1, SXBP_JOURNAL_HEADER_SIZE, file_handle) !=
+            SXBP_JOURNAL_HEADER_SIZE || fflush(file_handle) != 0
+        ) {
+            fclose(file_handle);
+            return SXBP_OPERATION_FAIL;
+        }
+    } else {
+        // existing journal, refuse to append to it if it's for another spiral
+        if(
+            fseek(file_handle, 0, SEEK_SET) != 0 ||
+            fread(header, 1, SXBP_JOURNAL_HEADER_SIZE, file_handle) !=
+            SXBP_JOURNAL_HEADER_SIZE ||
+            memcmp(header, "sxbj", 4) != 0 ||
+            load_uint32_t(header, 10) != spiral.size ||
+            // switching from reading to writing requires a seek
+            fseek(file_handle, 0, SEEK_END) != 0
+        ) {
+            fclose(file_handle);
+            return SXBP_OPERATION_FAIL;
+        }
+    }
+    // take a copy of the current line lengths to compare against on commit
+    journal->lengths = calloc(sizeof(sxbp_length_t), spiral.size);
+    if(journal->lengths == NULL) {
+        fclose(file_handle);
+        return SXBP_MALLOC_REFUSED;
+    }
+    for(uint32_t i = 0; i < spiral.size; i++) {
+        journal->lengths[i] = spiral.lines[i].length;
+    }
+    journal->file = file_handle;
+    journal->size = spiral.size;
+    journal->solved_count = spiral.solved_count;
+    journal->status = SXBP_OPERATION_OK;
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_journal_commit(
+    sxbp_journal_t* journal, sxbp_spiral_t spiral
+) {
+    // preconditional assertions
+    assert(journal->file != NULL);
+    assert(spiral.lines != NULL);
+    assert(spiral.size == journal->size);
+    /*
+     * once a write has failed, the journal may end with part of a record, so
+     * appending any more records after it would make it unreadable
+     */
+    if(journal->status != SXBP_OPERATION_OK) {
+        return journal->status;
+    }
+    /*
+     * solving never changes the lines beyond the solved count, so the last
+     * line which can have changed is the last one solved now or at the last
+     * commit, whichever is the greater
+     */
+    uint32_t limit = (
+        (journal->solved_count > spiral.solved_count) ?
+        journal->solved_count : spiral.solved_count
+    );
+    if(limit > spiral.size) {
+        limit = spiral.size;
+    }
+    // find the range of lines which have changed since the last commit
+    uint32_t start = 0;
+    while(
+        (start < limit) &&
+        (journal->lengths[start] == spiral.lines[start].length)
+    ) {
+        start++;
+    }
+    uint32_t end = limit;
+    while(
+        (end > start) &&
+        (journal->lengths[end - 1] == spiral.lines[end - 1].length)
+    ) {
+        end--;
+    }
+    // if nothing changed, this record only updates the metadata
+    if(start == end) {
+        start = 0;
+        end = 0;
+    }
+    bool ok = (
+        write_uint32_t(spiral.solved_count, journal->file) &&
+        write_uint32_t(spiral.seconds_spent, journal->file) &&
+        write_uint32_t(spiral.seconds_accuracy, journal->file) &&
+        write_uint32_t(start, journal->file) &&
+        write_uint32_t(end - start, journal->file)
+    );
+    for(uint32_t i = start; ok && i < end; i++) {
+        ok = write_uint32_t(spiral.lines[i].length, journal->file);
+    }
+    // flush so the record reaches the file even if the process is killed
+    if(!ok || fflush(journal->file) != 0) {
+        journal->status = SXBP_OPERATION_FAIL;
+        return journal->status;
+    }
+    // the record is written, so remember the lengths it holds
+    for(uint32_t i = start; i < end; i++) {
+        journal->lengths[i] = spiral.lines[i].length;
+    }
+    journal->solved_count = spiral.solved_count;
+    return SXBP_OPERATION_OK;
+}
+
+/*
+ * disable GCC warning about the unused parameters as this function by necessity
+ * requires these arguments in its signature, but it needn't use all of them.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+void sxbp_journal_progress_callback(
+    sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+    void* progress_callback_user_data
+) {
+    // any failure is remembered in the journal's status field
+    sxbp_journal_commit((sxbp_journal_t*)progress_callback_user_data, *spiral);
+}
+// re-enable all warnings
+#pragma GCC diagnostic pop
+
+sxbp_status_t sxbp_close_journal(sxbp_journal_t* journal) {
+    // preconditional assertions
+    assert(journal->file != NULL);
+    sxbp_status_t result = journal->status;
+    if(fclose(journal->file) != 0 && result == SXBP_OPERATION_OK) {
+        result = SXBP_OPERATION_FAIL;
+    }
+    free(journal->lengths);
+    journal->file = NULL;
+    journal->lengths = NULL;
+    return result;
+}
+
+sxbp_serialise_result_t sxbp_replay_journal(
+    sxbp_buffer_t journal, sxbp_spiral_t* spiral
+) {
+    // preconditional assertions
+    assert(journal.bytes != NULL);
+    assert(spiral->lines != NULL);
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_FAIL, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    if(journal.size < SXBP_JOURNAL_HEADER_SIZE) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_HEADER_SIZE;
+        return result;
+    }
+    if(memcmp(journal.bytes, "sxbj", 4) != 0) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_MAGIC_NUMBER;
+        return result;
+    }
+    sxbp_version_t journal_version = {
+        .major = (uint16_t)((journal.bytes[4] << 8) | journal.bytes[5]),
+        .minor = (uint16_t)((journal.bytes[6] << 8) | journal.bytes[7]),
+        .patch = (uint16_t)((journal.bytes[8] << 8) | journal.bytes[9]),
+    };
+    // journals were introduced in v0.27.0
+    sxbp_version_t min_version = { .major = 0, .minor = 27, .patch = 0, };
+    if(sxbp_version_less_than(journal_version, min_version)) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_VERSION;
+        return result;
+    }
+    // a journal can only be replayed onto the spiral it was started from
+    if(load_uint32_t(journal.bytes, 10) != spiral->size) {
+        result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE;
+        return result;
+    }
+    size_t index = SXBP_JOURNAL_HEADER_SIZE;
+    // apply every complete record, stopping at a torn one (if any)
+    while(journal.size - index >= JOURNAL_RECORD_HEADER_SIZE) {
+        uint32_t start = load_uint32_t(journal.bytes, index + 12);
+        uint32_t count = load_uint32_t(journal.bytes, index + 16);
+        if(start > spiral->size || count > spiral->size - start) {
+            result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE;
+            return result;
+        }
+        size_t record_size = JOURNAL_RECORD_HEADER_SIZE + (4 * (size_t)count);
+        if(journal.size - index < record_size) {
+            break;
+        }
+        spiral->solved_count = load_uint32_t(journal.bytes, index);
+        spiral->seconds_spent = load_uint32_t(journal.bytes, index + 4);
+        spiral->seconds_accuracy = load_uint32_t(journal.bytes, index + 8);
+        index += JOURNAL_RECORD_HEADER_SIZE;
+        for(uint32_t i = start; i < start + count; i++) {
+            spiral->lines[i].length = load_uint32_t(journal.bytes, index);
+            index += 4;
+        }
+    }
+    // the lengths of some lines may have changed, so cached co-ords are stale
+    spiral->co_ord_cache.validity = 0;
+    result.status = SXBP_OPERATION_OK;
+    return result;
+}
+
+sxbp_serialise_result_t sxbp_compact_journal(
+    const char* spiral_path, const char* journal_path
+) {
+    // preconditional assertions
+    assert(spiral_path != NULL);
+    assert(journal_path != NULL);
+    sxbp_spiral_t spiral = sxbp_blank_spiral();
+    sxbp_buffer_t journal = { .bytes = NULL, .size = 0, };
+    sxbp_serialise_result_t result = sxbp_load_checkpoint(spiral_path, &spiral);
+    if(result.status != SXBP_OPERATION_OK) {
+        return result;
+    }
+    result.status = sxbp_read_file(journal_path, &journal);
+    if(result.status == SXBP_OPERATION_OK) {
+        result = sxbp_replay_journal(journal, &spiral);
+        free(journal.bytes);
+    }
+    if(result.status == SXBP_OPERATION_OK) {
+        result.status = sxbp_save_checkpoint(spiral, spiral_path);
+    }
+    if(result.status == SXBP_OPERATION_OK) {
+        // the base is up to date, so start the journal afresh
+        uint8_t header[14];
+        build_journal_header(spiral.size, header);
+        sxbp_buffer_t empty_journal = {
+            .bytes = header, .size = SXBP_JOURNAL_HEADER_SIZE,
+        };
+        result.status = sxbp_write_file_atomic(empty_journal, journal_path);
+    }
+    free(spiral.lines);
+    return result;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
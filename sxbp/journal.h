@@ -0,0 +1,223 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ */
+
+/**
+ * @file
+ *
+ * @brief This compilation unit provides an append-only journal file format
+ * for incrementally persisting the progress of a spiral being solved.
+ *
+ * @details Rather than re-serialising the whole spiral each time progress is
+ * saved, only the line lengths which have changed since the last save are
+ * appended to the journal. A journal is replayed onto the spiral file it was
+ * started from (its 'base') to recover the latest progress, and may be
+ * compacted back into the base file to stop it growing without bound.
+ *
+ * @author Joshua Saxby <joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ * @date 2016, 2017
+ *
+ * @copyright Copyright (C) Joshua Saxby 2016, 2017
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef SAXBOPHONE_SAXBOSPIRAL_JOURNAL_H
+#define SAXBOPHONE_SAXBOSPIRAL_JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "saxbospiral.h"
+#include "serialise.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/**
+ * @brief An open journal file which spiral progress is appended to.
+ * @details All fields are private, a journal should only be manipulated with
+ * the functions in this compilation unit.
+ */
+typedef struct sxbp_journal_t {
+    /**
+     * @brief the file handle which records are appended to
+     * @private
+     */
+    FILE* file;
+    /**
+     * @brief the line lengths as of the last record appended to the journal
+     * @private
+     */
+    sxbp_length_t* lengths;
+    /**
+     * @brief the count of lines in the spiral being journalled
+     * @private
+     */
+    uint32_t size;
+    /**
+     * @brief the solved count of the spiral as of the last record appended to
+     * the journal
+     * @private
+     */
+    uint32_t solved_count;
+    /**
+     * @brief the status of the first failed commit, if any
+     * @private
+     */
+    sxbp_status_t status;
+} sxbp_journal_t;
+
+/** @brief The size of the journal file header in bytes */
+extern const size_t SXBP_JOURNAL_HEADER_SIZE;
+
+/**
+ * @brief Opens a journal file for appending the progress of a spiral to.
+ * @details If the journal file does not exist or is empty, a new journal is
+ * started. Otherwise, records are appended to the existing journal.
+ *
+ * @param path The path of the journal file.
+ * @param spiral The spiral which is to be journalled. This should be in the
+ * state described by the base spiral file with any existing journal replayed
+ * onto it, as only subsequent changes are recorded.
+ * @param[out] journal The journal to initialise.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the journal file could not be opened.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That path is not NULL
+ * - That spiral.lines is not NULL
+ * - That journal->file is NULL
+ */
+sxbp_status_t sxbp_open_journal(
+    const char* path, sxbp_spiral_t spiral, sxbp_journal_t* journal
+);
+
+/**
+ * @brief Appends any progress made on a spiral since the last commit to its
+ * journal.
+ * @details One record is appended holding the spiral's solve metadata and the
+ * range of line lengths which have changed (including any lines re-sized by
+ * backtracking). The journal file is flushed after every record.
+ * Only lines up to the greater of the spiral's solved count and its solved
+ * count at the last commit are checked for changes, as solving never changes
+ * the lines beyond these. Finding the changed lines then takes time
+ * proportional to the index of the first changed line plus the number of
+ * lines from there to the end of the solved range. When solving without
+ * backtracking, the first changed line is the one just solved, so a commit
+ * after every line (as made by sxbp_journal_progress_callback()) still checks
+ * every solved line each time, and journalling a whole solve this way takes
+ * time quadratic in the spiral's size. Committing less often reduces this.
+ *
+ * @param[in,out] journal The journal to append to.
+ * @param spiral The spiral which the journal was opened for.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the record could not be written.
+ *
+ * @note Asserts:
+ * - That journal->file is not NULL
+ * - That spiral.lines is not NULL
+ * - That spiral.size is the size of the spiral the journal was opened for
+ */
+sxbp_status_t sxbp_journal_commit(
+    sxbp_journal_t* journal, sxbp_spiral_t spiral
+);
+
+/**
+ * @brief A progress callback which commits progress to a journal.
+ * @details This may be passed directly as the progress callback of
+ * sxbp_plot_spiral(), with a pointer to an open sxbp_journal_t as the user
+ * data, to journal every line as it is solved:
+ * @code
+ * sxbp_plot_spiral(
+ *     &spiral, 1, spiral.size, sxbp_journal_progress_callback, &journal
+ * );
+ * @endcode
+ * As a callback cannot return errors, the first failed commit is remembered
+ * and returned by sxbp_close_journal().
+ *
+ * @param spiral The spiral being solved.
+ * @param latest_line The index of the latest line to be solved.
+ * @param target_line The index of the highest line that will be solved.
+ * @param progress_callback_user_data A pointer to the sxbp_journal_t to commit
+ * progress to.
+ */
+void sxbp_journal_progress_callback(
+    sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+    void* progress_callback_user_data
+);
+
+/**
+ * @brief Closes a journal and frees the resources held by it.
+ *
+ * @param[in,out] journal The journal to close.
+ * @return SXBP_OPERATION_OK on success.
+ * @return The status of the first commit which failed, if any did.
+ * @return SXBP_OPERATION_FAIL if the journal file could not be closed.
+ *
+ * @note Asserts:
+ * - That journal->file is not NULL
+ */
+sxbp_status_t sxbp_close_journal(sxbp_journal_t* journal);
+
+/**
+ * @brief Replays the records of a journal onto a spiral.
+ * @details The spiral should have been loaded from the base spiral file the
+ * journal was started from. Records hold absolute line lengths, so replaying
+ * a journal onto a base which it has already been compacted into is harmless.
+ * An incomplete record at the end of the journal (as left behind if the
+ * process writing it was killed part-way through a write) is ignored.
+ *
+ * @param journal A buffer containing the contents of the journal file.
+ * @param[in,out] spiral The spiral to apply the journalled progress to.
+ * @return For information on return values, see the documentation of the return
+ * types.
+ *
+ * @note Asserts:
+ * - That journal.bytes is not NULL
+ * - That spiral->lines is not NULL
+ *
+ * @see sxbp_status_t for generic error return codes and
+ * sxbp_deserialise_diagnostic_t for file-specific error return codes.
+ */
+sxbp_serialise_result_t sxbp_replay_journal(
+    sxbp_buffer_t journal, sxbp_spiral_t* spiral
+);
+
+/**
+ * @brief Folds the progress recorded in a journal back into its base spiral
+ * file and empties the journal.
+ * @details The base spiral file is replaced atomically. Should the process be
+ * killed before the journal is emptied, replaying the journal again onto the
+ * new base gives the same result.
+ *
+ * @param spiral_path The path of the base spiral file.
+ * @param journal_path The path of the journal file.
+ * @return For information on return values, see the documentation of the return
+ * types.
+ * @return A result with status SXBP_OPERATION_FAIL and diagnostic
+ * SXBP_DESERIALISE_OK if either file could not be read or written.
+ *
+ * @note Asserts:
+ * - That spiral_path is not NULL
+ * - That journal_path is not NULL
+ *
+ * @warning The journal must not be open for appending whilst it is compacted.
+ */
+sxbp_serialise_result_t sxbp_compact_journal(
+    const char* spiral_path, const char* journal_path
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+// end of header file
+#endif
@@ -9,6 +9,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "saxbospiral.h"
@@ -75,54 +76,98 @@ sxbp_status_t sxbp_spiral_points(
     return result;
 }
 
+/*
+ * private function, widens the bounds kept in a co-ord cache to take in the
+ * cached co-ords from index start up to but not including index end
+ */
+static void extend_cache_bounds(
+    sxbp_co_ord_cache_t* cache, size_t start, size_t end
+) {
+    for(size_t i = start; i < end; i++) {
+        sxbp_co_ord_t point = cache->co_ords.items[i];
+        if(point.x < cache->bounds[0].x) {
+            cache->bounds[0].x = point.x;
+            cache->extremes[0] = i;
+        }
+        if(point.y < cache->bounds[0].y) {
+            cache->bounds[0].y = point.y;
+            cache->extremes[1] = i;
+        }
+        if(point.x > cache->bounds[1].x) {
+            cache->bounds[1].x = point.x;
+            cache->extremes[2] = i;
+        }
+        if(point.y > cache->bounds[1].y) {
+            cache->bounds[1].y = point.y;
+            cache->extremes[3] = i;
+        }
+    }
+}
+
 sxbp_status_t sxbp_cache_spiral_points(sxbp_spiral_t* spiral, size_t limit) {
     // preconditional assertions
     assert(spiral->lines != NULL);
     assert(limit <= spiral->size);
     // prepare result status
     sxbp_status_t result;
-    // the amount of space needed is the sum of all line lengths + 1 for end
-    size_t size = sxbp_sum_lines(*spiral, 0, limit) + 1;
+    sxbp_co_ord_cache_t* cache = &spiral->co_ord_cache;
+    /*
+     * if we're not going to re-calculate the whole array, skip forward the
+     * index. find the smallest of limit and the spirals' cache validity
+     */
+    size_t smallest = (limit < cache->validity) ? limit : cache->validity;
+    // get index of the latest known co-ord (or 0 if none are known)
+    size_t result_index = sxbp_sum_lines(*spiral, 0, smallest);
+    /*
+     * the amount of space needed is the sum of all line lengths + 1 for end,
+     * the lines before the latest known co-ord have already been summed
+     */
+    size_t size = result_index + sxbp_sum_lines(*spiral, smallest, limit) + 1;
     // allocate / reallocate memory
-    if(spiral->co_ord_cache.co_ords.items == NULL) {
+    if(cache->co_ords.items == NULL) {
         /*
          * if no memory has been allocated for the co-ords yet, then do this now
          * allocate enough memory to store these
          */
-        spiral->co_ord_cache.co_ords.items = calloc(
-            sizeof(sxbp_co_ord_t), size
-        );
-    } else if(spiral->co_ord_cache.co_ords.size != size) {
+        cache->co_ords.items = calloc(sizeof(sxbp_co_ord_t), size);
+    } else if(cache->co_ords.size != size) {
         // if there isn't enough memory allocated, re-allocate memory instead
-        spiral->co_ord_cache.co_ords.items = realloc(
-            spiral->co_ord_cache.co_ords.items, sizeof(sxbp_co_ord_t) * size
+        cache->co_ords.items = realloc(
+            cache->co_ords.items, sizeof(sxbp_co_ord_t) * size
         );
     }
     // catch malloc failure
-    if(spiral->co_ord_cache.co_ords.items == NULL) {
+    if(cache->co_ords.items == NULL) {
         // set error information then early return
         result = SXBP_MALLOC_REFUSED;
         return result;
     }
-    spiral->co_ord_cache.co_ords.size = size;
+    cache->co_ords.size = size;
     // start at (0, 0) as origin
     sxbp_co_ord_t current = { 0, 0, };
-    size_t result_index = 0; // maintain independent index for co-ords array
-    /*
-     * if we're not going to re-calculate the whole array, skip forward the
-     * index. find the smallest of limit and the spirals' cache validity
-     */
-    size_t smallest = (
-        limit < spiral->co_ord_cache.validity
-    ) ? limit : spiral->co_ord_cache.validity;
-    if(spiral->co_ord_cache.validity != 0) {
-        // get index of the latest known co-ord
-        result_index += sxbp_sum_lines(*spiral, 0, smallest);
+    if(cache->validity != 0) {
         // update current to be at latest known co-ord
-        current = spiral->co_ord_cache.co_ords.items[result_index];
+        current = cache->co_ords.items[result_index];
     } else {
         // otherwise, start at 0
-        spiral->co_ord_cache.co_ords.items[0] = current;
+        cache->co_ords.items[0] = current;
+    }
+    /*
+     * the bounds of the known co-ords only need finding again from scratch if
+     * the co-ords being replaced reached any of them, otherwise they stay
+     */
+    if(
+        (cache->validity == 0) ||
+        (cache->extremes[0] > result_index) ||
+        (cache->extremes[1] > result_index) ||
+        (cache->extremes[2] > result_index) ||
+        (cache->extremes[3] > result_index)
+    ) {
+        cache->bounds[0] = cache->bounds[1] = cache->co_ords.items[0];
+        for(size_t i = 0; i < 4; i++) {
+            cache->extremes[i] = 0;
+        }
+        extend_cache_bounds(cache, 1, result_index + 1);
     }
     // calculate the missing co-ords
     sxbp_co_ord_array_t missing= {0, 0};
@@ -135,21 +180,62 @@ sxbp_status_t sxbp_cache_spiral_points(sxbp_spiral_t* spiral, size_t limit) {
     }
     // add the missing co-ords to the cache
     for(size_t i = result_index; i < size; i++) {
-        spiral->co_ord_cache.co_ords.items[i] = missing.items[i-result_index];
+        cache->co_ords.items[i] = missing.items[i-result_index];
     }
+    // and take them into the bounds
+    extend_cache_bounds(cache, result_index + 1, size);
     // free dynamically allocated memory, if any was allocated
     if(missing.items != NULL) {
         free(missing.items);
     }
-    // set validity to the largest of limit and current validity
-    spiral->co_ord_cache.validity = (
-        limit > spiral->co_ord_cache.validity
-    ) ? limit : spiral->co_ord_cache.validity;
+    // the cache now holds exactly the co-ords up to limit
+    cache->validity = limit;
     // return ok
     result = SXBP_OPERATION_OK;
     return result;
 }
 
+sxbp_spiral_stats_t sxbp_spiral_stats(sxbp_spiral_t spiral) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    sxbp_spiral_stats_t stats = { .length = 0, };
+    if(
+        (spiral.co_ord_cache.co_ords.items != NULL) &&
+        (spiral.co_ord_cache.validity == spiral.size)
+    ) {
+        // the cache already covers the whole spiral
+        stats.length = spiral.co_ord_cache.co_ords.size - 1;
+        stats.min = spiral.co_ord_cache.bounds[0];
+        stats.max = spiral.co_ord_cache.bounds[1];
+    } else {
+        // the extremes of the spiral are always found at the ends of its lines
+        int64_t x = 0, y = 0, min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+        for(size_t i = 0; i < spiral.size; i++) {
+            sxbp_vector_t direction = SXBP_VECTOR_DIRECTIONS[spiral.lines[i].direction];
+            x += direction.x * (int64_t)spiral.lines[i].length;
+            y += direction.y * (int64_t)spiral.lines[i].length;
+            min_x = (x < min_x) ? x : min_x;
+            min_y = (y < min_y) ? y : min_y;
+            max_x = (x > max_x) ? x : max_x;
+            max_y = (y > max_y) ? y : max_y;
+            stats.length += spiral.lines[i].length;
+        }
+        stats.min.x = (sxbp_tuple_item_t)min_x;
+        stats.min.y = (sxbp_tuple_item_t)min_y;
+        stats.max.x = (sxbp_tuple_item_t)max_x;
+        stats.max.y = (sxbp_tuple_item_t)max_y;
+    }
+    stats.points = stats.length + 1;
+    // image dimensions are twice the size + 1, with a 1 pixel border
+    stats.width = (uint32_t)(
+        (((int64_t)stats.max.x - stats.min.x) * 2) + 3
+    );
+    stats.height = (uint32_t)(
+        (((int64_t)stats.max.y - stats.min.y) * 2) + 3
+    );
+    return stats;
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
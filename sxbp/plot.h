@@ -23,6 +23,7 @@
 #define SAXBOPHONE_SAXBOSPIRAL_PLOT_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "saxbospiral.h"
 
@@ -31,6 +32,27 @@
 extern "C"{
 #endif
 
+/**
+ * @brief Aggregate figures describing the size and shape of a spiral.
+ */
+typedef struct sxbp_spiral_stats_t {
+    /** @brief The sum of the lengths of all the lines of the spiral */
+    size_t length;
+    /**
+     * @brief The number of co-ords the line of the spiral passes through,
+     * including both of its ends, which is one more than its length
+     */
+    size_t points;
+    /** @brief The smallest x and y co-ords reached by the spiral */
+    sxbp_co_ord_t min;
+    /** @brief The largest x and y co-ords reached by the spiral */
+    sxbp_co_ord_t max;
+    /** @brief The width in pixels of the image rendered from the spiral */
+    uint32_t width;
+    /** @brief The height in pixels of the image rendered from the spiral */
+    uint32_t height;
+} sxbp_spiral_stats_t;
+
 /**
  * @brief Calculates the sum of all line lengths in this spiral within the given
  * start and end indexes.
@@ -108,6 +130,26 @@ sxbp_status_t sxbp_spiral_points(
  */
 sxbp_status_t sxbp_cache_spiral_points(sxbp_spiral_t* spiral, size_t limit);
 
+/**
+ * @brief Gives the total length, bounding box and image dimensions of a
+ * spiral.
+ * @details If the co-ord cache of the spiral is valid for all of its lines,
+ * which it is once the spiral has been fully solved, the figures are read from
+ * the bounds maintained by sxbp_cache_spiral_points() in constant time.
+ * Otherwise, they are found by walking the ends of the lines of the spiral,
+ * which takes time proportional to the number of lines. Either way, the spiral
+ * is never modified and no memory is allocated, so this may be used to find
+ * the dimensions of the image of a spiral before deciding how to render it,
+ * from multiple threads at once.
+ *
+ * @param spiral The spiral to describe.
+ * @return The figures describing the spiral.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ */
+sxbp_spiral_stats_t sxbp_spiral_stats(sxbp_spiral_t spiral);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -9,9 +9,12 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include <assert.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "saxbospiral.h"
 #include "plot.h"
@@ -23,92 +26,89 @@ extern "C"{
 #endif
 
 /*
- * given a spiral struct with co-ords in it's cache and a pointer to a
- * 2-item-long array of type co_ord_t, find and store the co-ords for the
- * corners of the square needed to contain the points.
- * NOTE: This should NEVER be called with a pointer to anything other than a
- * 2-item array of type co_ord_t
- *
- * Asserts:
- * - That spiral.co_ord_cache.co_ords.items is not NULL
- * - That bounds is not NULL
+ * the number of rows of pixels in each band of sxbp_render_spiral_parallel(),
+ * which is small enough to keep bands well balanced between threads
+ */
+#define RENDER_BAND_HEIGHT 64
+/*
+ * the width and height in pixels of each cell of sxbp_segment_index_t, which
+ * trades the memory used by the index against how closely it fits a viewport
  */
-static void get_bounds(sxbp_spiral_t spiral, sxbp_co_ord_t* bounds) {
+#define INDEX_CELL_SIZE 256
+/*
+ * the width and height in pixels of each cell of the grid kept by
+ * sxbp_live_render_t, which trades the memory used by the grid against how
+ * many lines outside the dirty rectangle are visited when redrawing it
+ */
+#define LIVE_CELL_SIZE 64
+
+size_t sxbp_bitmap_row_size(uint32_t width) {
+    // this is ceiling(width / 8)
+    return ((size_t)width + 7) / 8;
+}
+
+sxbp_status_t sxbp_init_bitmap(
+    uint32_t width, uint32_t height, sxbp_bitmap_t* bitmap
+) {
     // preconditional assertions
-    assert(spiral.co_ord_cache.co_ords.items != NULL);
-    assert(bounds != NULL);
-    sxbp_tuple_item_t min_x = 0;
-    sxbp_tuple_item_t min_y = 0;
-    sxbp_tuple_item_t max_x = 0;
-    sxbp_tuple_item_t max_y = 0;
-    for(size_t i = 0; i < spiral.co_ord_cache.co_ords.size; i++) {
-        if(spiral.co_ord_cache.co_ords.items[i].x < min_x) {
-            min_x = spiral.co_ord_cache.co_ords.items[i].x;
-        }
-        if(spiral.co_ord_cache.co_ords.items[i].y < min_y) {
-            min_y = spiral.co_ord_cache.co_ords.items[i].y;
-        }
-        if(spiral.co_ord_cache.co_ords.items[i].x > max_x) {
-            max_x = spiral.co_ord_cache.co_ords.items[i].x;
-        }
-        if(spiral.co_ord_cache.co_ords.items[i].y > max_y) {
-            max_y = spiral.co_ord_cache.co_ords.items[i].y;
-        }
+    assert(bitmap->pixels == NULL);
+    bitmap->width = width;
+    bitmap->height = height;
+    // one contiguous block for all of the rows
+    bitmap->pixels = calloc(height, sxbp_bitmap_row_size(width));
+    // check for malloc fail (an empty bitmap may legitimately have no pixels)
+    if(bitmap->pixels == NULL && width != 0 && height != 0) {
+        return SXBP_MALLOC_REFUSED;
     }
-    // write bounds to struct
-    bounds[0].x = min_x;
-    bounds[0].y = min_y;
-    bounds[1].x = max_x;
-    bounds[1].y = max_y;
+    return SXBP_OPERATION_OK;
 }
 
-sxbp_status_t sxbp_render_spiral_raw(
-    sxbp_spiral_t spiral, sxbp_bitmap_t* image
-) {
+void sxbp_free_bitmap(sxbp_bitmap_t* bitmap) {
+    free(bitmap->pixels);
+    bitmap->pixels = NULL;
+}
+
+bool sxbp_get_bitmap_pixel(sxbp_bitmap_t bitmap, uint32_t x, uint32_t y) {
     // preconditional assertions
-    assert(image->pixels == NULL);
-    assert(spiral.lines != NULL);
-    // create result status struct
-    sxbp_status_t result;
-    // plot co-ords of spiral into it's cache
-    sxbp_cache_spiral_points(&spiral, spiral.size);
-    // get the min and max bounds of the spiral's co-ords
-    sxbp_co_ord_t bounds[2] = {{0, 0}};
-    get_bounds(spiral, bounds);
+    assert(bitmap.pixels != NULL);
+    assert(x < bitmap.width);
+    assert(y < bitmap.height);
+    return (
+        bitmap.pixels[(y * sxbp_bitmap_row_size(bitmap.width)) + (x / 8)] >>
+        (7 - (x % 8))
+    ) & 1;
+}
+
+void sxbp_free_greymap(sxbp_greymap_t* greymap) {
+    free(greymap->pixels);
+    greymap->pixels = NULL;
+}
+
+/*
+ * private function, sets a pixel of a bitmap to black
+ *
+ * NOTE: This doesn't check its arguments, as it's only used on co-ords which
+ * are known to be within the bitmap.
+ */
+static void set_pixel(
+    sxbp_bitmap_t* bitmap, size_t row_size, uint32_t x, uint32_t y
+) {
+    bitmap->pixels[(y * row_size) + (x / 8)] |= (uint8_t)(0x80 >> (x % 8));
+}
+
+/*
+ * private function, plots the lines of the spiral as points onto image, which
+ * must already be sized from stats and cleared to white
+ */
+static void draw_spiral(
+    sxbp_spiral_t spiral, sxbp_spiral_stats_t stats, sxbp_bitmap_t* image
+) {
     // get the normalisation vector needed to make all values unsigned
     sxbp_tuple_t normalisation_vector = {
-        .x = -bounds[0].x,
-        .y = -bounds[0].y,
-    };
-    // get co-ords of bottom right corner, as unsigned
-    sxbp_co_ord_t bottom_right = {
-        .x = bounds[1].x + normalisation_vector.x,
-        .y = bounds[1].y + normalisation_vector.y,
+        .x = -stats.min.x,
+        .y = -stats.min.y,
     };
-    // initialise image struct - image dimensions are twice the size + 1
-    image->width = ((bottom_right.x + 1) * 2) + 1;
-    image->height = ((bottom_right.y + 1) * 2) + 1;
-    // allocate dynamic memory to image struct - 2D array of bools
-    image->pixels = malloc(image->width * sizeof(bool*));
-    // check for malloc fail
-    if(image->pixels == NULL) {
-        result = SXBP_MALLOC_REFUSED;
-        return result;
-    }
-    for(size_t i = 0; i < image->width; i++) {
-        image->pixels[i] = calloc(image->height, sizeof(bool));
-        // check for malloc fail
-        if(image->pixels[i] == NULL) {
-            // we need to free() all previous rows
-            for(size_t j = i; j > 0; j--) {
-                free(image->pixels[j]);
-            }
-            // now we need to free() the top-level array
-            free(image->pixels);
-            result = SXBP_MALLOC_REFUSED;
-            return result;
-        }
-    }
+    size_t row_size = sxbp_bitmap_row_size(image->width);
     // set 'current point' co-ordinate
     sxbp_co_ord_t current = {
         .x = 0,
@@ -126,7 +126,9 @@ sxbp_status_t sxbp_render_spiral_raw(
             // skip the second pixel of the first line
             if(!((i == 0) && (j == 1))) {
                 // flip the y-axis otherwise they appear vertically mirrored
-                image->pixels[x_pos][image->height - 1 - y_pos] = true;
+                set_pixel(
+                    image, row_size, x_pos, image->height - 1 - y_pos
+                );
             }
             if(j != (spiral.lines[i].length * 2U)) {
                 // if we're not on the last line, advance the marker along
@@ -135,8 +137,914 @@ sxbp_status_t sxbp_render_spiral_raw(
             }
         }
     }
-    // status ok
-    result = SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_spiral_raw(
+    sxbp_spiral_t spiral, sxbp_bitmap_t* image
+) {
+    // preconditional assertions
+    assert(image->pixels == NULL);
+    assert(spiral.lines != NULL);
+    // get the min and max bounds of the spiral's co-ords
+    sxbp_spiral_stats_t stats = sxbp_spiral_stats(spiral);
+    // allocate dynamic memory to image struct - 1 bit per pixel
+    sxbp_status_t result = sxbp_init_bitmap(stats.width, stats.height, image);
+    // check for malloc fail
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    draw_spiral(spiral, stats, image);
+    return SXBP_OPERATION_OK;
+}
+
+/*
+ * private function, adds a run of pixels between the given ends (in any order)
+ * to list, flipping it vertically otherwise the image appears mirrored
+ */
+static void add_segment(
+    sxbp_segment_list_t* list, int64_t ax, int64_t ay, int64_t bx, int64_t by
+) {
+    sxbp_segment_t* segment = &list->segments[list->size];
+    segment->x0 = (uint32_t)((ax < bx) ? ax : bx);
+    segment->x1 = (uint32_t)((ax < bx) ? bx : ax);
+    segment->y0 = list->height - 1 - (uint32_t)((ay > by) ? ay : by);
+    segment->y1 = list->height - 1 - (uint32_t)((ay > by) ? by : ay);
+    list->size++;
+}
+
+/*
+ * private function, adds the runs of pixels of line i of the spiral to list,
+ * where the line starts at the pixel co-ords (x, y) before flipping, then
+ * moves (x, y) on to the end of the line
+ */
+static void add_line_segments(
+    sxbp_segment_list_t* list, sxbp_spiral_t spiral, size_t i,
+    int64_t* x, int64_t* y
+) {
+    sxbp_vector_t direction = SXBP_VECTOR_DIRECTIONS[spiral.lines[i].direction];
+    // each unit of length is two pixels long
+    int64_t length = (int64_t)spiral.lines[i].length * 2;
+    int64_t end_x = *x + (direction.x * length);
+    int64_t end_y = *y + (direction.y * length);
+    if(i == 0) {
+        // the second pixel of the first line is skipped
+        add_segment(list, *x, *y, *x, *y);
+        if(length > 0) {
+            add_segment(
+                list, *x + (direction.x * 2), *y + (direction.y * 2),
+                end_x, end_y
+            );
+        }
+    } else {
+        add_segment(list, *x, *y, end_x, end_y);
+    }
+    *x = end_x;
+    *y = end_y;
+}
+
+sxbp_status_t sxbp_spiral_segments(
+    sxbp_spiral_t spiral, sxbp_segment_list_t* list
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(list->segments == NULL);
+    // find the bounds of the spiral without touching its co-ord cache
+    sxbp_spiral_stats_t stats = sxbp_spiral_stats(spiral);
+    list->width = stats.width;
+    list->height = stats.height;
+    list->bottom_left = stats.min;
+    list->size = 0;
+    // the first line may be split in two, so allow one extra
+    list->segments = malloc((spiral.size + 1) * sizeof(sxbp_segment_t));
+    if(list->segments == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // pixel co-ords of the start of the current line, before flipping
+    int64_t x = ((0 - (int64_t)stats.min.x) * 2) + 1;
+    int64_t y = ((0 - (int64_t)stats.min.y) * 2) + 1;
+    for(size_t i = 0; i < spiral.size; i++) {
+        add_line_segments(list, spiral, i, &x, &y);
+    }
+    return SXBP_OPERATION_OK;
+}
+
+void sxbp_free_segment_list(sxbp_segment_list_t* list) {
+    free(list->segments);
+    list->segments = NULL;
+    list->size = 0;
+}
+
+// private function, orders segments by their top row for qsort()
+static int compare_segment_tops(const void* a, const void* b) {
+    uint32_t top_a = ((const sxbp_segment_t*)a)->y0;
+    uint32_t top_b = ((const sxbp_segment_t*)b)->y0;
+    return (top_a > top_b) - (top_a < top_b);
+}
+
+/*
+ * private function, sets the pixels x0 to x1 (inclusive) of a packed row of
+ * pixels to black, a whole byte at a time where possible
+ */
+static void fill_row(uint8_t* row, uint32_t x0, uint32_t x1) {
+    size_t first = x0 / 8;
+    size_t last = x1 / 8;
+    uint8_t first_mask = (uint8_t)(0xff >> (x0 % 8));
+    uint8_t last_mask = (uint8_t)(0xff << (7 - (x1 % 8)));
+    if(first == last) {
+        row[first] |= first_mask & last_mask;
+    } else {
+        row[first] |= first_mask;
+        memset(row + first + 1, 0xff, last - first - 1);
+        row[last] |= last_mask;
+    }
+}
+
+sxbp_status_t sxbp_render_spiral_rows(
+    sxbp_spiral_t spiral,
+    sxbp_status_t(* begin_callback)(
+        uint32_t width, uint32_t height, void* user_data
+    ),
+    sxbp_status_t(* row_callback)(
+        const uint8_t* row, uint32_t y, void* user_data
+    ),
+    void* user_data
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(row_callback != NULL);
+    sxbp_segment_list_t list = { .segments = NULL, };
+    sxbp_status_t result = sxbp_spiral_segments(spiral, &list);
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    // sort the runs so that they become active in order from the top down
+    qsort(list.segments, list.size, sizeof(sxbp_segment_t), compare_segment_tops);
+    size_t row_size = sxbp_bitmap_row_size(list.width);
+    uint8_t* row = malloc(row_size);
+    // indexes of the runs which cross the current row
+    size_t* active = malloc(list.size * sizeof(size_t));
+    if(row == NULL || (active == NULL && list.size > 0)) {
+        result = SXBP_MALLOC_REFUSED;
+    } else if(begin_callback != NULL) {
+        result = begin_callback(list.width, list.height, user_data);
+    }
+    size_t next = 0;
+    size_t active_count = 0;
+    for(uint32_t y = 0; y < list.height && result == SXBP_OPERATION_OK; y++) {
+        memset(row, 0, row_size);
+        // activate the runs which start on this row
+        while(next < list.size && list.segments[next].y0 == y) {
+            active[active_count] = next;
+            active_count++;
+            next++;
+        }
+        // draw the active runs, retiring those which end on this row
+        for(size_t i = 0; i < active_count; ) {
+            sxbp_segment_t segment = list.segments[active[i]];
+            fill_row(row, segment.x0, segment.x1);
+            if(segment.y1 == y) {
+                active_count--;
+                active[i] = active[active_count];
+            } else {
+                i++;
+            }
+        }
+        result = row_callback(row, y, user_data);
+    }
+    free(active);
+    free(row);
+    sxbp_free_segment_list(&list);
+    return result;
+}
+
+// private function, orders runs within a row from left to right for qsort()
+static int compare_run_starts(const void* a, const void* b) {
+    uint32_t x_a = ((const sxbp_rle_run_t*)a)->x;
+    uint32_t x_b = ((const sxbp_rle_run_t*)b)->x;
+    return (x_a > x_b) - (x_a < x_b);
+}
+
+/*
+ * private function, sorts the count runs starting at runs from left to right
+ * and joins together any which overlap or touch, returning how many are left
+ */
+static size_t merge_runs(sxbp_rle_run_t* runs, size_t count) {
+    if(count == 0) {
+        return 0;
+    }
+    qsort(runs, count, sizeof(sxbp_rle_run_t), compare_run_starts);
+    size_t merged = 0;
+    for(size_t i = 1; i < count; i++) {
+        uint32_t end = runs[merged].x + runs[merged].length;
+        if(runs[i].x <= end) {
+            // extend the last merged run if this one reaches further
+            uint32_t i_end = runs[i].x + runs[i].length;
+            if(i_end > end) {
+                runs[merged].length = i_end - runs[merged].x;
+            }
+        } else {
+            merged++;
+            runs[merged] = runs[i];
+        }
+    }
+    return merged + 1;
+}
+
+sxbp_status_t sxbp_render_spiral_rle(
+    sxbp_spiral_t spiral, sxbp_rle_bitmap_t* image
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(image->runs == NULL);
+    sxbp_segment_list_t list = { .segments = NULL, };
+    sxbp_status_t result = sxbp_spiral_segments(spiral, &list);
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    image->width = list.width;
+    image->height = list.height;
+    image->row_starts = calloc((size_t)list.height + 1, sizeof(size_t));
+    if(image->row_starts == NULL) {
+        sxbp_free_segment_list(&list);
+        return SXBP_MALLOC_REFUSED;
+    }
+    // count the runs crossing each row, each segment gives one run per row
+    for(size_t i = 0; i < list.size; i++) {
+        for(uint32_t y = list.segments[i].y0; y <= list.segments[i].y1; y++) {
+            image->row_starts[y + 1]++;
+        }
+    }
+    // turn the counts into starting indexes
+    for(uint32_t y = 0; y < list.height; y++) {
+        image->row_starts[y + 1] += image->row_starts[y];
+    }
+    size_t run_count = image->row_starts[list.height];
+    image->runs = malloc(run_count * sizeof(sxbp_rle_run_t));
+    if(image->runs == NULL && run_count > 0) {
+        sxbp_free_rle_bitmap(image);
+        sxbp_free_segment_list(&list);
+        return SXBP_MALLOC_REFUSED;
+    }
+    // fill in the runs, using the start of each row as its next free slot
+    for(size_t i = 0; i < list.size; i++) {
+        sxbp_segment_t segment = list.segments[i];
+        sxbp_rle_run_t run = {
+            .x = segment.x0, .length = segment.x1 - segment.x0 + 1,
+        };
+        for(uint32_t y = segment.y0; y <= segment.y1; y++) {
+            image->runs[image->row_starts[y]++] = run;
+        }
+    }
+    sxbp_free_segment_list(&list);
+    /*
+     * filling moved each start along to the next row's, so each row's runs
+     * end where its start now is. Merge each row's runs, packing them down
+     * towards the front as they may shrink.
+     */
+    size_t row_begin = 0;
+    size_t merged_end = 0;
+    for(uint32_t y = 0; y < image->height; y++) {
+        size_t row_end = image->row_starts[y];
+        size_t count = merge_runs(image->runs + row_begin, row_end - row_begin);
+        memmove(
+            image->runs + merged_end, image->runs + row_begin,
+            count * sizeof(sxbp_rle_run_t)
+        );
+        image->row_starts[y] = merged_end;
+        merged_end += count;
+        row_begin = row_end;
+    }
+    image->row_starts[image->height] = merged_end;
+    // give back the memory which the runs no longer need
+    if(merged_end > 0) {
+        sxbp_rle_run_t* runs = realloc(
+            image->runs, merged_end * sizeof(sxbp_rle_run_t)
+        );
+        if(runs != NULL) {
+            image->runs = runs;
+        }
+    }
+    return SXBP_OPERATION_OK;
+}
+
+void sxbp_free_rle_bitmap(sxbp_rle_bitmap_t* image) {
+    free(image->runs);
+    image->runs = NULL;
+    free(image->row_starts);
+    image->row_starts = NULL;
+}
+
+void sxbp_get_rle_bitmap_row(
+    sxbp_rle_bitmap_t image, uint32_t y, uint8_t* row
+) {
+    // preconditional assertions
+    assert(image.runs != NULL);
+    assert(y < image.height);
+    memset(row, 0, sxbp_bitmap_row_size(image.width));
+    for(size_t i = image.row_starts[y]; i < image.row_starts[y + 1]; i++) {
+        sxbp_rle_run_t run = image.runs[i];
+        fill_row(row, run.x, run.x + run.length - 1);
+    }
+}
+
+/*
+ * private type, a grid of the runs of pixels crossing each tile of an image,
+ * stored with the indexes of the runs of all tiles in one block
+ */
+typedef struct tile_grid_t {
+    uint32_t tile_width;
+    uint32_t tile_height;
+    uint32_t across;
+    uint32_t down;
+    // index into runs of the first run of each tile, plus one past the end
+    size_t* starts;
+    // indexes of the runs crossing each tile, tile by tile
+    size_t* runs;
+} tile_grid_t;
+
+// private function, ceiling of a / b
+static uint32_t divide_rounding_up(uint32_t a, uint32_t b) {
+    return (uint32_t)(((uint64_t)a + b - 1) / b);
+}
+
+/*
+ * private function, sorts the runs of pixels of list into a grid of tiles of
+ * the size given, without allocating more than *memory_left bytes (when that
+ * is not 0), which is reduced by the amount allocated
+ */
+static sxbp_status_t build_tile_grid(
+    sxbp_segment_list_t list, tile_grid_t* grid, size_t* memory_left
+) {
+    grid->across = divide_rounding_up(list.width, grid->tile_width);
+    grid->down = divide_rounding_up(list.height, grid->tile_height);
+    size_t tile_count = (size_t)grid->across * grid->down;
+    size_t starts_size = (tile_count + 1) * sizeof(size_t);
+    if(*memory_left != 0) {
+        if(starts_size >= *memory_left) {
+            return SXBP_MALLOC_REFUSED;
+        }
+        *memory_left -= starts_size;
+    }
+    grid->starts = calloc(tile_count + 1, sizeof(size_t));
+    if(grid->starts == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // count the runs crossing each tile, each run is either across or down
+    for(size_t i = 0; i < list.size; i++) {
+        sxbp_segment_t segment = list.segments[i];
+        for(
+            uint32_t ty = segment.y0 / grid->tile_height;
+            ty <= segment.y1 / grid->tile_height; ty++
+        ) {
+            for(
+                uint32_t tx = segment.x0 / grid->tile_width;
+                tx <= segment.x1 / grid->tile_width; tx++
+            ) {
+                grid->starts[((size_t)ty * grid->across) + tx + 1]++;
+            }
+        }
+    }
+    // turn the counts into starting indexes
+    for(size_t i = 0; i < tile_count; i++) {
+        grid->starts[i + 1] += grid->starts[i];
+    }
+    size_t runs_size = grid->starts[tile_count] * sizeof(size_t);
+    if(*memory_left != 0) {
+        if(runs_size >= *memory_left) {
+            return SXBP_MALLOC_REFUSED;
+        }
+        *memory_left -= runs_size;
+    }
+    grid->runs = malloc(runs_size);
+    if(grid->runs == NULL && runs_size > 0) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // fill in the runs, using the start of each tile as its next free slot
+    for(size_t i = 0; i < list.size; i++) {
+        sxbp_segment_t segment = list.segments[i];
+        for(
+            uint32_t ty = segment.y0 / grid->tile_height;
+            ty <= segment.y1 / grid->tile_height; ty++
+        ) {
+            for(
+                uint32_t tx = segment.x0 / grid->tile_width;
+                tx <= segment.x1 / grid->tile_width; tx++
+            ) {
+                grid->runs[grid->starts[((size_t)ty * grid->across) + tx]++] = i;
+            }
+        }
+    }
+    // filling moved each start along to the next tile's, so shift them back
+    memmove(grid->starts + 1, grid->starts, tile_count * sizeof(size_t));
+    grid->starts[0] = 0;
+    return SXBP_OPERATION_OK;
+}
+
+/*
+ * private function, draws the runs of pixels of list in the given tile of the
+ * grid onto tile, which must be cleared and already sized to fit the tile
+ */
+static void draw_tile(
+    sxbp_segment_list_t list, const tile_grid_t* grid, size_t tile_index,
+    uint32_t left, uint32_t top, sxbp_bitmap_t tile
+) {
+    size_t row_size = sxbp_bitmap_row_size(tile.width);
+    uint32_t right = left + tile.width - 1;
+    uint32_t bottom = top + tile.height - 1;
+    for(
+        size_t i = grid->starts[tile_index];
+        i < grid->starts[tile_index + 1]; i++
+    ) {
+        sxbp_segment_t segment = list.segments[grid->runs[i]];
+        // crop the run to the tile
+        uint32_t x0 = (segment.x0 > left) ? segment.x0 : left;
+        uint32_t x1 = (segment.x1 < right) ? segment.x1 : right;
+        uint32_t y0 = (segment.y0 > top) ? segment.y0 : top;
+        uint32_t y1 = (segment.y1 < bottom) ? segment.y1 : bottom;
+        for(uint32_t y = y0; y <= y1; y++) {
+            fill_row(tile.pixels + ((y - top) * row_size), x0 - left, x1 - left);
+        }
+    }
+}
+
+sxbp_status_t sxbp_render_spiral_tiles(
+    sxbp_spiral_t spiral, uint32_t tile_width, uint32_t tile_height,
+    size_t memory_limit,
+    sxbp_status_t(* begin_callback)(
+        uint32_t width, uint32_t height, void* user_data
+    ),
+    sxbp_status_t(* tile_callback)(
+        sxbp_bitmap_t tile, uint32_t x, uint32_t y, void* user_data
+    ),
+    void* user_data
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(tile_callback != NULL);
+    size_t memory_left = memory_limit;
+    size_t segments_size = ((size_t)spiral.size + 1) * sizeof(sxbp_segment_t);
+    if(memory_left != 0) {
+        if(segments_size >= memory_left) {
+            return SXBP_MALLOC_REFUSED;
+        }
+        memory_left -= segments_size;
+    }
+    sxbp_segment_list_t list = { .segments = NULL, };
+    sxbp_status_t result = sxbp_spiral_segments(spiral, &list);
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    tile_grid_t grid = {
+        .tile_width = (tile_width == 0 || tile_width > list.width)
+            ? list.width : tile_width,
+        .tile_height = (tile_height == 0 || tile_height > list.height)
+            ? list.height : tile_height,
+        .starts = NULL,
+        .runs = NULL,
+    };
+    result = build_tile_grid(list, &grid, &memory_left);
+    // one tile's worth of pixels, re-used for every tile
+    size_t tile_size = (
+        sxbp_bitmap_row_size(grid.tile_width) * grid.tile_height
+    );
+    sxbp_bitmap_t tile = { .pixels = NULL, };
+    if(result == SXBP_OPERATION_OK) {
+        if(memory_left != 0 && tile_size >= memory_left) {
+            result = SXBP_MALLOC_REFUSED;
+        } else {
+            tile.pixels = malloc(tile_size);
+            if(tile.pixels == NULL) {
+                result = SXBP_MALLOC_REFUSED;
+            }
+        }
+    }
+    if(result == SXBP_OPERATION_OK && begin_callback != NULL) {
+        result = begin_callback(list.width, list.height, user_data);
+    }
+    for(uint32_t ty = 0; ty < grid.down && result == SXBP_OPERATION_OK; ty++) {
+        uint32_t top = ty * grid.tile_height;
+        for(
+            uint32_t tx = 0;
+            tx < grid.across && result == SXBP_OPERATION_OK; tx++
+        ) {
+            uint32_t left = tx * grid.tile_width;
+            // tiles on the right and bottom edges are cropped to the image
+            tile.width = (list.width - left < grid.tile_width)
+                ? list.width - left : grid.tile_width;
+            tile.height = (list.height - top < grid.tile_height)
+                ? list.height - top : grid.tile_height;
+            memset(
+                tile.pixels, 0, sxbp_bitmap_row_size(tile.width) * tile.height
+            );
+            draw_tile(
+                list, &grid, ((size_t)ty * grid.across) + tx, left, top, tile
+            );
+            result = tile_callback(tile, left, top, user_data);
+        }
+    }
+    free(tile.pixels);
+    free(grid.runs);
+    free(grid.starts);
+    sxbp_free_segment_list(&list);
+    return result;
+}
+
+sxbp_status_t sxbp_render_spiral_parallel(
+    sxbp_spiral_t spiral, sxbp_bitmap_t* image
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(image->pixels == NULL);
+    sxbp_segment_list_t list = { .segments = NULL, };
+    sxbp_status_t result = sxbp_spiral_segments(spiral, &list);
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    // bands are tiles as wide as the image, so each is a block of whole rows
+    tile_grid_t grid = {
+        .tile_width = list.width,
+        .tile_height = (list.height < RENDER_BAND_HEIGHT)
+            ? list.height : RENDER_BAND_HEIGHT,
+        .starts = NULL,
+        .runs = NULL,
+    };
+    size_t no_memory_limit = 0;
+    result = build_tile_grid(list, &grid, &no_memory_limit);
+    if(result == SXBP_OPERATION_OK) {
+        result = sxbp_init_bitmap(list.width, list.height, image);
+    }
+    if(result == SXBP_OPERATION_OK) {
+        size_t row_size = sxbp_bitmap_row_size(image->width);
+        /*
+         * each band only writes to its own rows of the image, so bands can be
+         * drawn by different threads without any locking
+         */
+        #ifdef LIBSXBP_OPENMP_SUPPORT
+        #pragma omp parallel for schedule(dynamic)
+        #endif
+        for(uint32_t band = 0; band < grid.down; band++) {
+            uint32_t top = band * grid.tile_height;
+            sxbp_bitmap_t rows = {
+                .width = image->width,
+                .height = (image->height - top < grid.tile_height)
+                    ? image->height - top : grid.tile_height,
+                .pixels = image->pixels + (top * row_size),
+            };
+            draw_tile(list, &grid, band, 0, top, rows);
+        }
+    }
+    free(grid.runs);
+    free(grid.starts);
+    sxbp_free_segment_list(&list);
+    return result;
+}
+
+sxbp_status_t sxbp_index_spiral_segments(
+    sxbp_spiral_t spiral, sxbp_segment_index_t* index
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(index->list.segments == NULL);
+    index->starts = NULL;
+    index->runs = NULL;
+    sxbp_status_t result = sxbp_spiral_segments(spiral, &index->list);
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    // the cells are the tiles of a tiled render
+    tile_grid_t grid = {
+        .tile_width = INDEX_CELL_SIZE,
+        .tile_height = INDEX_CELL_SIZE,
+        .starts = NULL,
+        .runs = NULL,
+    };
+    size_t no_memory_limit = 0;
+    result = build_tile_grid(index->list, &grid, &no_memory_limit);
+    index->cell_size = INDEX_CELL_SIZE;
+    index->across = grid.across;
+    index->down = grid.down;
+    index->starts = grid.starts;
+    index->runs = grid.runs;
+    if(result != SXBP_OPERATION_OK) {
+        sxbp_free_segment_index(index);
+    }
+    return result;
+}
+
+void sxbp_free_segment_index(sxbp_segment_index_t* index) {
+    sxbp_free_segment_list(&index->list);
+    free(index->starts);
+    free(index->runs);
+    index->starts = NULL;
+    index->runs = NULL;
+}
+
+sxbp_viewport_t sxbp_spiral_viewport(
+    const sxbp_segment_index_t* index, double scale
+) {
+    /*
+     * pixel p of the full image is centred on co-ord bottom_left + (p - 1) / 2
+     * so the image spans from half a unit before bottom_left to half a unit
+     * after its last pixel
+     */
+    sxbp_viewport_t viewport = {
+        .x = index->list.bottom_left.x - 0.5,
+        .y = index->list.bottom_left.y - 0.5,
+        .width = (uint32_t)ceil(scale * index->list.width / 2.0),
+        .height = (uint32_t)ceil(scale * index->list.height / 2.0),
+        .scale = scale,
+    };
+    return viewport;
+}
+
+/*
+ * private function, gives the co-ordinate of the centre of the given pixel of
+ * the full image, along an axis on which the image starts from the given
+ * co-ordinate
+ */
+static double pixel_co_ord(uint32_t pixel, sxbp_tuple_item_t start) {
+    return start + ((pixel - 1.0) / 2.0);
+}
+
+/*
+ * private function, gives the range of pixels of the full image of the given
+ * size whose centres fall within a viewport spanning size / scale units from
+ * the given co-ordinate, along an axis on which the image starts from start.
+ * Returns false if no pixels fall within it.
+ */
+static bool visible_pixels(
+    double from, uint32_t size, double scale, sxbp_tuple_item_t start,
+    uint32_t image_size, uint32_t* first, uint32_t* last
+) {
+    // this is the inverse of pixel_co_ord(), widened by a pixel either side
+    double low = floor(((from - start) * 2.0) + 1.0) - 1.0;
+    double high = ceil(((from + (size / scale) - start) * 2.0) + 1.0) + 1.0;
+    if(high < 0.0 || low > image_size - 1.0) {
+        return false;
+    }
+    *first = (low < 0.0) ? 0 : (uint32_t)low;
+    *last = (high > image_size - 1.0) ? image_size - 1 : (uint32_t)high;
+    return true;
+}
+
+sxbp_status_t sxbp_render_spiral_viewport(
+    const sxbp_segment_index_t* index, sxbp_viewport_t viewport,
+    sxbp_bitmap_t* image
+) {
+    // preconditional assertions
+    assert(index->list.segments != NULL);
+    assert(viewport.scale > 0.0);
+    assert(image->pixels == NULL);
+    sxbp_status_t result = sxbp_init_bitmap(
+        viewport.width, viewport.height, image
+    );
+    if(result != SXBP_OPERATION_OK || image->pixels == NULL) {
+        return result;
+    }
+    sxbp_segment_list_t list = index->list;
+    // find the pixels of the full image which are visible, rows are flipped
+    uint32_t left, right, bottom, top;
+    if(
+        !visible_pixels(
+            viewport.x, viewport.width, viewport.scale, list.bottom_left.x,
+            list.width, &left, &right
+        ) ||
+        !visible_pixels(
+            viewport.y, viewport.height, viewport.scale, list.bottom_left.y,
+            list.height, &bottom, &top
+        )
+    ) {
+        return SXBP_OPERATION_OK;
+    }
+    top = list.height - 1 - top;
+    bottom = list.height - 1 - bottom;
+    size_t row_size = sxbp_bitmap_row_size(image->width);
+    double max_x = image->width - 1.0;
+    double max_y = image->height - 1.0;
+    for(
+        uint32_t cy = top / index->cell_size;
+        cy <= bottom / index->cell_size; cy++
+    ) {
+        for(
+            uint32_t cx = left / index->cell_size;
+            cx <= right / index->cell_size; cx++
+        ) {
+            size_t cell = ((size_t)cy * index->across) + cx;
+            for(
+                size_t i = index->starts[cell]; i < index->starts[cell + 1];
+                i++
+            ) {
+                /*
+                 * runs crossing more than one cell are drawn more than once,
+                 * which is harmless and cheaper than tracking them
+                 */
+                sxbp_segment_t segment = list.segments[index->runs[i]];
+                // map the ends of the run into the viewport
+                double x0 = floor(
+                    viewport.scale * (
+                        pixel_co_ord(segment.x0, list.bottom_left.x) -
+                        viewport.x
+                    )
+                );
+                double x1 = floor(
+                    viewport.scale * (
+                        pixel_co_ord(segment.x1, list.bottom_left.x) -
+                        viewport.x
+                    )
+                );
+                // rows of the image count down from the top
+                double y0 = max_y - floor(
+                    viewport.scale * (
+                        pixel_co_ord(
+                            list.height - 1 - segment.y0, list.bottom_left.y
+                        ) - viewport.y
+                    )
+                );
+                double y1 = max_y - floor(
+                    viewport.scale * (
+                        pixel_co_ord(
+                            list.height - 1 - segment.y1, list.bottom_left.y
+                        ) - viewport.y
+                    )
+                );
+                // skip the run if it's outside the viewport, else crop it
+                if(x1 < 0.0 || x0 > max_x || y1 < 0.0 || y0 > max_y) {
+                    continue;
+                }
+                uint32_t from_x = (x0 < 0.0) ? 0 : (uint32_t)x0;
+                uint32_t to_x = (x1 > max_x) ? image->width - 1 : (uint32_t)x1;
+                uint32_t from_y = (y0 < 0.0) ? 0 : (uint32_t)y0;
+                uint32_t to_y = (y1 > max_y) ? image->height - 1 : (uint32_t)y1;
+                for(uint32_t y = from_y; y <= to_y; y++) {
+                    fill_row(image->pixels + (y * row_size), from_x, to_x);
+                }
+            }
+        }
+    }
+    return SXBP_OPERATION_OK;
+}
+
+// private function, counts the set bits of a byte
+static uint8_t count_set_bits(uint8_t byte) {
+    byte = (uint8_t)(byte - ((byte >> 1) & 0x55));
+    byte = (uint8_t)((byte & 0x33) + ((byte >> 2) & 0x33));
+    return (uint8_t)((byte + (byte >> 4)) & 0x0f);
+}
+
+/*
+ * private type, the user data given to the callbacks of
+ * sxbp_render_spiral_rows() when rendering a scaled image
+ */
+typedef struct scaled_render_t {
+    uint32_t factor;
+    // the width and height of the full size image
+    uint32_t width;
+    uint32_t height;
+    sxbp_greymap_t* image;
+    // count of black pixels in each block of the current row of blocks
+    uint32_t* counts;
+} scaled_render_t;
+
+// private function, allocates the image once its size is known
+static sxbp_status_t scaled_render_begin(
+    uint32_t width, uint32_t height, void* user_data
+) {
+    scaled_render_t* render = (scaled_render_t*)user_data;
+    render->width = width;
+    render->height = height;
+    render->image->width = divide_rounding_up(width, render->factor);
+    render->image->height = divide_rounding_up(height, render->factor);
+    render->image->pixels = malloc(
+        (size_t)render->image->width * render->image->height
+    );
+    render->counts = calloc(render->image->width, sizeof(uint32_t));
+    if(render->image->pixels == NULL || render->counts == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+/*
+ * private function, counts the black pixels of one row of the full size image
+ * into the blocks they fall in, writing out a row of the scaled image after
+ * each block's worth of rows
+ */
+static sxbp_status_t scaled_render_row(
+    const uint8_t* row, uint32_t y, void* user_data
+) {
+    scaled_render_t* render = (scaled_render_t*)user_data;
+    uint32_t factor = render->factor;
+    sxbp_greymap_t* image = render->image;
+    size_t row_size = sxbp_bitmap_row_size(render->width);
+    for(size_t i = 0; i < row_size; i++) {
+        if(row[i] == 0) {
+            continue;
+        }
+        uint32_t first = (uint32_t)(i * 8);
+        if(first / factor == (first + 7) / factor) {
+            // the whole byte falls in one block
+            render->counts[first / factor] += count_set_bits(row[i]);
+        } else {
+            for(uint32_t bit = 0; bit < 8; bit++) {
+                if((row[i] >> (7 - bit)) & 1) {
+                    render->counts[(first + bit) / factor]++;
+                }
+            }
+        }
+    }
+    // write out the row of blocks once its last row, or the image's, is done
+    uint32_t block_y = y / factor;
+    if(y % factor == factor - 1 || y == render->height - 1) {
+        uint64_t area = (uint64_t)factor * factor;
+        uint8_t* pixels = image->pixels + ((size_t)block_y * image->width);
+        for(uint32_t x = 0; x < image->width; x++) {
+            // scale the count to 0..255, rounding to nearest
+            pixels[x] = (uint8_t)(
+                ((render->counts[x] * (uint64_t)255) + (area / 2)) / area
+            );
+            render->counts[x] = 0;
+        }
+    }
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_spiral_scaled(
+    sxbp_spiral_t spiral, uint32_t factor, sxbp_greymap_t* image
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(factor != 0);
+    assert(image->pixels == NULL);
+    scaled_render_t render = {
+        .factor = factor, .width = 0, .height = 0, .image = image, .counts = NULL,
+    };
+    sxbp_status_t result = sxbp_render_spiral_rows(
+        spiral, scaled_render_begin, scaled_render_row, (void*)&render
+    );
+    free(render.counts);
+    if(result != SXBP_OPERATION_OK) {
+        sxbp_free_greymap(image);
+    }
+    return result;
+}
+
+/*
+ * private function, shrinks source to half its size along each side into
+ * destination, averaging each block of 2 by 2 pixels, with those missing off
+ * the edges counting as white
+ */
+static sxbp_status_t halve_greymap(
+    sxbp_greymap_t source, sxbp_greymap_t* destination
+) {
+    destination->width = divide_rounding_up(source.width, 2);
+    destination->height = divide_rounding_up(source.height, 2);
+    destination->pixels = malloc(
+        (size_t)destination->width * destination->height
+    );
+    if(destination->pixels == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    for(uint32_t y = 0; y < destination->height; y++) {
+        for(uint32_t x = 0; x < destination->width; x++) {
+            uint32_t sum = 0;
+            for(uint32_t dy = 0; dy < 2; dy++) {
+                for(uint32_t dx = 0; dx < 2; dx++) {
+                    uint32_t sx = (x * 2) + dx;
+                    uint32_t sy = (y * 2) + dy;
+                    if(sx < source.width && sy < source.height) {
+                        sum += source.pixels[((size_t)sy * source.width) + sx];
+                    }
+                }
+            }
+            destination->pixels[((size_t)y * destination->width) + x] = (
+                (uint8_t)((sum + 2) / 4)
+            );
+        }
+    }
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_spiral_mipmap(
+    sxbp_spiral_t spiral, uint32_t factor, size_t levels,
+    sxbp_greymap_t* images
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(factor != 0);
+    if(levels == 0) {
+        return SXBP_OPERATION_OK;
+    }
+    sxbp_status_t result = sxbp_render_spiral_scaled(spiral, factor, images);
+    for(size_t i = 1; i < levels && result == SXBP_OPERATION_OK; i++) {
+        // preconditional assertions
+        assert(images[i].pixels == NULL);
+        result = halve_greymap(images[i - 1], &images[i]);
+    }
+    if(result != SXBP_OPERATION_OK) {
+        for(size_t i = 0; i < levels; i++) {
+            sxbp_free_greymap(&images[i]);
+        }
+    }
     return result;
 }
 
@@ -151,15 +1059,672 @@ sxbp_status_t sxbp_render_spiral_image(
     assert(buffer->bytes == NULL);
     assert(image_writer_callback != NULL);
     // create bitmap to render raw image to
-    sxbp_bitmap_t raw_image = {0, 0, NULL};
+    sxbp_bitmap_t raw_image = { .width = 0, .height = 0, .pixels = NULL, };
     // render spiral to raw image (and store success/failure)
     sxbp_status_t result = sxbp_render_spiral_raw(spiral, &raw_image);
     // check return status
     if(result != SXBP_OPERATION_OK) {
         return result;
     }
-    // render to buffer using callback (and return its status code)
-    return image_writer_callback(raw_image, buffer);
+    // render to buffer using callback
+    result = image_writer_callback(raw_image, buffer);
+    // the raw image is no longer needed
+    sxbp_free_bitmap(&raw_image);
+    return result;
+}
+
+sxbp_render_context_t sxbp_blank_render_context(void) {
+    return (sxbp_render_context_t){
+        .bitmap = { .width = 0, .height = 0, .pixels = NULL, },
+        .pixels_capacity = 0,
+        .output = { .bytes = NULL, .size = 0, },
+    };
+}
+
+void sxbp_free_render_context(sxbp_render_context_t* context) {
+    free(context->bitmap.pixels);
+    free(context->output.bytes);
+    *context = sxbp_blank_render_context();
+}
+
+/*
+ * private function, makes sure that the memory pointed to by bytes, of which
+ * capacity bytes are allocated, can hold at least size bytes. The contents
+ * aren't kept, so the old memory is freed rather than re-allocated. At least
+ * one byte is always allocated, so that the memory is never NULL.
+ */
+static sxbp_status_t reserve_pooled_bytes(
+    uint8_t** bytes, size_t* capacity, size_t size
+) {
+    if(*bytes != NULL && *capacity >= size) {
+        return SXBP_OPERATION_OK;
+    }
+    free(*bytes);
+    *capacity = 0;
+    size = (size > 0) ? size : 1;
+    *bytes = malloc(size);
+    if(*bytes == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    *capacity = size;
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_spiral_raw_pooled(
+    sxbp_render_context_t* context, sxbp_spiral_t spiral, sxbp_bitmap_t* image
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    sxbp_spiral_stats_t stats = sxbp_spiral_stats(spiral);
+    size_t size = sxbp_bitmap_row_size(stats.width) * stats.height;
+    sxbp_status_t result = reserve_pooled_bytes(
+        &context->bitmap.pixels, &context->pixels_capacity, size
+    );
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    context->bitmap.width = stats.width;
+    context->bitmap.height = stats.height;
+    // only the part of the memory used by this image needs clearing
+    memset(context->bitmap.pixels, 0, size);
+    draw_spiral(spiral, stats, &context->bitmap);
+    *image = context->bitmap;
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_spiral_image_pooled(
+    sxbp_render_context_t* context, sxbp_spiral_t spiral,
+    size_t(* size_callback)(sxbp_bitmap_t image),
+    sxbp_status_t(* image_writer_callback)(
+        sxbp_bitmap_t image, sxbp_buffer_t buffer, size_t* bytes_written
+    ),
+    sxbp_buffer_t* buffer
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(size_callback != NULL);
+    assert(image_writer_callback != NULL);
+    sxbp_bitmap_t image = { .pixels = NULL, };
+    sxbp_status_t result = sxbp_render_spiral_raw_pooled(
+        context, spiral, &image
+    );
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    result = reserve_pooled_bytes(
+        &context->output.bytes, &context->output.size, size_callback(image)
+    );
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    size_t bytes_written = 0;
+    result = image_writer_callback(image, context->output, &bytes_written);
+    buffer->bytes = context->output.bytes;
+    buffer->size = bytes_written;
+    return result;
+}
+
+/*
+ * private function, sets the pixels x0 to x1 (inclusive) of a packed row of
+ * pixels to white, the opposite of fill_row()
+ */
+static void clear_row(uint8_t* row, uint32_t x0, uint32_t x1) {
+    size_t first = x0 / 8;
+    size_t last = x1 / 8;
+    uint8_t first_mask = (uint8_t)(0xff >> (x0 % 8));
+    uint8_t last_mask = (uint8_t)(0xff << (7 - (x1 % 8)));
+    if(first == last) {
+        row[first] &= (uint8_t)~(first_mask & last_mask);
+    } else {
+        row[first] &= (uint8_t)~first_mask;
+        memset(row + first + 1, 0x00, last - first - 1);
+        row[last] &= (uint8_t)~last_mask;
+    }
+}
+
+// private function, returns the co-ord at the start of line i of a live render
+static sxbp_co_ord_t live_line_start(
+    const sxbp_live_render_t* live, uint32_t i
+) {
+    return (i == 0) ? (sxbp_co_ord_t){ .x = 0, .y = 0, } : live->ends[i - 1];
+}
+
+/*
+ * private function, returns the rectangle of pixels of the image of a live
+ * render which the line between the given co-ords falls within
+ */
+static sxbp_pixel_rect_t live_line_box(
+    const sxbp_live_render_t* live, sxbp_co_ord_t start, sxbp_co_ord_t end
+) {
+    int64_t min_x = (start.x < end.x) ? start.x : end.x;
+    int64_t max_x = (start.x > end.x) ? start.x : end.x;
+    int64_t min_y = (start.y < end.y) ? start.y : end.y;
+    int64_t max_y = (start.y > end.y) ? start.y : end.y;
+    // convert the box to pixels, flipping it vertically
+    return (sxbp_pixel_rect_t){
+        .x = (uint32_t)(((min_x - live->bottom_left.x) * 2) + 1),
+        .y = (uint32_t)(
+            live->image.height - 1 -
+            (((max_y - live->bottom_left.y) * 2) + 1)
+        ),
+        .width = (uint32_t)(((max_x - min_x) * 2) + 1),
+        .height = (uint32_t)(((max_y - min_y) * 2) + 1),
+    };
+}
+
+/*
+ * private function, adds line i to the cells of a live render's grid which
+ * fall under box. Returns SXBP_MALLOC_REFUSED on failure.
+ */
+static sxbp_status_t add_to_live_cells(
+    sxbp_live_render_t* live, sxbp_pixel_rect_t box, uint32_t i
+) {
+    uint32_t right = (box.x + box.width - 1) / LIVE_CELL_SIZE;
+    uint32_t bottom = (box.y + box.height - 1) / LIVE_CELL_SIZE;
+    for(uint32_t y = box.y / LIVE_CELL_SIZE; y <= bottom; y++) {
+        for(uint32_t x = box.x / LIVE_CELL_SIZE; x <= right; x++) {
+            sxbp_live_cell_t* cell = &live->cells[
+                ((size_t)y * live->cells_across) + x
+            ];
+            if(cell->count == cell->capacity) {
+                uint32_t capacity = (cell->capacity == 0) ?
+                    4 : cell->capacity * 2;
+                uint32_t* lines = realloc(
+                    cell->lines, capacity * sizeof(uint32_t)
+                );
+                if(lines == NULL) {
+                    return SXBP_MALLOC_REFUSED;
+                }
+                cell->lines = lines;
+                cell->capacity = capacity;
+            }
+            cell->lines[cell->count] = i;
+            cell->count++;
+        }
+    }
+    return SXBP_OPERATION_OK;
+}
+
+/*
+ * private function, removes line i from the cells of a live render's grid
+ * which fall under box, which must be the box it was added with
+ */
+static void remove_from_live_cells(
+    sxbp_live_render_t* live, sxbp_pixel_rect_t box, uint32_t i
+) {
+    uint32_t right = (box.x + box.width - 1) / LIVE_CELL_SIZE;
+    uint32_t bottom = (box.y + box.height - 1) / LIVE_CELL_SIZE;
+    for(uint32_t y = box.y / LIVE_CELL_SIZE; y <= bottom; y++) {
+        for(uint32_t x = box.x / LIVE_CELL_SIZE; x <= right; x++) {
+            sxbp_live_cell_t* cell = &live->cells[
+                ((size_t)y * live->cells_across) + x
+            ];
+            // the order of the lines doesn't matter, so swap in the last one
+            for(uint32_t j = 0; j < cell->count; j++) {
+                if(cell->lines[j] == i) {
+                    cell->count--;
+                    cell->lines[j] = cell->lines[cell->count];
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// private function, frees the grid of cells of a live render
+static void free_live_cells(sxbp_live_render_t* live) {
+    if(live->cells != NULL) {
+        size_t count = (size_t)live->cells_across * live->cells_down;
+        for(size_t i = 0; i < count; i++) {
+            free(live->cells[i].lines);
+        }
+    }
+    free(live->cells);
+    live->cells = NULL;
+    live->cells_across = 0;
+    live->cells_down = 0;
+}
+
+/*
+ * private function, draws the parts of the lines of the spiral which fall
+ * within rect onto the image of a live render, visiting only the lines listed
+ * by the cells of the grid which rect covers
+ */
+static void draw_live_region(
+    sxbp_live_render_t* live, sxbp_spiral_t spiral, sxbp_pixel_rect_t rect
+) {
+    size_t row_size = sxbp_bitmap_row_size(live->image.width);
+    // a line is at most two runs of pixels, which are flipped by the list
+    sxbp_segment_t segments[2];
+    sxbp_segment_list_t list = {
+        .width = live->image.width, .height = live->image.height,
+        .segments = segments, .size = 0,
+    };
+    uint32_t right = rect.x + rect.width - 1;
+    uint32_t bottom = rect.y + rect.height - 1;
+    for(
+        uint32_t cy = rect.y / LIVE_CELL_SIZE;
+        cy <= bottom / LIVE_CELL_SIZE; cy++
+    ) {
+        for(
+            uint32_t cx = rect.x / LIVE_CELL_SIZE;
+            cx <= right / LIVE_CELL_SIZE; cx++
+        ) {
+            // only draw within this cell, so lines crossing many aren't redone
+            uint32_t left_edge = cx * LIVE_CELL_SIZE;
+            uint32_t top_edge = cy * LIVE_CELL_SIZE;
+            uint32_t clip_x0 = (rect.x > left_edge) ? rect.x : left_edge;
+            uint32_t clip_y0 = (rect.y > top_edge) ? rect.y : top_edge;
+            uint32_t clip_x1 = left_edge + LIVE_CELL_SIZE - 1;
+            uint32_t clip_y1 = top_edge + LIVE_CELL_SIZE - 1;
+            clip_x1 = (right < clip_x1) ? right : clip_x1;
+            clip_y1 = (bottom < clip_y1) ? bottom : clip_y1;
+            const sxbp_live_cell_t* cell = &live->cells[
+                ((size_t)cy * live->cells_across) + cx
+            ];
+            for(uint32_t k = 0; k < cell->count; k++) {
+                uint32_t i = cell->lines[k];
+                sxbp_co_ord_t start = live_line_start(live, i);
+                int64_t x = (((int64_t)start.x - live->bottom_left.x) * 2) + 1;
+                int64_t y = (((int64_t)start.y - live->bottom_left.y) * 2) + 1;
+                list.size = 0;
+                add_line_segments(&list, spiral, i, &x, &y);
+                for(size_t j = 0; j < list.size; j++) {
+                    // clip the run to the part of the rectangle in this cell
+                    uint32_t x0 = segments[j].x0, y0 = segments[j].y0;
+                    uint32_t x1 = segments[j].x1, y1 = segments[j].y1;
+                    x0 = (x0 > clip_x0) ? x0 : clip_x0;
+                    y0 = (y0 > clip_y0) ? y0 : clip_y0;
+                    x1 = (x1 < clip_x1) ? x1 : clip_x1;
+                    y1 = (y1 < clip_y1) ? y1 : clip_y1;
+                    for(uint32_t row = y0; x0 <= x1 && row <= y1; row++) {
+                        fill_row(live->image.pixels + (row * row_size), x0, x1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * private function, adds one to each of a live render's counts of the edges of
+ * the bounds which the given co-ord lies on, or takes one away if change is -1
+ */
+static void count_live_edges(
+    const sxbp_live_render_t* live, sxbp_co_ord_t co_ord, int64_t change,
+    int64_t edge_counts[4]
+) {
+    edge_counts[0] += (co_ord.x == live->bottom_left.x) ? change : 0;
+    edge_counts[1] += (co_ord.y == live->bottom_left.y) ? change : 0;
+    edge_counts[2] += (co_ord.x == live->top_right.x) ? change : 0;
+    edge_counts[3] += (co_ord.y == live->top_right.y) ? change : 0;
+}
+
+/*
+ * private function, draws the whole of the spiral again for a live render, at
+ * the size and position given by stats, and rebuilds everything it keeps
+ */
+static sxbp_status_t redraw_live_render(
+    sxbp_live_render_t* live, sxbp_spiral_t spiral, sxbp_spiral_stats_t stats,
+    sxbp_pixel_rect_t* dirty
+) {
+    if(
+        (live->image.pixels == NULL) ||
+        (live->image.width != stats.width) ||
+        (live->image.height != stats.height)
+    ) {
+        sxbp_free_bitmap(&live->image);
+        sxbp_status_t result = sxbp_init_bitmap(
+            stats.width, stats.height, &live->image
+        );
+        if(result != SXBP_OPERATION_OK) {
+            return result;
+        }
+    } else {
+        memset(
+            live->image.pixels, 0,
+            sxbp_bitmap_row_size(stats.width) * stats.height
+        );
+    }
+    draw_spiral(spiral, stats, &live->image);
+    live->bottom_left = stats.min;
+    live->top_right = stats.max;
+    // every line has moved in the image, so the grid is built afresh
+    free_live_cells(live);
+    live->cells_across = (stats.width + LIVE_CELL_SIZE - 1) / LIVE_CELL_SIZE;
+    live->cells_down = (stats.height + LIVE_CELL_SIZE - 1) / LIVE_CELL_SIZE;
+    live->cells = calloc(
+        (size_t)live->cells_across * live->cells_down, sizeof(sxbp_live_cell_t)
+    );
+    if(live->cells == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // the origin is a point of the spiral too, so it counts towards the edges
+    int64_t edge_counts[4] = { 0, 0, 0, 0, };
+    sxbp_co_ord_t current = { .x = 0, .y = 0, };
+    count_live_edges(live, current, 1, edge_counts);
+    for(uint32_t i = 0; i < spiral.size; i++) {
+        sxbp_vector_t direction = SXBP_VECTOR_DIRECTIONS[spiral.lines[i].direction];
+        sxbp_co_ord_t end = {
+            .x = (sxbp_tuple_item_t)(
+                current.x + (direction.x * (int64_t)spiral.lines[i].length)
+            ),
+            .y = (sxbp_tuple_item_t)(
+                current.y + (direction.y * (int64_t)spiral.lines[i].length)
+            ),
+        };
+        live->lengths[i] = spiral.lines[i].length;
+        live->ends[i] = end;
+        count_live_edges(live, end, 1, edge_counts);
+        sxbp_status_t result = add_to_live_cells(
+            live, live_line_box(live, current, end), i
+        );
+        if(result != SXBP_OPERATION_OK) {
+            return result;
+        }
+        current = end;
+    }
+    for(uint8_t e = 0; e < 4; e++) {
+        live->edge_counts[e] = (uint32_t)edge_counts[e];
+    }
+    *dirty = (sxbp_pixel_rect_t){
+        .x = 0, .y = 0, .width = stats.width, .height = stats.height,
+    };
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_begin_live_render(
+    sxbp_spiral_t spiral, sxbp_live_render_t* live
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(live->image.pixels == NULL);
+    live->size = spiral.size;
+    live->cells = NULL;
+    live->cells_across = 0;
+    live->cells_down = 0;
+    // always allocate something, so that an empty spiral has lengths too
+    size_t count = (spiral.size > 0) ? spiral.size : 1;
+    live->lengths = malloc(count * sizeof(sxbp_length_t));
+    live->ends = malloc(count * sizeof(sxbp_co_ord_t));
+    if(live->lengths == NULL || live->ends == NULL) {
+        sxbp_free_live_render(live);
+        return SXBP_MALLOC_REFUSED;
+    }
+    sxbp_pixel_rect_t dirty;
+    sxbp_status_t result = redraw_live_render(
+        live, spiral, sxbp_spiral_stats(spiral), &dirty
+    );
+    if(result != SXBP_OPERATION_OK) {
+        sxbp_free_live_render(live);
+    }
+    return result;
+}
+
+sxbp_status_t sxbp_update_live_render(
+    sxbp_live_render_t* live, sxbp_spiral_t spiral, sxbp_pixel_rect_t* dirty
+) {
+    // preconditional assertions
+    assert(live->lengths != NULL);
+    assert(spiral.lines != NULL);
+    assert(spiral.size == live->size);
+    *dirty = (sxbp_pixel_rect_t){ .x = 0, .y = 0, .width = 0, .height = 0, };
+    // find the first and last lines whose lengths have changed, if any
+    uint32_t first = 0;
+    while(
+        first < spiral.size &&
+        live->lengths[first] == spiral.lines[first].length
+    ) {
+        first++;
+    }
+    if(first == spiral.size) {
+        return SXBP_OPERATION_OK;
+    }
+    uint32_t last = spiral.size - 1;
+    while(live->lengths[last] == spiral.lines[last].length) {
+        last--;
+    }
+    /*
+     * walk the changed lines, and every line after them until they end where
+     * they used to, finding the box around where they were and are now and
+     * how the count of points on each edge of the bounds changes
+     */
+    sxbp_co_ord_t start = live_line_start(live, first);
+    int64_t x = start.x, y = start.y;
+    int64_t min_x = x, min_y = y, max_x = x, max_y = y;
+    int64_t edge_counts[4];
+    for(uint8_t e = 0; e < 4; e++) {
+        edge_counts[e] = live->edge_counts[e];
+    }
+    bool moved = false;
+    bool grown = false;
+    uint32_t end = first;
+    while(end < spiral.size && (end <= last || moved)) {
+        sxbp_vector_t direction = SXBP_VECTOR_DIRECTIONS[spiral.lines[end].direction];
+        sxbp_co_ord_t old_end = live->ends[end];
+        x += direction.x * (int64_t)spiral.lines[end].length;
+        y += direction.y * (int64_t)spiral.lines[end].length;
+        sxbp_co_ord_t new_end = {
+            .x = (sxbp_tuple_item_t)x, .y = (sxbp_tuple_item_t)y,
+        };
+        min_x = (old_end.x < min_x) ? old_end.x : min_x;
+        min_x = (x < min_x) ? x : min_x;
+        min_y = (old_end.y < min_y) ? old_end.y : min_y;
+        min_y = (y < min_y) ? y : min_y;
+        max_x = (old_end.x > max_x) ? old_end.x : max_x;
+        max_x = (x > max_x) ? x : max_x;
+        max_y = (old_end.y > max_y) ? old_end.y : max_y;
+        max_y = (y > max_y) ? y : max_y;
+        count_live_edges(live, old_end, -1, edge_counts);
+        count_live_edges(live, new_end, 1, edge_counts);
+        grown = grown || (
+            (x < live->bottom_left.x) || (x > live->top_right.x) ||
+            (y < live->bottom_left.y) || (y > live->top_right.y)
+        );
+        moved = (old_end.x != x) || (old_end.y != y);
+        end++;
+    }
+    /*
+     * if the spiral now reaches beyond its bounds, or no longer reaches one of
+     * them, the whole image moves, so draw it all again
+     */
+    bool shrunk = false;
+    for(uint8_t e = 0; e < 4; e++) {
+        shrunk = shrunk || (edge_counts[e] == 0);
+    }
+    if(grown || shrunk) {
+        return redraw_live_render(
+            live, spiral, sxbp_spiral_stats(spiral), dirty
+        );
+    }
+    // move the walked lines to where they are now in the grid
+    sxbp_co_ord_t old_start = start;
+    for(uint32_t i = first; i < end; i++) {
+        sxbp_vector_t direction = SXBP_VECTOR_DIRECTIONS[spiral.lines[i].direction];
+        sxbp_co_ord_t old_end = live->ends[i];
+        sxbp_co_ord_t new_end = {
+            .x = (sxbp_tuple_item_t)(
+                start.x + (direction.x * (int64_t)spiral.lines[i].length)
+            ),
+            .y = (sxbp_tuple_item_t)(
+                start.y + (direction.y * (int64_t)spiral.lines[i].length)
+            ),
+        };
+        remove_from_live_cells(
+            live, live_line_box(live, old_start, old_end), i
+        );
+        live->lengths[i] = spiral.lines[i].length;
+        live->ends[i] = new_end;
+        sxbp_status_t result = add_to_live_cells(
+            live, live_line_box(live, start, new_end), i
+        );
+        if(result != SXBP_OPERATION_OK) {
+            return result;
+        }
+        old_start = old_end;
+        start = new_end;
+    }
+    for(uint8_t e = 0; e < 4; e++) {
+        live->edge_counts[e] = (uint32_t)edge_counts[e];
+    }
+    // convert the box to pixels, flipping it vertically
+    *dirty = live_line_box(
+        live,
+        (sxbp_co_ord_t){
+            .x = (sxbp_tuple_item_t)min_x, .y = (sxbp_tuple_item_t)min_y,
+        },
+        (sxbp_co_ord_t){
+            .x = (sxbp_tuple_item_t)max_x, .y = (sxbp_tuple_item_t)max_y,
+        }
+    );
+    // clear the box, then draw back everything which crosses it
+    size_t row_size = sxbp_bitmap_row_size(live->image.width);
+    for(uint32_t row = dirty->y; row < dirty->y + dirty->height; row++) {
+        clear_row(
+            live->image.pixels + (row * row_size),
+            dirty->x, dirty->x + dirty->width - 1
+        );
+    }
+    draw_live_region(live, spiral, *dirty);
+    return SXBP_OPERATION_OK;
+}
+
+void sxbp_free_live_render(sxbp_live_render_t* live) {
+    sxbp_free_bitmap(&live->image);
+    free_live_cells(live);
+    free(live->lengths);
+    free(live->ends);
+    live->lengths = NULL;
+    live->ends = NULL;
+}
+
+// private type, a spiral waiting to be packed into an atlas
+typedef struct atlas_item_t {
+    sxbp_spiral_stats_t stats;
+    size_t index;
+} atlas_item_t;
+
+/*
+ * private function, orders spirals waiting to be packed so that the tallest
+ * comes first, for qsort(). As qsort() isn't stable, equally tall spirals are
+ * kept in the order they were given in.
+ */
+static int compare_atlas_items(const void* a, const void* b) {
+    const atlas_item_t* item_a = (const atlas_item_t*)a;
+    const atlas_item_t* item_b = (const atlas_item_t*)b;
+    uint32_t height_a = item_a->stats.height;
+    uint32_t height_b = item_b->stats.height;
+    if(height_a != height_b) {
+        return (height_a < height_b) - (height_a > height_b);
+    }
+    return (item_a->index > item_b->index) - (item_a->index < item_b->index);
+}
+
+/*
+ * private function, draws the spiral onto image with the top-left corner of
+ * its own image at the given position, using runs of pixels rather than
+ * setting one pixel at a time
+ */
+static void draw_spiral_at(
+    sxbp_spiral_t spiral, sxbp_spiral_stats_t stats, sxbp_bitmap_t* image,
+    uint32_t left, uint32_t top
+) {
+    size_t row_size = sxbp_bitmap_row_size(image->width);
+    // a line is at most two runs of pixels, which are flipped by the list
+    sxbp_segment_t segments[2];
+    sxbp_segment_list_t list = {
+        .width = stats.width, .height = stats.height,
+        .segments = segments, .size = 0,
+    };
+    int64_t x = ((0 - (int64_t)stats.min.x) * 2) + 1;
+    int64_t y = ((0 - (int64_t)stats.min.y) * 2) + 1;
+    for(size_t i = 0; i < spiral.size; i++) {
+        list.size = 0;
+        add_line_segments(&list, spiral, i, &x, &y);
+        for(size_t j = 0; j < list.size; j++) {
+            for(uint32_t row = segments[j].y0; row <= segments[j].y1; row++) {
+                fill_row(
+                    image->pixels + ((top + row) * row_size),
+                    left + segments[j].x0, left + segments[j].x1
+                );
+            }
+        }
+    }
+}
+
+sxbp_status_t sxbp_render_spiral_atlas(
+    const sxbp_spiral_t* spirals, size_t count, uint32_t max_width,
+    uint32_t spacing, sxbp_bitmap_t* image, sxbp_pixel_rect_t* placements
+) {
+    // preconditional assertions
+    assert(spirals != NULL);
+    assert(image->pixels == NULL);
+    assert(placements != NULL);
+    // always allocate something, so that an empty atlas needs no special case
+    atlas_item_t* items = malloc(
+        (count > 0 ? count : 1) * sizeof(atlas_item_t)
+    );
+    if(items == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // find the size of every spiral, and the space they need between them
+    uint32_t widest = 0;
+    uint64_t area = 0;
+    for(size_t i = 0; i < count; i++) {
+        assert(spirals[i].lines != NULL);
+        sxbp_spiral_stats_t stats = sxbp_spiral_stats(spirals[i]);
+        placements[i].width = stats.width;
+        placements[i].height = stats.height;
+        items[i].stats = stats;
+        items[i].index = i;
+        widest = (stats.width > widest) ? stats.width : widest;
+        area += (
+            ((uint64_t)stats.width + spacing) *
+            ((uint64_t)stats.height + spacing)
+        );
+    }
+    if(max_width == 0) {
+        // aim for a square, assuming the shelves are packed tightly
+        max_width = (uint32_t)ceil(sqrt((double)area));
+    }
+    max_width = (max_width > widest) ? max_width : widest;
+    // pack the spirals onto shelves, tallest first
+    qsort(items, count, sizeof(atlas_item_t), compare_atlas_items);
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t shelf_top = 0;
+    uint32_t shelf_height = 0;
+    uint32_t shelf_right = 0;
+    for(size_t i = 0; i < count; i++) {
+        sxbp_pixel_rect_t* place = &placements[items[i].index];
+        uint32_t gap = (shelf_right > 0) ? spacing : 0;
+        if(shelf_right > 0 && shelf_right + gap + place->width > max_width) {
+            // start a new shelf below the last one
+            shelf_top += shelf_height + spacing;
+            shelf_height = 0;
+            shelf_right = 0;
+            gap = 0;
+        }
+        place->x = shelf_right + gap;
+        place->y = shelf_top;
+        shelf_right = place->x + place->width;
+        // the first spiral on each shelf is the tallest
+        shelf_height = (shelf_height > 0) ? shelf_height : place->height;
+        width = (shelf_right > width) ? shelf_right : width;
+        height = shelf_top + shelf_height;
+    }
+    sxbp_status_t result = sxbp_init_bitmap(width, height, image);
+    if(result == SXBP_OPERATION_OK) {
+        for(size_t i = 0; i < count; i++) {
+            sxbp_pixel_rect_t place = placements[items[i].index];
+            draw_spiral_at(
+                spirals[items[i].index], items[i].stats, image,
+                place.x, place.y
+            );
+        }
+    }
+    free(items);
+    return result;
 }
 
 #ifdef __cplusplus
@@ -23,6 +23,7 @@
 #define SAXBOPHONE_SAXBOSPIRAL_RENDER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "saxbospiral.h"
@@ -34,7 +35,7 @@ extern "C"{
 
 /**
  * @brief Used to represent a basic 1-bit, pure black/white bitmap image.
- * @details The image has integer height and width, and a 2-dimensional array of
+ * @details The image has integer height and width, and a contiguous array of
  * 1-bit pixels which are either black or white.
  */
 typedef struct sxbp_bitmap_t {
@@ -43,16 +44,546 @@ typedef struct sxbp_bitmap_t {
     /** @brief The height of the bitmap in pixels */
     uint32_t height;
     /**
-     * @brief A 2-dimensional array of pixels.
-     * @details false is black and true is white.
+     * @brief The pixels of the bitmap, packed 8 to a byte.
+     * @details Rows are stored from top to bottom, one after the other, and
+     * each row takes up sxbp_bitmap_row_size() bytes. The pixels of each row
+     * are stored from left to right, most significant bit first. A set bit is
+     * black and a clear bit is white. Any unused bits at the end of each row
+     * are always clear. This is the same layout as the pixel data of a binary
+     * PBM image.
      */
-    bool** pixels;
+    uint8_t* pixels;
 } sxbp_bitmap_t;
 
+/**
+ * @brief Calculates the number of bytes taken up by each row of a bitmap.
+ *
+ * @param width The width of the bitmap in pixels.
+ * @return The number of bytes in each row of the bitmap.
+ */
+size_t sxbp_bitmap_row_size(uint32_t width);
+
+/**
+ * @brief Allocates the pixels of a bitmap, all of which are set to white.
+ *
+ * @param width The width of the bitmap in pixels.
+ * @param height The height of the bitmap in pixels.
+ * @param[out] bitmap The bitmap to initialise.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That bitmap->pixels is NULL
+ */
+sxbp_status_t sxbp_init_bitmap(
+    uint32_t width, uint32_t height, sxbp_bitmap_t* bitmap
+);
+
+/**
+ * @brief Frees the pixels of a bitmap.
+ *
+ * @param[in,out] bitmap The bitmap to free.
+ */
+void sxbp_free_bitmap(sxbp_bitmap_t* bitmap);
+
+/**
+ * @brief Used to represent an 8-bit greyscale image.
+ * @details Each pixel gives how much of its area is covered by the line of
+ * the spiral, from 0 (not covered, white) to 255 (fully covered, black).
+ */
+typedef struct sxbp_greymap_t {
+    /** @brief The width of the image in pixels */
+    uint32_t width;
+    /** @brief The height of the image in pixels */
+    uint32_t height;
+    /**
+     * @brief The pixels of the image, one byte each.
+     * @details Rows are stored from top to bottom, one after the other, and
+     * each row takes up width bytes.
+     */
+    uint8_t* pixels;
+} sxbp_greymap_t;
+
+/**
+ * @brief Frees the pixels of a greyscale image.
+ *
+ * @param[in,out] greymap The image to free.
+ */
+void sxbp_free_greymap(sxbp_greymap_t* greymap);
+
+/**
+ * @brief Gets whether a pixel of a bitmap is black.
+ *
+ * @param bitmap The bitmap to read from.
+ * @param x The x co-ordinate of the pixel, from the left.
+ * @param y The y co-ordinate of the pixel, from the top.
+ * @return true if the pixel is black, false if it is white.
+ *
+ * @note Asserts:
+ * - That bitmap.pixels is not NULL
+ * - That x is less than bitmap.width
+ * - That y is less than bitmap.height
+ */
+bool sxbp_get_bitmap_pixel(sxbp_bitmap_t bitmap, uint32_t x, uint32_t y);
+
+/**
+ * @brief A horizontal or vertical run of black pixels in the image of a
+ * spiral.
+ * @details Co-ordinates are in pixels from the top-left of the image, and both
+ * ends of the run are inclusive, so a single pixel has x0 == x1 and y0 == y1.
+ * Either x0 == x1 or y0 == y1, and x0 <= x1 and y0 <= y1 always.
+ */
+typedef struct sxbp_segment_t {
+    /** @brief The x co-ordinate of the left end of the run */
+    uint32_t x0;
+    /** @brief The y co-ordinate of the top end of the run */
+    uint32_t y0;
+    /** @brief The x co-ordinate of the right end of the run */
+    uint32_t x1;
+    /** @brief The y co-ordinate of the bottom end of the run */
+    uint32_t y1;
+} sxbp_segment_t;
+
+/**
+ * @brief The runs of black pixels which make up the image of a spiral.
+ */
+typedef struct sxbp_segment_list_t {
+    /** @brief The width of the image in pixels */
+    uint32_t width;
+    /** @brief The height of the image in pixels */
+    uint32_t height;
+    /**
+     * @brief The smallest co-ords reached by the spiral, whose pixel is one
+     * pixel in from the bottom-left corner of the image
+     */
+    sxbp_co_ord_t bottom_left;
+    /** @brief The runs of pixels, one per line of the spiral */
+    sxbp_segment_t* segments;
+    /** @brief The number of runs of pixels */
+    size_t size;
+} sxbp_segment_list_t;
+
+/**
+ * @brief Converts the lines of a spiral into the runs of pixels which make up
+ * its image.
+ * @details The image is exactly that drawn by sxbp_render_spiral_raw(), but
+ * is described in space proportional to the number of lines, rather than to
+ * the area of the image. The runs are in the same order as the lines, apart
+ * from the first line, which is split into two runs as its second pixel is
+ * never drawn. The bounds of the image are found from the ends of the lines,
+ * so the spiral's co-ord cache is neither used nor modified.
+ *
+ * @param spiral The spiral to convert.
+ * @param[out] list The list of runs of pixels to write to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That list->segments is NULL
+ */
+sxbp_status_t sxbp_spiral_segments(
+    sxbp_spiral_t spiral, sxbp_segment_list_t* list
+);
+
+/**
+ * @brief Frees the memory held by a list of runs of pixels.
+ *
+ * @param[in,out] list The list to free.
+ */
+void sxbp_free_segment_list(sxbp_segment_list_t* list);
+
+/**
+ * @brief A run of black pixels within one row of a run-length encoded bitmap.
+ */
+typedef struct sxbp_rle_run_t {
+    /** @brief The x co-ordinate of the leftmost pixel of the run */
+    uint32_t x;
+    /** @brief The number of pixels in the run, never 0 */
+    uint32_t length;
+} sxbp_rle_run_t;
+
+/**
+ * @brief Used to represent a 1-bit bitmap image as the runs of black pixels
+ * in each of its rows.
+ * @details The runs of each row are in order from left to right, and never
+ * overlap or touch, so any two runs are separated by at least one white pixel.
+ * This takes space proportional to the length of the line of a spiral rather
+ * than to the area of its image.
+ */
+typedef struct sxbp_rle_bitmap_t {
+    /** @brief The width of the bitmap in pixels */
+    uint32_t width;
+    /** @brief The height of the bitmap in pixels */
+    uint32_t height;
+    /**
+     * @brief Where the runs of each row start in runs, with one more element
+     * than there are rows.
+     * @details The runs of row y are runs[row_starts[y]] up to but not
+     * including runs[row_starts[y + 1]].
+     */
+    size_t* row_starts;
+    /** @brief The runs of all rows, from the top row down */
+    sxbp_rle_run_t* runs;
+} sxbp_rle_bitmap_t;
+
+/**
+ * @brief Renders the line of a spiral to a run-length encoded bitmap.
+ * @details The pixels are identical to those of sxbp_render_spiral_raw(), but
+ * they are built straight from the runs of pixels given by
+ * sxbp_spiral_segments(), so horizontal lines take up one run and vertical
+ * lines one run per row. Memory use and time taken are proportional to the
+ * length of the line rather than to the area of the image.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param[out] image The run-length encoded bitmap to write to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That image->runs is NULL
+ */
+sxbp_status_t sxbp_render_spiral_rle(
+    sxbp_spiral_t spiral, sxbp_rle_bitmap_t* image
+);
+
+/**
+ * @brief Frees the memory held by a run-length encoded bitmap.
+ *
+ * @param[in,out] image The bitmap to free.
+ */
+void sxbp_free_rle_bitmap(sxbp_rle_bitmap_t* image);
+
+/**
+ * @brief Writes out the pixels of one row of a run-length encoded bitmap.
+ * @details This lets image formats which store pixels be written from a
+ * run-length encoded bitmap one row at a time.
+ *
+ * @param image The bitmap to read from.
+ * @param y The row to read, from the top.
+ * @param[out] row Where to write the pixels of the row, packed in the same
+ * way as a single row of sxbp_bitmap_t, taking up sxbp_bitmap_row_size()
+ * bytes.
+ *
+ * @note Asserts:
+ * - That image.runs is not NULL
+ * - That y is less than image.height
+ */
+void sxbp_get_rle_bitmap_row(sxbp_rle_bitmap_t image, uint32_t y, uint8_t* row);
+
+/**
+ * @brief Renders a spiral one row of pixels at a time, without ever holding
+ * the whole image in memory.
+ * @details The rows are generated from top to bottom from the runs of pixels
+ * of the spiral, sorted by their top row, so peak memory use is proportional
+ * to the width of the image plus the number of lines, rather than to the area
+ * of the image. The pixels are identical to those of sxbp_render_spiral_raw().
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param begin_callback An optional function pointer with the following
+ * signature:
+ * @code
+ * sxbp_status_t callback_name(uint32_t width, uint32_t height, void* user_data)
+ * @endcode
+ * It is called once with the dimensions of the image before any rows are
+ * rendered.
+ * @param row_callback A function pointer with the following signature:
+ * @code
+ * sxbp_status_t callback_name(const uint8_t* row, uint32_t y, void* user_data)
+ * @endcode
+ * It is called once for each row, in order from the top, with the pixels of
+ * the row packed in the same way as a single row of sxbp_bitmap_t. The row is
+ * only valid until the callback returns.
+ * @param user_data An optional void pointer which is passed on to the
+ * callbacks.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ * @return Any failure status returned by either callback, which stops
+ * rendering.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That row_callback is not NULL
+ */
+sxbp_status_t sxbp_render_spiral_rows(
+    sxbp_spiral_t spiral,
+    sxbp_status_t(* begin_callback)(
+        uint32_t width, uint32_t height, void* user_data
+    ),
+    sxbp_status_t(* row_callback)(
+        const uint8_t* row, uint32_t y, void* user_data
+    ),
+    void* user_data
+);
+
+/**
+ * @brief Renders a spiral as a grid of tiles, so that only one tile of the
+ * image is held in memory at once.
+ * @details The runs of pixels of the spiral are first sorted into a grid
+ * matching the tiles, so that each tile is only drawn from the runs which
+ * cross it. The tiles are rendered in order from left to right, then top to
+ * bottom. Tiles on the right and bottom edges of the image are cropped to fit
+ * it, so may be smaller than the requested size. Tiles as wide as the image
+ * are bands of whole rows, which may be written straight out one after the
+ * other, for example as the pixels of a PBM image. The pixels of the tiles
+ * are identical to those of sxbp_render_spiral_raw().
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param tile_width The width of each tile in pixels, or 0 for tiles as wide
+ * as the image.
+ * @param tile_height The height of each tile in pixels, or 0 for tiles as tall
+ * as the image.
+ * @param memory_limit The maximum number of bytes of memory which may be
+ * allocated for rendering, including the tile and the grid of runs of pixels,
+ * or 0 for no limit.
+ * @param begin_callback An optional function pointer as accepted by
+ * sxbp_render_spiral_rows(), called once with the dimensions of the whole
+ * image before any tiles are rendered.
+ * @param tile_callback A function pointer with the following signature:
+ * @code
+ * sxbp_status_t callback_name(
+ *     sxbp_bitmap_t tile, uint32_t x, uint32_t y, void* user_data
+ * )
+ * @endcode
+ * It is called once for each tile, with the co-ordinates of its top-left
+ * pixel within the image. The tile is only valid until the callback returns
+ * and must not be freed.
+ * @param user_data An optional void pointer which is passed on to the
+ * callbacks.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure, or if rendering
+ * would need more memory than memory_limit, in which case smaller tiles may
+ * help.
+ * @return Any failure status returned by either callback, which stops
+ * rendering.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That tile_callback is not NULL
+ */
+sxbp_status_t sxbp_render_spiral_tiles(
+    sxbp_spiral_t spiral, uint32_t tile_width, uint32_t tile_height,
+    size_t memory_limit,
+    sxbp_status_t(* begin_callback)(
+        uint32_t width, uint32_t height, void* user_data
+    ),
+    sxbp_status_t(* tile_callback)(
+        sxbp_bitmap_t tile, uint32_t x, uint32_t y, void* user_data
+    ),
+    void* user_data
+);
+
+/**
+ * @brief Renders a spiral to a bitmap, sharing the work between multiple
+ * threads.
+ * @details The image is split into horizontal bands, and the runs of pixels
+ * of the spiral are sorted up front by which bands they cross, so that each
+ * band can be drawn independently without any locking. When the library is
+ * built with OpenMP support, the bands are drawn in parallel, otherwise they
+ * are drawn one after the other. The pixels are identical to those of
+ * sxbp_render_spiral_raw(), but the spiral's co-ord cache is neither used nor
+ * modified.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param[out] image The bitmap to write the image to. Memory for the pixels
+ * is allocated by this function and should be freed with sxbp_free_bitmap().
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That image->pixels is NULL
+ */
+sxbp_status_t sxbp_render_spiral_parallel(
+    sxbp_spiral_t spiral, sxbp_bitmap_t* image
+);
+
+/**
+ * @brief A spatial index of the runs of pixels of a spiral, for rendering
+ * parts of it quickly.
+ * @details All fields other than list are private, an index should only be
+ * manipulated with the functions in this compilation unit.
+ */
+typedef struct sxbp_segment_index_t {
+    /** @brief The runs of pixels of the spiral */
+    sxbp_segment_list_t list;
+    /**
+     * @brief the width and height of each cell of the index, in pixels
+     * @private
+     */
+    uint32_t cell_size;
+    /**
+     * @brief the number of cells across the image
+     * @private
+     */
+    uint32_t across;
+    /**
+     * @brief the number of cells down the image
+     * @private
+     */
+    uint32_t down;
+    /**
+     * @brief index into runs of the first run of each cell, plus one past the
+     * end
+     * @private
+     */
+    size_t* starts;
+    /**
+     * @brief indexes of the runs of pixels crossing each cell, cell by cell
+     * @private
+     */
+    size_t* runs;
+} sxbp_segment_index_t;
+
+/**
+ * @brief A rectangular region of the co-ordinate space of a spiral, and the
+ * size it should be rendered at.
+ * @details Each unit of co-ordinate space is scale pixels wide, so that a
+ * scale of 2.0 matches sxbp_render_spiral_raw(). Lines are always drawn 1
+ * pixel thick.
+ */
+typedef struct sxbp_viewport_t {
+    /** @brief The x co-ordinate of the left edge of the region */
+    double x;
+    /** @brief The y co-ordinate of the bottom edge of the region */
+    double y;
+    /** @brief The width of the rendered region in pixels */
+    uint32_t width;
+    /** @brief The height of the rendered region in pixels */
+    uint32_t height;
+    /** @brief The number of pixels per unit of co-ordinate space */
+    double scale;
+} sxbp_viewport_t;
+
+/**
+ * @brief Builds a spatial index of the runs of pixels of a spiral.
+ * @details The image of the spiral is split into a grid of square cells, and
+ * each run of pixels is listed under every cell it crosses. An index only
+ * needs building once for a spiral which doesn't change, and can then be used
+ * to render many viewports of it.
+ *
+ * @param spiral The spiral to index.
+ * @param[out] index The index to build.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That index->list.segments is NULL
+ */
+sxbp_status_t sxbp_index_spiral_segments(
+    sxbp_spiral_t spiral, sxbp_segment_index_t* index
+);
+
+/**
+ * @brief Frees the memory held by a spatial index of the runs of pixels of a
+ * spiral.
+ *
+ * @param[in,out] index The index to free.
+ */
+void sxbp_free_segment_index(sxbp_segment_index_t* index);
+
+/**
+ * @brief Gives the viewport which shows the whole of an indexed spiral at the
+ * given scale.
+ * @details At a scale of 2.0, rendering this viewport gives an image identical
+ * to that of sxbp_render_spiral_raw().
+ *
+ * @param index The index of the spiral.
+ * @param scale The number of pixels per unit of co-ordinate space.
+ * @return The viewport showing the whole spiral.
+ */
+sxbp_viewport_t sxbp_spiral_viewport(
+    const sxbp_segment_index_t* index, double scale
+);
+
+/**
+ * @brief Renders a region of an indexed spiral to a bitmap.
+ * @details Only the cells of the index which are visible in the viewport are
+ * visited, so the time taken is proportional to the size of the viewport and
+ * the number of lines which are visible in it, rather than to the size of the
+ * whole spiral.
+ *
+ * @param index The index of the spiral which should be rendered.
+ * @param viewport The region of the spiral to render.
+ * @param[out] image The bitmap to write the image to, which is
+ * viewport.width by viewport.height pixels. Memory for the pixels is
+ * allocated by this function and should be freed with sxbp_free_bitmap().
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That index->list.segments is not NULL
+ * - That viewport.scale is greater than 0
+ * - That image->pixels is NULL
+ */
+sxbp_status_t sxbp_render_spiral_viewport(
+    const sxbp_segment_index_t* index, sxbp_viewport_t viewport,
+    sxbp_bitmap_t* image
+);
+
+/**
+ * @brief Renders a spiral to a greyscale image smaller than its full size.
+ * @details Each pixel of the image stands for a square block of factor by
+ * factor pixels of the image which sxbp_render_spiral_raw() gives, and is
+ * shaded by how many of them are black. Blocks overhanging the right and
+ * bottom edges count the missing pixels as white. The spiral is rendered with
+ * sxbp_render_spiral_rows(), so the full size image is never held in memory.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param factor How many times smaller the image should be than the full
+ * size image, along each side.
+ * @param[out] image The greyscale image to write to. Memory for the pixels is
+ * allocated by this function and should be freed with sxbp_free_greymap().
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That factor is not 0
+ * - That image->pixels is NULL
+ */
+sxbp_status_t sxbp_render_spiral_scaled(
+    sxbp_spiral_t spiral, uint32_t factor, sxbp_greymap_t* image
+);
+
+/**
+ * @brief Renders a spiral to a series of greyscale images, each half the size
+ * of the one before.
+ * @details The first image is rendered with sxbp_render_spiral_scaled() at
+ * the given factor, and each following image is made by averaging blocks of
+ * 2 by 2 pixels of the one before, so is the same as rendering at twice the
+ * factor, give or take one shade of grey for rounding.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param factor How many times smaller the first image should be than the
+ * full size image, along each side.
+ * @param levels The number of images to render.
+ * @param[out] images An array of levels greyscale images to write to. Memory
+ * for the pixels is allocated by this function and each image should be freed
+ * with sxbp_free_greymap(). On failure, none are left allocated.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That factor is not 0
+ * - That the pixels of each image are NULL
+ */
+sxbp_status_t sxbp_render_spiral_mipmap(
+    sxbp_spiral_t spiral, uint32_t factor, size_t levels,
+    sxbp_greymap_t* images
+);
+
 /**
  * @brief Renders the line of a spiral to a bitmap.
  * @details The lines of the spiral are plotted on a white background and the
  * pixel data representing the resulting shape is written to the given image.
+ * Only the lines of the spiral are read, so its co-ord cache does not need to
+ * be valid and is never modified. This means that a spiral may be rendered
+ * straight after it has been solved, and that one spiral may be rendered from
+ * multiple threads at once.
  *
  * @param spiral The spiral which should be rendered.
  * @param[out] image The bitmap to write the pixel data out to.
@@ -107,6 +638,304 @@ sxbp_status_t sxbp_render_spiral_image(
     )
 );
 
+/**
+ * @brief Holds memory which is kept between renders of many spirals, so that
+ * it doesn't need allocating again for each one.
+ * @details All fields are private, a render context should only be
+ * manipulated with the functions in this compilation unit. Memory is only
+ * ever grown, when a spiral is rendered which needs more than any before it.
+ * A render context must only be used by one thread at a time, but each thread
+ * may have its own.
+ */
+typedef struct sxbp_render_context_t {
+    /**
+     * @brief the bitmap which the last spiral was rendered to
+     * @private
+     */
+    sxbp_bitmap_t bitmap;
+    /**
+     * @brief the number of bytes allocated for the pixels of the bitmap
+     * @private
+     */
+    size_t pixels_capacity;
+    /**
+     * @brief the memory which image files are written into, where size is the
+     * number of bytes allocated
+     * @private
+     */
+    sxbp_buffer_t output;
+} sxbp_render_context_t;
+
+/**
+ * @brief Creates an empty render context, which holds no memory yet.
+ *
+ * @return A render context which is ready to be used.
+ */
+sxbp_render_context_t sxbp_blank_render_context(void);
+
+/**
+ * @brief Frees the memory held by a render context, leaving it empty.
+ *
+ * @param[in,out] context The render context to free.
+ */
+void sxbp_free_render_context(sxbp_render_context_t* context);
+
+/**
+ * @brief Renders the line of a spiral to a bitmap held by a render context.
+ * @details The pixels are identical to those drawn by
+ * sxbp_render_spiral_raw(), but the memory of the bitmap is re-used from the
+ * last spiral rendered with the same context whenever it is large enough.
+ *
+ * @param[in,out] context The render context to render with.
+ * @param spiral The spiral which should be rendered.
+ * @param[out] image The bitmap to give the rendered image in. Its pixels
+ * belong to the context, so must not be freed, and are only valid until the
+ * context is next used or freed.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ */
+sxbp_status_t sxbp_render_spiral_raw_pooled(
+    sxbp_render_context_t* context, sxbp_spiral_t spiral, sxbp_bitmap_t* image
+);
+
+/**
+ * @brief Renders the line of a spiral to an image format, using memory held
+ * by a render context.
+ * @details This works in the same way as sxbp_render_spiral_image(), except
+ * that both the bitmap and the image file are written to memory which the
+ * context keeps between renders, so rendering many spirals of similar sizes
+ * allocates almost no memory once the first has been rendered. The callbacks
+ * have the same signatures as the size and `_into` functions of the render
+ * backends, so for example:
+ * @code
+ * sxbp_render_spiral_image_pooled(
+ *     &context, spiral, sxbp_render_backend_png_builtin_size_bound,
+ *     sxbp_render_backend_png_builtin_into, &buffer
+ * );
+ * @endcode
+ *
+ * @param[in,out] context The render context to render with.
+ * @param spiral The spiral which should be rendered.
+ * @param size_callback A function pointer with the following signature:
+ * @code
+ * size_t callback_name(sxbp_bitmap_t image)
+ * @endcode
+ * It should return how much memory image_writer_callback needs to write the
+ * image file of the given bitmap.
+ * @param image_writer_callback A function pointer with the following
+ * signature:
+ * @code
+ * sxbp_status_t callback_name(
+ *     sxbp_bitmap_t image, sxbp_buffer_t buffer, size_t* bytes_written
+ * )
+ * @endcode
+ * It should write the image file of the bitmap into buffer and store the
+ * number of bytes written in bytes_written.
+ * @param[out] buffer The buffer to give the image file in. Its bytes belong to
+ * the context, so must not be freed, and are only valid until the context is
+ * next used or freed.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ * @return Any other status which image_writer_callback returned.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That neither function pointer is NULL
+ */
+sxbp_status_t sxbp_render_spiral_image_pooled(
+    sxbp_render_context_t* context, sxbp_spiral_t spiral,
+    size_t(* size_callback)(sxbp_bitmap_t image),
+    sxbp_status_t(* image_writer_callback)(
+        sxbp_bitmap_t image, sxbp_buffer_t buffer, size_t* bytes_written
+    ),
+    sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief A rectangle of pixels within an image.
+ * @details Co-ordinates are in pixels from the top-left of the image. An empty
+ * rectangle has a width and height of 0.
+ */
+typedef struct sxbp_pixel_rect_t {
+    /** @brief The x co-ordinate of the left column of the rectangle */
+    uint32_t x;
+    /** @brief The y co-ordinate of the top row of the rectangle */
+    uint32_t y;
+    /** @brief The width of the rectangle in pixels */
+    uint32_t width;
+    /** @brief The height of the rectangle in pixels */
+    uint32_t height;
+} sxbp_pixel_rect_t;
+
+/**
+ * @brief The lines of a spiral which cross one cell of the grid which a live
+ * render divides its image into.
+ * @private
+ */
+typedef struct sxbp_live_cell_t {
+    /** @brief the indexes of the lines crossing the cell, in any order */
+    uint32_t* lines;
+    /** @brief the count of lines crossing the cell */
+    uint32_t count;
+    /** @brief the count of lines which memory is allocated for */
+    uint32_t capacity;
+} sxbp_live_cell_t;
+
+/**
+ * @brief Keeps the image of a spiral up to date while it is being solved, by
+ * redrawing only the parts of it which change.
+ * @details All fields other than image are private, a live render should only
+ * be manipulated with the functions in this compilation unit.
+ */
+typedef struct sxbp_live_render_t {
+    /**
+     * @brief The image of the spiral as of the last update. Its pixels belong
+     * to the live render, so must not be freed.
+     */
+    sxbp_bitmap_t image;
+    /**
+     * @brief the smallest co-ords reached by the spiral as of the last update
+     * @private
+     */
+    sxbp_co_ord_t bottom_left;
+    /**
+     * @brief the largest co-ords reached by the spiral as of the last update
+     * @private
+     */
+    sxbp_co_ord_t top_right;
+    /**
+     * @brief how many of the origin and the ends of the lines lie on each edge
+     * of the bounds, in the order left, bottom, right, top
+     * @private
+     */
+    uint32_t edge_counts[4];
+    /**
+     * @brief the line lengths as of the last update
+     * @private
+     */
+    sxbp_length_t* lengths;
+    /**
+     * @brief the co-ord at the end of each line as of the last update
+     * @private
+     */
+    sxbp_co_ord_t* ends;
+    /**
+     * @brief the grid of cells which the image is divided into, row by row
+     * from the top, each listing the lines which cross it
+     * @private
+     */
+    sxbp_live_cell_t* cells;
+    /**
+     * @brief the count of columns of cells in the grid
+     * @private
+     */
+    uint32_t cells_across;
+    /**
+     * @brief the count of rows of cells in the grid
+     * @private
+     */
+    uint32_t cells_down;
+    /**
+     * @brief the count of lines in the spiral being rendered
+     * @private
+     */
+    uint32_t size;
+} sxbp_live_render_t;
+
+/**
+ * @brief Starts a live render of a spiral, rendering the whole of it.
+ * @details The image is identical to that drawn by sxbp_render_spiral_raw().
+ *
+ * @param spiral The spiral to render.
+ * @param[out] live The live render to start.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That live->image.pixels is NULL
+ */
+sxbp_status_t sxbp_begin_live_render(
+    sxbp_spiral_t spiral, sxbp_live_render_t* live
+);
+
+/**
+ * @brief Brings the image of a live render up to date with the spiral.
+ * @details The lines whose lengths have changed since the last update are
+ * found by comparing them with the lengths kept by the live render. This scan
+ * is the only part of an update which visits every line, and it only compares
+ * lengths. The ends of the lines and the bounds of the spiral are kept by the
+ * live render, so only the changed lines, and any after them which they move,
+ * are walked. Only the rectangle of pixels which these lines covered before
+ * and cover now is cleared, and the image is divided into a grid of cells
+ * which each list the lines crossing them, so only the lines crossing the
+ * cells under the rectangle are drawn back. If the bounds of the spiral have
+ * changed, though, the whole image moves and is redrawn at its new size,
+ * which visits every line.
+ * Either way, the image is afterwards identical to that drawn by
+ * sxbp_render_spiral_raw(). This is suitable for calling from the progress
+ * callback of sxbp_plot_spiral(), to show a spiral as it is solved.
+ *
+ * @param[in,out] live The live render to update.
+ * @param spiral The spiral which the live render was started for.
+ * @param[out] dirty The rectangle of pixels which may have changed, which is
+ * empty if nothing changed, and the whole image if its size or position
+ * changed.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure, in which case the
+ * live render should be freed.
+ *
+ * @note Asserts:
+ * - That live->lengths is not NULL
+ * - That spiral.lines is not NULL
+ * - That spiral.size is the size of the spiral the live render was started
+ * for
+ */
+sxbp_status_t sxbp_update_live_render(
+    sxbp_live_render_t* live, sxbp_spiral_t spiral, sxbp_pixel_rect_t* dirty
+);
+
+/**
+ * @brief Frees the memory held by a live render.
+ *
+ * @param[in,out] live The live render to free.
+ */
+void sxbp_free_live_render(sxbp_live_render_t* live);
+
+/**
+ * @brief Renders many spirals side by side into one bitmap, such as for a
+ * contact sheet of thumbnails.
+ * @details The bounding boxes of the spirals are packed onto shelves, tallest
+ * first: each shelf is filled from left to right until the next box doesn't
+ * fit, when a new shelf is started below it. Each spiral is then drawn
+ * straight into its place, exactly as sxbp_render_spiral_raw() would draw it
+ * on its own, so the whole sheet can be encoded once with any backend.
+ *
+ * @param spirals The spirals to render.
+ * @param count The number of spirals.
+ * @param max_width The widest the bitmap may be in pixels, or 0 to pick a
+ * width which makes the bitmap roughly square. The bitmap is always at least
+ * as wide as the widest spiral.
+ * @param spacing The number of white pixels to leave between spirals.
+ * @param[out] image The bitmap to render the spirals to.
+ * @param[out] placements An array of count rectangles, to which the position
+ * of each spiral within the bitmap is written.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spirals is not NULL
+ * - That image->pixels is NULL
+ * - That placements is not NULL
+ */
+sxbp_status_t sxbp_render_spiral_atlas(
+    const sxbp_spiral_t* spirals, size_t count, uint32_t max_width,
+    uint32_t spacing, sxbp_bitmap_t* image, sxbp_pixel_rect_t* placements
+);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
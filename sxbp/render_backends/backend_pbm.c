@@ -10,7 +10,6 @@
  */
 #include <assert.h>
 #include <inttypes.h>
-#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -26,81 +25,165 @@
 extern "C"{
 #endif
 
+// the longest PBM header possible, including the null-terminator
+#define PBM_HEADER_MAX_SIZE 26
+
+/*
+ * private function, writes the header of a PBM image of the given bitmap to
+ * header, which must have room for at least PBM_HEADER_MAX_SIZE chars.
+ * Returns the length of the header.
+ */
+static size_t pbm_header(sxbp_bitmap_t bitmap, char* header) {
+    /*
+     * the width and height may be up to 10 characters each (max uint32_t is
+     * 10 digits long), each followed by whitespace after the "P4" magic number
+     */
+    return (size_t)sprintf(
+        header, "P4\n%" PRIu32 "\n%" PRIu32 "\n", bitmap.width, bitmap.height
+    );
+}
+
+/*
+ * private type, the user data given to the callbacks of
+ * sxbp_render_spiral_rows() when streaming a PBM image
+ */
+typedef struct pbm_stream_t {
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data);
+    void* user_data;
+    size_t row_size;
+} pbm_stream_t;
+
+// private function, writes the PBM header once the image size is known
+static sxbp_status_t pbm_stream_begin(
+    uint32_t width, uint32_t height, void* user_data
+) {
+    pbm_stream_t* stream = (pbm_stream_t*)user_data;
+    sxbp_bitmap_t bitmap = { .width = width, .height = height, };
+    char header[PBM_HEADER_MAX_SIZE];
+    size_t header_size = pbm_header(bitmap, header);
+    stream->row_size = sxbp_bitmap_row_size(width);
+    if(
+        stream->write_callback(
+            (const uint8_t*)header, header_size, stream->user_data
+        ) != header_size
+    ) {
+        return SXBP_OPERATION_FAIL;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+// disable GCC warning about the unused parameter, rows are always in order
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+// private function, writes one row of pixels, which are already in PBM format
+static sxbp_status_t pbm_stream_row(
+    const uint8_t* row, uint32_t y, void* user_data
+) {
+    pbm_stream_t* stream = (pbm_stream_t*)user_data;
+    if(
+        stream->write_callback(row, stream->row_size, stream->user_data) !=
+        stream->row_size
+    ) {
+        return SXBP_OPERATION_FAIL;
+    }
+    return SXBP_OPERATION_OK;
+}
+// re-enable all warnings
+#pragma GCC diagnostic pop
+
+size_t sxbp_render_backend_pbm_size(sxbp_bitmap_t bitmap) {
+    char header[PBM_HEADER_MAX_SIZE];
+    // header plus the bytes which make up the image pixels
+    return (
+        pbm_header(bitmap, header) +
+        (sxbp_bitmap_row_size(bitmap.width) * bitmap.height)
+    );
+}
+
+sxbp_status_t sxbp_render_backend_pbm_into(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t buffer, size_t* bytes_written
+) {
+    // preconditional assertsions
+    assert(bitmap.pixels != NULL);
+    assert(buffer.bytes != NULL);
+    *bytes_written = 0;
+    char header[PBM_HEADER_MAX_SIZE];
+    size_t index = pbm_header(bitmap, header);
+    // calculate number of bytes for the entire image pixels (rows and columns)
+    size_t image_bytes = sxbp_bitmap_row_size(bitmap.width) * bitmap.height;
+    // check that the image will fit in the space provided
+    if(buffer.size < index + image_bytes) {
+        return SXBP_OPERATION_FAIL;
+    }
+    memcpy(buffer.bytes, header, index);
+    /*
+     * bitmaps are packed into rows to the nearest byte, with black pixels as
+     * 1 bits, just like in PBM format, so the pixels can be copied as they are
+     */
+    memcpy(buffer.bytes + index, bitmap.pixels, image_bytes);
+    index += image_bytes;
+    *bytes_written = index;
+    return SXBP_OPERATION_OK;
+}
+
 sxbp_status_t sxbp_render_backend_pbm(
     sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
 ) {
     // preconditional assertsions
     assert(bitmap.pixels != NULL);
     assert(buffer->bytes == NULL);
-    /*
-     * allocate two char arrays for the width and height strings - these may be
-     * up to 10 characters each (max uint32_t is 10 digits long), so allocate 2
-     * char arrays of 11 chars each (1 extra char for null-terminator)
-     */
-    char width_string[11], height_string[11];
-    // these are used to keep track of how many digits each is
-    int width_string_length, height_string_length = 0;
-    // convert width and height to a decimal string, store lengths
-    width_string_length = sprintf(width_string, "%" PRIu32, bitmap.width);
-    height_string_length = sprintf(height_string, "%" PRIu32, bitmap.height);
-    /*
-     * now that we know the length of the image dimension strings, we can now
-     * calculate how much memory we'll have to allocate for the image buffer
-     */
-    // calculate number of bytes per row - this is ceiling(width / 8)
-    size_t bytes_per_row = (size_t)ceil((double)bitmap.width / 8.0);
-    // calculate number of bytes for the entire image pixels (rows and columns)
-    size_t image_bytes = bytes_per_row * bitmap.height;
-    // finally put it all together to get total image buffer size
-    size_t image_buffer_size = (
-        3 // "P4" magic number + whitespace
-        + width_string_length + 1 // width of image in decimal + whitespace
-        + height_string_length + 1 // height of image in decimal + whitespace
-        + image_bytes // lastly, the bytes which make up the image pixels
-    );
+    // the exact size of the image is known up-front
+    size_t image_buffer_size = sxbp_render_backend_pbm_size(bitmap);
     // try and allocate the data for the buffer
-    buffer->bytes = calloc(image_buffer_size, sizeof(uint8_t));
+    buffer->bytes = malloc(image_buffer_size);
     // check fo memory allocation failure
     if(buffer->bytes == NULL) {
         return SXBP_MALLOC_REFUSED;
-    } else {
-        // set buffer size
-        buffer->size = image_buffer_size;
-        // otherwise carry on
-        size_t index = 0; // this index is used to index the buffer
-        // construct magic number + whitespace
-        memcpy(buffer->bytes + index, "P4\n", 3);
-        index += 3;
-        // image width
-        memcpy(buffer->bytes + index, width_string, width_string_length);
-        index += width_string_length;
-        // whitespace
-        memcpy(buffer->bytes + index, "\n", 1);
-        index += 1;
-        // image height
-        memcpy(buffer->bytes + index, height_string, height_string_length);
-        index += height_string_length;
-        // whitespace
-        memcpy(buffer->bytes + index, "\n", 1);
-        index += 1;
-        // now for the image data, packed into rows to the nearest byte
-        for(size_t y = 0; y < bitmap.height; y++) { // row loop
-            for(size_t x = 0; x < bitmap.width; x++) {
-                // byte index is index + floor(x / 8)
-                size_t byte_index = index + (x / 8);
-                // bit index is x mod 8
-                uint8_t bit_index = x % 8;
-                // write bits most-significant-bit first
-                buffer->bytes[byte_index] |= (
-                    // black pixel = bool true = 1, just like in PBM format
-                    bitmap.pixels[x][y] << (7 - bit_index)
-                );
-            }
-            // increment index so next row is written in the correct place
-            index += bytes_per_row;
-        }
-        return SXBP_OPERATION_OK;
     }
+    // set buffer size
+    buffer->size = image_buffer_size;
+    return sxbp_render_backend_pbm_into(bitmap, *buffer, &buffer->size);
+}
+
+sxbp_status_t sxbp_render_backend_pbm_rle(
+    sxbp_rle_bitmap_t image, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(image.runs != NULL);
+    assert(buffer->bytes == NULL);
+    sxbp_bitmap_t bitmap = { .width = image.width, .height = image.height, };
+    size_t row_size = sxbp_bitmap_row_size(image.width);
+    buffer->size = sxbp_render_backend_pbm_size(bitmap);
+    buffer->bytes = malloc(buffer->size);
+    if(buffer->bytes == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    char header[PBM_HEADER_MAX_SIZE];
+    size_t index = pbm_header(bitmap, header);
+    memcpy(buffer->bytes, header, index);
+    // each row is written straight into place, so no bitmap is needed
+    for(uint32_t y = 0; y < image.height; y++) {
+        sxbp_get_rle_bitmap_row(image, y, buffer->bytes + index);
+        index += row_size;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_backend_pbm_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+) {
+    // preconditional assertsions
+    assert(spiral.lines != NULL);
+    assert(write_callback != NULL);
+    pbm_stream_t stream = {
+        .write_callback = write_callback, .user_data = user_data,
+        .row_size = 0,
+    };
+    return sxbp_render_spiral_rows(
+        spiral, pbm_stream_begin, pbm_stream_row, (void*)&stream
+    );
 }
 
 #ifdef __cplusplus
@@ -25,6 +25,9 @@
 #ifndef SAXBOPHONE_SAXBOSPIRAL_BACKEND_PBM_H
 #define SAXBOPHONE_SAXBOSPIRAL_BACKEND_PBM_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "../saxbospiral.h"
 #include "../render.h"
 
@@ -49,6 +52,84 @@ sxbp_status_t sxbp_render_backend_pbm(
     sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
 );
 
+/**
+ * @brief Calculates the exact number of bytes of the PBM image of a bitmap.
+ *
+ * @param bitmap Bitmap containing the image to render. Only its width and
+ * height are used.
+ * @return The size of the PBM image in bytes.
+ */
+size_t sxbp_render_backend_pbm_size(sxbp_bitmap_t bitmap);
+
+/**
+ * @brief Renders a bitmap image to a PBM image in memory provided by the
+ * caller.
+ * @details The bytes written are identical to those written by
+ * sxbp_render_backend_pbm(), but no memory is allocated, so the same memory
+ * may be re-used for many images. sxbp_render_backend_pbm_size() gives how
+ * much is needed.
+ *
+ * @param bitmap Bitmap containing the image to render.
+ * @param buffer The memory to write the PBM image data to, where buffer.size
+ * is the number of bytes available.
+ * @param[out] bytes_written The number of bytes written to buffer, 0 on
+ * failure.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if buffer is too small for the image.
+ *
+ * @note Asserts:
+ * - That bitmap.pixels is not NULL
+ * - That buffer.bytes is not NULL
+ */
+sxbp_status_t sxbp_render_backend_pbm_into(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t buffer, size_t* bytes_written
+);
+
+/**
+ * @brief Renders a run-length encoded bitmap image to a PBM image.
+ * @details The bytes written are identical to those of
+ * sxbp_render_backend_pbm() for the same pixels. Each row is expanded straight
+ * into the buffer, so the pixels are never held in a bitmap.
+ *
+ * @param image Run-length encoded bitmap containing the image to render.
+ * @param[out] buffer Buffer to write out the PBM image data to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That image.runs is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_render_backend_pbm_rle(
+    sxbp_rle_bitmap_t image, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Renders a spiral straight to a PBM image, one row at a time.
+ * @details The bytes written are identical to those of rendering the spiral
+ * with sxbp_render_spiral_raw() and then sxbp_render_backend_pbm(), but the
+ * whole image is never held in memory, as it is generated with
+ * sxbp_render_spiral_rows() and each row is written as soon as it is ready.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param write_callback A function pointer as accepted by
+ * sxbp_dump_spiral_stream(), which the image is written through.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the callback failed to write the image.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That write_callback is not NULL
+ */
+sxbp_status_t sxbp_render_backend_pbm_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,67 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ *
+ * Copyright (C) 2016, 2017, Joshua Saxby joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <assert.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../saxbospiral.h"
+#include "../render.h"
+#include "backend_pgm.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+// the longest PGM header possible, including the null-terminator
+#define PGM_HEADER_MAX_SIZE 30
+
+sxbp_status_t sxbp_render_backend_pgm(
+    sxbp_greymap_t greymap, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(greymap.pixels != NULL);
+    assert(buffer->bytes == NULL);
+    /*
+     * the width and height may be up to 10 characters each (max uint32_t is
+     * 10 digits long), each followed by whitespace after the "P5" magic number
+     * and before the maximum grey value of "255"
+     */
+    char header[PGM_HEADER_MAX_SIZE];
+    size_t index = (size_t)sprintf(
+        header, "P5\n%" PRIu32 "\n%" PRIu32 "\n255\n",
+        greymap.width, greymap.height
+    );
+    // one byte per pixel
+    size_t image_bytes = (size_t)greymap.width * greymap.height;
+    // try and allocate the data for the buffer
+    buffer->bytes = malloc(index + image_bytes);
+    // check fo memory allocation failure
+    if(buffer->bytes == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // set buffer size
+    buffer->size = index + image_bytes;
+    memcpy(buffer->bytes, header, index);
+    // PGM has black as 0, the inverse of greyscale images
+    for(size_t i = 0; i < image_bytes; i++) {
+        buffer->bytes[index + i] = (uint8_t)(255 - greymap.pixels[i]);
+    }
+    return SXBP_OPERATION_OK;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
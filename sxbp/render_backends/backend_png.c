@@ -9,12 +9,15 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include <assert.h>
-// only include these extra dependencies if support for PNG output was enabled
-#ifdef LIBSXBP_PNG_SUPPORT
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
-
+// only include these extra dependencies if support for PNG output was enabled
+#ifdef LIBSXBP_PNG_SUPPORT
 #include <png.h>
+#include <zlib.h>
 #endif
 
 #include "../saxbospiral.h"
@@ -26,8 +29,547 @@
 extern "C"{
 #endif
 
+// the number of metadata text chunks written to each image
+#define PNG_METADATA_COUNT 5
+// keys of the metadata text chunks written to each image
+static const char* PNG_METADATA_KEYS[PNG_METADATA_COUNT] = {
+    "Author", "Description", "Copyright", "Software", "Comment",
+};
+// text of the metadata text chunks written to each image
+static const char* PNG_METADATA_TEXT[PNG_METADATA_COUNT] = {
+    "Joshua Saxby (https://github.com/saxbophone)",
+    "Experimental generation of 2D spiralling lines based on input binary data",
+    "Copyright Joshua Saxby",
+    // LIBSXBP_VERSION_STRING is a macro that expands to a double-quoted string
+    "libsxbp v" LIBSXBP_VERSION_STRING,
+    "https://github.com/saxbophone/libsxbp",
+};
+
+/*
+ * private type, lookup tables for calculating the CRC-32 checksums of PNG
+ * chunks eight bytes at a time (slice-by-8)
+ */
+typedef struct png_crc_tables_t {
+    uint32_t tables[8][256];
+} png_crc_tables_t;
+
+// private function, fills in the lookup tables for PNG CRC-32 checksums
+static void init_png_crc_tables(png_crc_tables_t* crc_tables) {
+    // the first table is the usual byte at a time one
+    for(uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (0xedb88320 ^ (crc >> 1)) : (crc >> 1);
+        }
+        crc_tables->tables[0][i] = crc;
+    }
+    // each following table follows on from the one before by one more byte
+    for(uint32_t i = 0; i < 256; i++) {
+        for(uint8_t t = 1; t < 8; t++) {
+            uint32_t crc = crc_tables->tables[t - 1][i];
+            crc_tables->tables[t][i] = (
+                crc_tables->tables[0][crc & 0xff] ^ (crc >> 8)
+            );
+        }
+    }
+}
+
+// private function, continues the CRC-32 checksum crc over size more bytes
+static uint32_t png_crc32(
+    const png_crc_tables_t* crc_tables, uint32_t crc, const uint8_t* bytes,
+    size_t size
+) {
+    const uint32_t (* t)[256] = crc_tables->tables;
+    crc = ~crc;
+    // eight bytes at a time, assembled byte-wise so endianness doesn't matter
+    while(size >= 8) {
+        uint32_t low = crc ^ (
+            (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+            ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24)
+        );
+        uint32_t high = (
+            (uint32_t)bytes[4] | ((uint32_t)bytes[5] << 8) |
+            ((uint32_t)bytes[6] << 16) | ((uint32_t)bytes[7] << 24)
+        );
+        crc = (
+            t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^
+            t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+            t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^
+            t[1][(high >> 16) & 0xff] ^ t[0][high >> 24]
+        );
+        bytes += 8;
+        size -= 8;
+    }
+    for(size_t i = 0; i < size; i++) {
+        crc = t[0][(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// private function, writes a 32-bit unsigned integer as big-endian bytes
+static void dump_png_uint32(uint32_t value, uint8_t* bytes) {
+    bytes[0] = (uint8_t)(value >> 24);
+    bytes[1] = (uint8_t)(value >> 16);
+    bytes[2] = (uint8_t)(value >> 8);
+    bytes[3] = (uint8_t)value;
+}
+
+/*
+ * private function, writes the length and type of a PNG chunk to output and
+ * returns where its data should be written
+ */
+static uint8_t* begin_png_chunk(
+    uint8_t* output, uint32_t length, const char* type
+) {
+    dump_png_uint32(length, output);
+    memcpy(output + 4, type, 4);
+    return output + 8;
+}
+
+/*
+ * private function, writes the CRC of the PNG chunk starting at chunk, whose
+ * data is length bytes long, and returns where the next chunk should start
+ */
+static uint8_t* end_png_chunk(
+    const png_crc_tables_t* crc_tables, uint8_t* chunk, uint32_t length
+) {
+    // the CRC covers the chunk type and data
+    uint32_t crc = png_crc32(crc_tables, 0, chunk + 4, length + 4);
+    dump_png_uint32(crc, chunk + 8 + length);
+    return chunk + 12 + length;
+}
+
+// private function, gives the size of the chunks written by write_png_header()
+static size_t png_header_size(void) {
+    size_t size = (
+        8 + // PNG signature
+        12 + 13 + // IHDR chunk
+        12 + 1 // sBIT chunk
+    );
+    // tEXt chunks, each holding a key, null separator and text
+    for(uint8_t i = 0; i < PNG_METADATA_COUNT; i++) {
+        size += (
+            12 + strlen(PNG_METADATA_KEYS[i]) + 1 + strlen(PNG_METADATA_TEXT[i])
+        );
+    }
+    return size;
+}
+
+/*
+ * private function, writes the PNG signature and all the chunks of a 1-bit
+ * grayscale PNG image of bitmap which come before its image data to output,
+ * returning where the next chunk should start
+ */
+static uint8_t* write_png_header(
+    const png_crc_tables_t* crc_tables, sxbp_bitmap_t bitmap, uint8_t* output
+) {
+    static const uint8_t signature[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n',
+    };
+    memcpy(output, signature, 8);
+    uint8_t* chunk = output + 8;
+    // IHDR - 1-bit grayscale with no interlacing
+    uint8_t* data = begin_png_chunk(chunk, 13, "IHDR");
+    dump_png_uint32(bitmap.width, data);
+    dump_png_uint32(bitmap.height, data + 4);
+    data[8] = 1;
+    data[9] = 0;
+    data[10] = 0;
+    data[11] = 0;
+    data[12] = 0;
+    chunk = end_png_chunk(crc_tables, chunk, 13);
+    // sBIT - 1 significant bit of gray
+    data = begin_png_chunk(chunk, 1, "sBIT");
+    data[0] = 1;
+    chunk = end_png_chunk(crc_tables, chunk, 1);
+    // tEXt metadata, key and text separated by a null byte
+    for(uint8_t i = 0; i < PNG_METADATA_COUNT; i++) {
+        size_t key_size = strlen(PNG_METADATA_KEYS[i]);
+        size_t text_size = strlen(PNG_METADATA_TEXT[i]);
+        uint32_t length = (uint32_t)(key_size + 1 + text_size);
+        data = begin_png_chunk(chunk, length, "tEXt");
+        memcpy(data, PNG_METADATA_KEYS[i], key_size + 1);
+        memcpy(data + key_size + 1, PNG_METADATA_TEXT[i], text_size);
+        chunk = end_png_chunk(crc_tables, chunk, length);
+    }
+    return chunk;
+}
+
+/*
+ * private function, writes a row of width pixels packed as in a bitmap to raw
+ * as PNG 1-bit grayscale pixels, which may be done in place
+ */
+static void convert_png_row(
+    const uint8_t* pixels, uint32_t width, uint8_t* raw
+) {
+    size_t row_size = sxbp_bitmap_row_size(width);
+    // PNG grayscale has white as 1 and black as 0, the inverse of bitmaps
+    for(size_t x = 0; x < row_size; x++) {
+        raw[x] = (uint8_t)~pixels[x];
+    }
+    // unused bits at the end of each row should be left clear
+    if(width % 8 != 0) {
+        raw[row_size - 1] &= (uint8_t)(0xff << (8 - (width % 8)));
+    }
+}
+
+// the largest sum the Adler-32 checksum can take before it must be reduced
+#define ADLER_MAX_RUN 5552
+// the modulus of both sums of the Adler-32 checksum
+#define ADLER_MODULUS 65521
+
+// private function, continues the Adler-32 checksum adler over size more bytes
+static uint32_t png_adler32(uint32_t adler, const uint8_t* bytes, size_t size) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while(size > 0) {
+        // reduce the sums only once per run, as late as they can't overflow
+        size_t run = (size < ADLER_MAX_RUN) ? size : ADLER_MAX_RUN;
+        size -= run;
+        while(run >= 8) {
+            a += bytes[0]; b += a;
+            a += bytes[1]; b += a;
+            a += bytes[2]; b += a;
+            a += bytes[3]; b += a;
+            a += bytes[4]; b += a;
+            a += bytes[5]; b += a;
+            a += bytes[6]; b += a;
+            a += bytes[7]; b += a;
+            bytes += 8;
+            run -= 8;
+        }
+        while(run > 0) {
+            a += *bytes;
+            b += a;
+            bytes++;
+            run--;
+        }
+        a %= ADLER_MODULUS;
+        b %= ADLER_MODULUS;
+    }
+    return (b << 16) | a;
+}
+
+// the most data written to each IDAT chunk by the built-in encoder
+#define BUILTIN_IDAT_SIZE 1048576
+// the shortest and longest matches which deflate can encode
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+// the furthest back which deflate can match
+#define DEFLATE_MAX_DISTANCE 32768
+
+// the smallest lengths of each deflate length code and their extra bit counts
+static const uint16_t DEFLATE_LENGTH_BASES[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+    67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t DEFLATE_LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+    5, 5, 5, 5, 0,
+};
+// the smallest distances of each deflate distance code and their extra bits
+static const uint16_t DEFLATE_DISTANCE_BASES[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+    769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t DEFLATE_DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+    11, 11, 12, 12, 13, 13,
+};
+
+/*
+ * private type, holds the state of the built-in encoder as it writes
+ * compressed image data out to a series of IDAT chunks
+ */
+typedef struct idat_writer_t {
+    const png_crc_tables_t* crc_tables;
+    // the chunk currently being written and how much data it holds so far
+    uint8_t* chunk;
+    uint32_t length;
+    // bits waiting to be written out, least significant first
+    uint64_t bits;
+    uint8_t bit_count;
+    // fixed Huffman codes of each literal/length symbol, bit-reversed
+    uint16_t codes[288];
+    uint8_t code_lengths[288];
+    // the bit-reversed 5-bit codes of each distance symbol
+    uint8_t distance_codes[30];
+} idat_writer_t;
+
+// private function, reverses the order of the lowest count bits of value
+static uint16_t reverse_bits(uint16_t value, uint8_t count) {
+    uint16_t reversed = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        reversed = (uint16_t)((reversed << 1) | ((value >> i) & 1));
+    }
+    return reversed;
+}
+
+/*
+ * private function, sets up the writer to write IDAT chunks starting at
+ * output, and builds the fixed Huffman code tables of deflate
+ */
+static void init_idat_writer(
+    const png_crc_tables_t* crc_tables, uint8_t* output, idat_writer_t* writer
+) {
+    writer->crc_tables = crc_tables;
+    writer->chunk = output;
+    writer->length = 0;
+    writer->bits = 0;
+    writer->bit_count = 0;
+    // these are the fixed codes from the deflate specification (RFC 1951)
+    for(uint16_t s = 0; s < 288; s++) {
+        uint16_t code;
+        uint8_t length;
+        if(s < 144) {
+            code = (uint16_t)(0x30 + s);
+            length = 8;
+        } else if(s < 256) {
+            code = (uint16_t)(0x190 + (s - 144));
+            length = 9;
+        } else if(s < 280) {
+            code = (uint16_t)(s - 256);
+            length = 7;
+        } else {
+            code = (uint16_t)(0xc0 + (s - 280));
+            length = 8;
+        }
+        // Huffman codes are packed starting from their most significant bit
+        writer->codes[s] = reverse_bits(code, length);
+        writer->code_lengths[s] = length;
+    }
+    for(uint8_t s = 0; s < 30; s++) {
+        writer->distance_codes[s] = (uint8_t)reverse_bits(s, 5);
+    }
+}
+
+/*
+ * private function, finishes the current IDAT chunk now that the length of its
+ * data is known, returning where the next chunk should start
+ */
+static uint8_t* end_idat_chunk(idat_writer_t* writer) {
+    begin_png_chunk(writer->chunk, writer->length, "IDAT");
+    return end_png_chunk(writer->crc_tables, writer->chunk, writer->length);
+}
+
+/*
+ * private function, writes one byte of data to the current IDAT chunk,
+ * finishing it and starting the next one when it is full
+ */
+static void write_idat_byte(idat_writer_t* writer, uint8_t byte) {
+    if(writer->length == BUILTIN_IDAT_SIZE) {
+        writer->chunk = end_idat_chunk(writer);
+        writer->length = 0;
+    }
+    writer->chunk[8 + writer->length] = byte;
+    writer->length++;
+}
+
+// private function, writes the lowest count bits of value (at most 32 bits)
+static void write_idat_bits(
+    idat_writer_t* writer, uint32_t value, uint8_t count
+) {
+    writer->bits |= (uint64_t)value << writer->bit_count;
+    writer->bit_count = (uint8_t)(writer->bit_count + count);
+    while(writer->bit_count >= 8) {
+        write_idat_byte(writer, (uint8_t)writer->bits);
+        writer->bits >>= 8;
+        writer->bit_count = (uint8_t)(writer->bit_count - 8);
+    }
+}
+
+// private function, writes a literal/length symbol with its fixed code
+static void write_idat_symbol(idat_writer_t* writer, uint16_t symbol) {
+    write_idat_bits(
+        writer, writer->codes[symbol], writer->code_lengths[symbol]
+    );
+}
+
+/*
+ * private function, gives the index of the largest of the count ascending
+ * bases which is no larger than value
+ */
+static uint8_t find_deflate_code(
+    const uint16_t* bases, uint8_t count, uint32_t value
+) {
+    uint8_t code = 0;
+    while(code + 1 < count && bases[code + 1] <= value) {
+        code++;
+    }
+    return code;
+}
+
+// private function, writes a deflate match of the given length and distance
+static void write_idat_match(
+    idat_writer_t* writer, uint32_t length, uint32_t distance
+) {
+    uint8_t code = find_deflate_code(DEFLATE_LENGTH_BASES, 29, length);
+    write_idat_symbol(writer, (uint16_t)(257 + code));
+    write_idat_bits(
+        writer, length - DEFLATE_LENGTH_BASES[code],
+        DEFLATE_LENGTH_EXTRA[code]
+    );
+    code = find_deflate_code(DEFLATE_DISTANCE_BASES, 30, distance);
+    write_idat_bits(writer, writer->distance_codes[code], 5);
+    write_idat_bits(
+        writer, distance - DEFLATE_DISTANCE_BASES[code],
+        DEFLATE_DISTANCE_EXTRA[code]
+    );
+}
+
+/*
+ * private function, counts how many bytes from position onwards up to end
+ * match those distance bytes before them, up to the longest deflate match
+ */
+static uint32_t match_length(
+    const uint8_t* bytes, size_t position, size_t end, size_t distance
+) {
+    size_t limit = end - position;
+    if(limit > DEFLATE_MAX_MATCH) {
+        limit = DEFLATE_MAX_MATCH;
+    }
+    size_t length = 0;
+    while(length < limit && bytes[position + length] ==
+          bytes[position + length - distance]) {
+        length++;
+    }
+    return (uint32_t)length;
+}
+
+/*
+ * private function, compresses the row of raw image data in the second half
+ * of rows, using the first half as the row before it if has_previous is true.
+ * Only two kinds of match are looked for, which are what 1-bit line art is
+ * made of: runs of the same byte, and bytes repeated from the row above.
+ */
+static void deflate_raw_row(
+    idat_writer_t* writer, const uint8_t* rows, size_t row_size,
+    bool has_previous
+) {
+    size_t end = 2 * row_size;
+    // runs may carry on from the end of the row above
+    size_t earliest = has_previous ? 0 : row_size;
+    bool match_above = has_previous && row_size <= DEFLATE_MAX_DISTANCE;
+    size_t position = row_size;
+    while(position < end) {
+        uint32_t run = 0;
+        if(position > earliest) {
+            run = match_length(rows, position, end, 1);
+        }
+        uint32_t above = 0;
+        if(match_above && run < DEFLATE_MAX_MATCH) {
+            above = match_length(rows, position, end, row_size);
+        }
+        if(above > run && above >= DEFLATE_MIN_MATCH) {
+            write_idat_match(writer, above, (uint32_t)row_size);
+            position += above;
+        } else if(run >= DEFLATE_MIN_MATCH) {
+            write_idat_match(writer, run, 1);
+            position += run;
+        } else {
+            write_idat_symbol(writer, rows[position]);
+            position++;
+        }
+    }
+}
+
+/*
+ * private function, writes the pixels of row y of the bitmap pointed to by
+ * image to row, for write_builtin_idat()
+ */
+static void get_bitmap_row(const void* image, uint32_t y, uint8_t* row) {
+    const sxbp_bitmap_t* bitmap = (const sxbp_bitmap_t*)image;
+    size_t row_size = sxbp_bitmap_row_size(bitmap->width);
+    memcpy(row, bitmap->pixels + (y * row_size), row_size);
+}
+
+/*
+ * private function, writes the pixels of row y of the run-length encoded
+ * bitmap pointed to by image to row, for write_builtin_idat()
+ */
+static void get_rle_row(const void* image, uint32_t y, uint8_t* row) {
+    sxbp_get_rle_bitmap_row(*(const sxbp_rle_bitmap_t*)image, y, row);
+}
+
+/*
+ * private function, writes the image data of an image of the given size to
+ * output as zlib compressed data split into IDAT chunks, returning where the
+ * next chunk should start. Each row of pixels is fetched from image with
+ * get_row() when it's needed, and only two rows of uncompressed image data
+ * are held at once, in rows.
+ */
+static uint8_t* write_builtin_idat(
+    const png_crc_tables_t* crc_tables, sxbp_bitmap_t size,
+    void(* get_row)(const void* image, uint32_t y, uint8_t* row),
+    const void* image, uint8_t* output, uint8_t* rows
+) {
+    size_t row_size = 1 + sxbp_bitmap_row_size(size.width);
+    idat_writer_t writer;
+    init_idat_writer(crc_tables, output, &writer);
+    // zlib header, deflate with a 32KiB window flagged as fastest compression
+    write_idat_byte(&writer, 0x78);
+    write_idat_byte(&writer, 0x01);
+    // everything goes in one final block of fixed Huffman codes
+    write_idat_bits(&writer, 1, 1);
+    write_idat_bits(&writer, 1, 2);
+    uint32_t adler = 1;
+    for(uint32_t y = 0; y < size.height; y++) {
+        if(y > 0) {
+            memcpy(rows, rows + row_size, row_size);
+        }
+        uint8_t* raw = rows + row_size;
+        raw[0] = 0;
+        get_row(image, y, raw + 1);
+        convert_png_row(raw + 1, size.width, raw + 1);
+        adler = png_adler32(adler, rows + row_size, row_size);
+        deflate_raw_row(&writer, rows, row_size, y > 0);
+    }
+    // end of block, padded out to a whole byte
+    write_idat_symbol(&writer, 256);
+    if(writer.bit_count > 0) {
+        write_idat_bits(&writer, 0, (uint8_t)(8 - writer.bit_count));
+    }
+    // the checksum of the uncompressed data ends the zlib stream
+    for(int8_t shift = 24; shift >= 0; shift -= 8) {
+        write_idat_byte(&writer, (uint8_t)(adler >> shift));
+    }
+    return end_idat_chunk(&writer);
+}
+
+// private function, gives the most bytes write_builtin_idat() can write
+static size_t builtin_idat_size_bound(sxbp_bitmap_t bitmap) {
+    size_t raw_size = (
+        (1 + sxbp_bitmap_row_size(bitmap.width)) * (size_t)bitmap.height
+    );
+    /*
+     * no byte costs more than the 9 bits of the longest literal code, matches
+     * being shorter than the literals they replace, then there are the block
+     * header and end, padding and 6 bytes of the zlib header and trailer
+     */
+    size_t zlib_size = raw_size + ((raw_size + 7) / 8) + 8;
+    size_t idat_chunks = (zlib_size / BUILTIN_IDAT_SIZE) + 1;
+    return zlib_size + (12 * idat_chunks);
+}
+
 // only define the following private functions if libpng support was enabled
 #ifdef LIBSXBP_PNG_SUPPORT
+/*
+ * private function, writes rows first_row up to end_row of bitmap to raw as
+ * uncompressed PNG image data, each with a leading filter type byte of 0
+ * (no filtering, which suits 1-bit images best)
+ */
+static void build_raw_rows(
+    sxbp_bitmap_t bitmap, uint32_t first_row, uint32_t end_row, uint8_t* raw
+) {
+    size_t row_size = sxbp_bitmap_row_size(bitmap.width);
+    for(uint32_t y = first_row; y < end_row; y++) {
+        *raw = 0;
+        raw++;
+        convert_png_row(bitmap.pixels + (y * row_size), bitmap.width, raw);
+        raw += row_size;
+    }
+}
+
 // private custom libPNG buffer write function
 static void buffer_write_data(
     png_structp png_ptr, png_bytep data, png_size_t length
@@ -50,6 +592,33 @@ static void buffer_write_data(
     p->size += length;
 }
 
+/*
+ * private type, the io pointer given to fixed_write_data() - tracks how much
+ * of the caller's memory has been written to
+ */
+typedef struct fixed_buffer_t {
+    sxbp_buffer_t buffer;
+    size_t size;
+    bool overflowed;
+} fixed_buffer_t;
+
+/*
+ * private custom libPNG write function for writing to memory of fixed size.
+ * Rather than raising an error when the memory is full, it is noted and the
+ * rest of the image is discarded, so there's no need to setjmp() for it.
+ */
+static void fixed_write_data(
+    png_structp png_ptr, png_bytep data, png_size_t length
+) {
+    fixed_buffer_t* p = (fixed_buffer_t*)png_get_io_ptr(png_ptr);
+    if(p->overflowed || p->buffer.size - p->size < length) {
+        p->overflowed = true;
+        return;
+    }
+    memcpy(p->buffer.bytes + p->size, data, length);
+    p->size += length;
+}
+
 // disable GCC warning about the unused parameter, as this is a dummy function
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -66,12 +635,346 @@ static void cleanup_png_lib(
         png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1);
     }
     if(png_ptr != NULL) {
-        png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
+        // this frees the info struct too, if there is one
+        png_destroy_write_struct(&png_ptr, &info_ptr);
     }
     if(row != NULL) {
         free(row);
     }
 }
+
+/*
+ * private type, holds the state of libPNG while an image is written one row at
+ * a time
+ */
+typedef struct png_writer_t {
+    png_structp png_ptr;
+    png_infop info_ptr;
+    // one row of PNG pixels
+    png_bytep row;
+    size_t row_size;
+    // unused bits at the end of each row should be left clear
+    png_byte last_byte_mask;
+} png_writer_t;
+
+/*
+ * private function, sets up libPNG to write an image of the given size out
+ * through the given libPNG write function and writes everything up to the
+ * image data. On failure, any resources are cleaned up.
+ */
+static sxbp_status_t begin_png(
+    png_writer_t* writer, uint32_t width, uint32_t height,
+    png_rw_ptr write_data, void* io_ptr
+) {
+    // init libpng stuff
+    writer->png_ptr = NULL;
+    writer->info_ptr = NULL;
+    writer->row = NULL;
+    // allocate libpng memory
+    writer->png_ptr = png_create_write_struct(
+        PNG_LIBPNG_VER_STRING, NULL, NULL, NULL
+    );
+    // catch malloc fail
+    if(writer->png_ptr == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // allocate libpng memory
+    writer->info_ptr = png_create_info_struct(writer->png_ptr);
+    // catch malloc fail
+    if(writer->info_ptr == NULL) {
+        // cleanup
+        cleanup_png_lib(writer->png_ptr, writer->info_ptr, writer->row);
+        return SXBP_MALLOC_REFUSED;
+    }
+    writer->row_size = sxbp_bitmap_row_size(width);
+    // Allocate memory for one row (packed 8 pixels per byte, like the bitmap)
+    writer->row = (png_bytep) malloc(writer->row_size);
+    // catch malloc fail
+    if(writer->row == NULL) {
+        // cleanup
+        cleanup_png_lib(writer->png_ptr, writer->info_ptr, writer->row);
+        return SXBP_MALLOC_REFUSED;
+    }
+    writer->last_byte_mask = (png_byte)(
+        (width % 8 == 0) ? 0xff : (0xff << (8 - (width % 8)))
+    );
+    // set PNG write function
+    png_set_write_fn(writer->png_ptr, io_ptr, write_data, dummy_png_flush);
+    // Write header - specify a 1-bit grayscale image with adam7 interlacing
+    png_set_IHDR(
+        writer->png_ptr, writer->info_ptr, width, height,
+        1, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
+        PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE
+    );
+    // configure bit packing - 1 bit gray channel
+    png_color_8 sig_bit;
+    sig_bit.gray = 1;
+    png_set_sBIT(writer->png_ptr, writer->info_ptr, &sig_bit);
+    // Set image metadata
+    png_text metadata[PNG_METADATA_COUNT];
+    for(uint8_t i = 0; i < PNG_METADATA_COUNT; i++) {
+        metadata[i].key = (png_charp)PNG_METADATA_KEYS[i];
+        metadata[i].text = (png_charp)PNG_METADATA_TEXT[i];
+        // set compression of each metadata key
+        metadata[i].compression = PNG_TEXT_COMPRESSION_NONE;
+    }
+    // write metadata
+    png_set_text(
+        writer->png_ptr, writer->info_ptr, metadata, PNG_METADATA_COUNT
+    );
+    png_write_info(writer->png_ptr, writer->info_ptr);
+    return SXBP_OPERATION_OK;
+}
+
+// private function, writes the next row of the image from packed bitmap pixels
+static void write_png_row(png_writer_t* writer, const uint8_t* pixels) {
+    // PNG grayscale has white as 1 and black as 0, the inverse of bitmaps
+    for(size_t x = 0; x < writer->row_size; x++) {
+        writer->row[x] = (png_byte)~pixels[x];
+    }
+    if(writer->row_size > 0) {
+        writer->row[writer->row_size - 1] &= writer->last_byte_mask;
+    }
+    png_write_row(writer->png_ptr, writer->row);
+}
+
+// private function, finishes writing the image and cleans up
+static void end_png(png_writer_t* writer) {
+    // End write
+    png_write_end(writer->png_ptr, NULL);
+    // cleanup
+    cleanup_png_lib(writer->png_ptr, writer->info_ptr, writer->row);
+}
+
+/*
+ * private function, writes the PNG image of bitmap out through the given
+ * libPNG write function
+ */
+static sxbp_status_t write_png(
+    sxbp_bitmap_t bitmap, png_rw_ptr write_data, void* io_ptr
+) {
+    png_writer_t writer;
+    sxbp_status_t result = begin_png(
+        &writer, bitmap.width, bitmap.height, write_data, io_ptr
+    );
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    // Write image data
+    for(size_t y = 0 ; y < bitmap.height; y++) {
+        write_png_row(&writer, bitmap.pixels + (y * writer.row_size));
+    }
+    end_png(&writer);
+    return SXBP_OPERATION_OK;
+}
+
+/*
+ * private type, the user data given to the callbacks of
+ * sxbp_render_spiral_rows() when streaming a PNG image, which is also the io
+ * pointer given to stream_write_data()
+ */
+typedef struct png_stream_t {
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data);
+    void* user_data;
+    png_writer_t writer;
+    bool begun;
+    // like fixed_write_data(), failed writes are noted rather than raised
+    bool failed;
+} png_stream_t;
+
+// private custom libPNG write function for writing through a callback
+static void stream_write_data(
+    png_structp png_ptr, png_bytep data, png_size_t length
+) {
+    png_stream_t* p = (png_stream_t*)png_get_io_ptr(png_ptr);
+    if(
+        !p->failed &&
+        p->write_callback(data, length, p->user_data) != length
+    ) {
+        p->failed = true;
+    }
+}
+
+// private function, starts the PNG image once the image size is known
+static sxbp_status_t png_stream_begin(
+    uint32_t width, uint32_t height, void* user_data
+) {
+    png_stream_t* stream = (png_stream_t*)user_data;
+    sxbp_status_t result = begin_png(
+        &stream->writer, width, height, stream_write_data, user_data
+    );
+    stream->begun = (result == SXBP_OPERATION_OK);
+    return result;
+}
+
+// disable GCC warning about the unused parameter, rows are always in order
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+// private function, writes one row of pixels, stopping if a write failed
+static sxbp_status_t png_stream_row(
+    const uint8_t* row, uint32_t y, void* user_data
+) {
+    png_stream_t* stream = (png_stream_t*)user_data;
+    write_png_row(&stream->writer, row);
+    return stream->failed ? SXBP_OPERATION_FAIL : SXBP_OPERATION_OK;
+}
+// re-enable all warnings
+#pragma GCC diagnostic pop
+/*
+ * the number of bytes of uncompressed image data in each block which
+ * sxbp_render_backend_png_parallel() compresses separately, by default
+ */
+#define PNG_PARALLEL_BLOCK_SIZE 131072
+// the most data which zlib can refer back to, used to prime each block
+#define DEFLATE_WINDOW_SIZE 32768
+
+// private function, gives the zlib strategy matching a PNG strategy
+static int zlib_strategy(sxbp_png_strategy_t strategy) {
+    switch(strategy) {
+        case SXBP_PNG_STRATEGY_FILTERED:
+            return Z_FILTERED;
+        case SXBP_PNG_STRATEGY_HUFFMAN_ONLY:
+            return Z_HUFFMAN_ONLY;
+        case SXBP_PNG_STRATEGY_RLE:
+            return Z_RLE;
+        case SXBP_PNG_STRATEGY_FIXED:
+            return Z_FIXED;
+        default:
+            return Z_DEFAULT_STRATEGY;
+    }
+}
+
+/*
+ * private type, one block of image rows compressed by
+ * sxbp_render_backend_png_parallel()
+ */
+typedef struct deflate_block_t {
+    uint8_t* bytes;
+    size_t size;
+    // the number of bytes of uncompressed data and their Adler-32 checksum
+    size_t raw_size;
+    uLong adler;
+    sxbp_status_t status;
+} deflate_block_t;
+
+/*
+ * private function, compresses rows first_row up to end_row of bitmap as a
+ * raw deflate stream, primed with the data of the rows before it and ending
+ * in a sync flush, or the end of the stream if it's the last block
+ */
+static sxbp_status_t deflate_rows(
+    sxbp_bitmap_t bitmap, sxbp_png_options_t options, uint32_t first_row,
+    uint32_t end_row, deflate_block_t* block
+) {
+    size_t raw_row_size = 1 + sxbp_bitmap_row_size(bitmap.width);
+    // enough of the rows before this block to fill zlib's window
+    uint32_t window_rows = (uint32_t)(
+        (DEFLATE_WINDOW_SIZE + raw_row_size - 1) / raw_row_size
+    );
+    uint32_t primer_row = (first_row < window_rows)
+        ? 0 : first_row - window_rows;
+    size_t primer_size = (first_row - primer_row) * raw_row_size;
+    block->raw_size = (end_row - first_row) * raw_row_size;
+    uint8_t* raw = malloc(primer_size + block->raw_size);
+    if(raw == NULL && primer_size + block->raw_size > 0) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    build_raw_rows(bitmap, primer_row, end_row, raw);
+    block->adler = adler32(
+        adler32(0L, Z_NULL, 0), raw + primer_size, (uInt)block->raw_size
+    );
+    z_stream stream = { .zalloc = Z_NULL, .zfree = Z_NULL, .opaque = Z_NULL, };
+    // negative window bits give a raw deflate stream with no zlib wrapper
+    if(
+        deflateInit2(
+            &stream, options.level, Z_DEFLATED, -15, 8,
+            zlib_strategy(options.strategy)
+        ) != Z_OK
+    ) {
+        free(raw);
+        return SXBP_MALLOC_REFUSED;
+    }
+    sxbp_status_t result = SXBP_OPERATION_OK;
+    if(primer_size > 0) {
+        size_t dictionary_size = (primer_size < DEFLATE_WINDOW_SIZE)
+            ? primer_size : DEFLATE_WINDOW_SIZE;
+        deflateSetDictionary(
+            &stream, raw + primer_size - dictionary_size, (uInt)dictionary_size
+        );
+    }
+    // a sync flush adds an empty stored block of up to 5 bytes to the bound
+    size_t bound = deflateBound(&stream, (uLong)block->raw_size) + 16;
+    block->bytes = malloc(bound);
+    if(block->bytes == NULL) {
+        result = SXBP_MALLOC_REFUSED;
+    } else {
+        bool last = (end_row == bitmap.height);
+        stream.next_in = raw + primer_size;
+        stream.avail_in = (uInt)block->raw_size;
+        stream.next_out = block->bytes;
+        stream.avail_out = (uInt)bound;
+        int status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        if(
+            stream.avail_in != 0 ||
+            (last ? status != Z_STREAM_END : status != Z_OK)
+        ) {
+            result = SXBP_OPERATION_FAIL;
+        }
+        block->size = bound - stream.avail_out;
+    }
+    deflateEnd(&stream);
+    free(raw);
+    return result;
+}
+
+/*
+ * private function, writes the PNG image of bitmap from its compressed
+ * blocks into output, which must be big enough. adler is the checksum of all
+ * the uncompressed data, and level is the compression level, which is noted
+ * in the zlib header.
+ */
+static void write_png_blocks(
+    const png_crc_tables_t* crc_tables, sxbp_bitmap_t bitmap,
+    const deflate_block_t* blocks, size_t block_count, uLong adler, int level,
+    uint8_t* output
+) {
+    uint8_t* chunk = write_png_header(crc_tables, bitmap, output);
+    uint8_t* data;
+    /*
+     * IDAT - one per block, the first led by the zlib header and the last
+     * followed by the checksum of the uncompressed data
+     */
+    for(size_t i = 0; i < block_count; i++) {
+        bool first = (i == 0);
+        bool last = (i == block_count - 1);
+        uint32_t length = (uint32_t)(
+            (first ? 2 : 0) + blocks[i].size + (last ? 4 : 0)
+        );
+        data = begin_png_chunk(chunk, length, "IDAT");
+        if(first) {
+            // deflate with a 32KiB window, flagged with the compression level
+            uint8_t level_flag = (uint8_t)(
+                (level == -1 || level == 6) ? 2 : (level < 2) ? 0 :
+                (level < 6) ? 1 : 3
+            );
+            data[0] = 0x78;
+            data[1] = (uint8_t)(level_flag << 6);
+            // the header as a 16-bit number must be a multiple of 31
+            data[1] = (uint8_t)(
+                data[1] + (31 - (((0x78 << 8) | data[1]) % 31))
+            );
+            data += 2;
+        }
+        memcpy(data, blocks[i].bytes, blocks[i].size);
+        if(last) {
+            dump_png_uint32((uint32_t)adler, data + blocks[i].size);
+        }
+        chunk = end_png_chunk(crc_tables, chunk, length);
+    }
+    // IEND
+    begin_png_chunk(chunk, 0, "IEND");
+    end_png_chunk(crc_tables, chunk, 0);
+}
 #endif // LIBSXBP_PNG_SUPPORT
 
 // flag for whether PNG output support has been compiled in based, on macro
@@ -81,6 +984,12 @@ const bool SXBP_PNG_SUPPORT = true;
 const bool SXBP_PNG_SUPPORT = false;
 #endif
 
+const sxbp_png_options_t SXBP_PNG_DEFAULT_OPTIONS = {
+    .level = -1,
+    .strategy = SXBP_PNG_STRATEGY_DEFAULT,
+    .block_rows = 0,
+};
+
 sxbp_status_t sxbp_render_backend_png(
     sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
 ) {
@@ -92,98 +1001,311 @@ sxbp_status_t sxbp_render_backend_png(
     // return SXBP_NOT_IMPLEMENTED
     return SXBP_NOT_IMPLEMENTED;
     #else
-    // result status
-    sxbp_status_t result;
     // init buffer
     buffer->size = 0;
-    // init libpng stuff
-    png_structp png_ptr = NULL;
-    png_infop info_ptr = NULL;
-    png_bytep row = NULL;
-    // allocate libpng memory
-    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    // catch malloc fail
-    if(png_ptr == NULL) {
-        result = SXBP_MALLOC_REFUSED;
-        // cleanup
-        cleanup_png_lib(png_ptr, info_ptr, row);
-        return result;
+    return write_png(bitmap, buffer_write_data, (void*)buffer);
+    #endif // LIBSXBP_PNG_SUPPORT
+}
+
+// disable GCC warning about the unused parameter when PNG support is disabled
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+size_t sxbp_render_backend_png_size_bound(sxbp_bitmap_t bitmap) {
+    #ifndef LIBSXBP_PNG_SUPPORT
+    return 0;
+    #else
+    // raw image data is one filter byte then 1 bit per pixel, for each row
+    size_t raw_size = (1 + ((bitmap.width + 7) / 8)) * (size_t)bitmap.height;
+    /*
+     * zlib never expands data by more than this (it's zlib's own conservative
+     * bound, used by deflateBound() for non-default settings), plus the
+     * 6 bytes of the zlib header and trailer
+     */
+    size_t zlib_size = (
+        raw_size + ((raw_size + 7) >> 3) + ((raw_size + 63) >> 6) + 5 + 6
+    );
+    // libpng splits this into IDAT chunks of at most PNG_ZBUF_SIZE bytes
+    size_t idat_chunks = (zlib_size / PNG_ZBUF_SIZE) + 1;
+    size_t size = (
+        8 + // PNG signature
+        12 + 13 + // IHDR chunk
+        12 + 1 + // sBIT chunk
+        zlib_size + (12 * idat_chunks) + // IDAT chunks
+        12 // IEND chunk
+    );
+    // tEXt chunks, each holding a key, null separator and text
+    for(uint8_t i = 0; i < PNG_METADATA_COUNT; i++) {
+        size += (
+            12 + strlen(PNG_METADATA_KEYS[i]) + 1 + strlen(PNG_METADATA_TEXT[i])
+        );
     }
-    // allocate libpng memory
-    info_ptr = png_create_info_struct(png_ptr);
-    // catch malloc fail
-    if(info_ptr == NULL) {
-        result = SXBP_MALLOC_REFUSED;
-        // cleanup
-        cleanup_png_lib(png_ptr, info_ptr, row);
+    return size;
+    #endif // LIBSXBP_PNG_SUPPORT
+}
+// re-enable all warnings
+#pragma GCC diagnostic pop
+
+sxbp_status_t sxbp_render_backend_png_into(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t buffer, size_t* bytes_written
+) {
+    // preconditional assertsions
+    assert(bitmap.pixels != NULL);
+    assert(buffer.bytes != NULL);
+    *bytes_written = 0;
+    // only do PNG operations if support is enabled
+    #ifndef LIBSXBP_PNG_SUPPORT
+    return SXBP_NOT_IMPLEMENTED;
+    #else
+    fixed_buffer_t output = {
+        .buffer = buffer, .size = 0, .overflowed = false,
+    };
+    sxbp_status_t result = write_png(bitmap, fixed_write_data, (void*)&output);
+    if(result != SXBP_OPERATION_OK) {
         return result;
     }
-    // set PNG write function - in this case, a function that writes to buffer
-    png_set_write_fn(png_ptr, buffer, buffer_write_data, dummy_png_flush);
-    // Write header - specify a 1-bit grayscale image with adam7 interlacing
-    png_set_IHDR(
-        png_ptr, info_ptr, bitmap.width, bitmap.height,
-        1, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
-        PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE
+    if(output.overflowed) {
+        return SXBP_OPERATION_FAIL;
+    }
+    *bytes_written = output.size;
+    return SXBP_OPERATION_OK;
+    #endif // LIBSXBP_PNG_SUPPORT
+}
+
+// disable GCC warning about the unused parameter when PNG support is disabled
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+sxbp_status_t sxbp_render_backend_png_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+) {
+    // preconditional assertsions
+    assert(spiral.lines != NULL);
+    assert(write_callback != NULL);
+    // only do PNG operations if support is enabled
+    #ifndef LIBSXBP_PNG_SUPPORT
+    return SXBP_NOT_IMPLEMENTED;
+    #else
+    png_stream_t stream = {
+        .write_callback = write_callback, .user_data = user_data,
+        .begun = false, .failed = false,
+    };
+    sxbp_status_t result = sxbp_render_spiral_rows(
+        spiral, png_stream_begin, png_stream_row, (void*)&stream
     );
-    // configure bit packing - 1 bit gray channel
-    png_color_8 sig_bit;
-    sig_bit.gray = 1;
-    png_set_sBIT(png_ptr, info_ptr, &sig_bit);
-    // Set image metadata
-    png_text metadata[5]; // Author, Description, Copyright, Software, Comment
-    metadata[0].key = "Author";
-    metadata[0].text = "Joshua Saxby (https://github.com/saxbophone)";
-    metadata[1].key = "Description";
-    metadata[1].text = (
-        "Experimental generation of 2D spiralling lines based on input binary "
-        "data"
-    );
-    metadata[2].key = "Copyright";
-    metadata[2].text = "Copyright Joshua Saxby";
-    metadata[3].key = "Software";
-    // LIBSXBP_VERSION_STRING is a macro that expands to a double-quoted string
-    metadata[3].text = "libsxbp v" LIBSXBP_VERSION_STRING;
-    metadata[4].key = "Comment";
-    metadata[4].text = "https://github.com/saxbophone/libsxbp";
-    // set compression of each metadata key
-    for(uint8_t i = 0; i < 5; i++) {
-        metadata[i].compression = PNG_TEXT_COMPRESSION_NONE;
+    // libPNG must be cleaned up whether or not all rows were written
+    if(stream.begun) {
+        if(result == SXBP_OPERATION_OK) {
+            end_png(&stream.writer);
+        } else {
+            cleanup_png_lib(
+                stream.writer.png_ptr, stream.writer.info_ptr,
+                stream.writer.row
+            );
+        }
     }
-    // write metadata
-    png_set_text(png_ptr, info_ptr, metadata, 5);
-    png_write_info(png_ptr, info_ptr);
-    // set bit shift - TODO: Check if this is acutally needed
-    png_set_shift(png_ptr, &sig_bit);
-    // set bit packing
-    // NOTE: I'm pretty sure this bit is needed but worth checking
-    png_set_packing(png_ptr);
-    // Allocate memory for one row (1 byte per pixel - RGB)
-    row = (png_bytep) malloc(bitmap.width * sizeof(png_byte));
-    // catch malloc fail
-    if(row == NULL) {
-        result = SXBP_MALLOC_REFUSED;
-        // cleanup
-        cleanup_png_lib(png_ptr, info_ptr, row);
-        return result;
+    if(result == SXBP_OPERATION_OK && stream.failed) {
+        result = SXBP_OPERATION_FAIL;
     }
-    // Write image data
-    for(size_t y = 0 ; y < bitmap.height; y++) {
-        for(size_t x = 0; x < bitmap.width; x++) {
-            // set to black if there is a point here, white if not
-            row[x] = bitmap.pixels[x][y] ? 0 : 1;
+    return result;
+    #endif // LIBSXBP_PNG_SUPPORT
+}
+// re-enable all warnings
+#pragma GCC diagnostic pop
+
+// disable GCC warning about the unused parameter when PNG support is disabled
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+sxbp_status_t sxbp_render_backend_png_parallel(
+    sxbp_bitmap_t bitmap, sxbp_png_options_t options, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(bitmap.pixels != NULL);
+    assert(buffer->bytes == NULL);
+    // only do PNG operations if support is enabled
+    #ifndef LIBSXBP_PNG_SUPPORT
+    return SXBP_NOT_IMPLEMENTED;
+    #else
+    if(options.level < -1 || options.level > 9) {
+        return SXBP_OPERATION_FAIL;
+    }
+    size_t raw_row_size = 1 + sxbp_bitmap_row_size(bitmap.width);
+    uint32_t block_rows = options.block_rows;
+    if(block_rows == 0) {
+        size_t rows = PNG_PARALLEL_BLOCK_SIZE / raw_row_size;
+        block_rows = (rows == 0) ? 1 : (uint32_t)rows;
+    }
+    // there's always at least one block, even for an empty image
+    size_t block_count = (
+        ((uint64_t)bitmap.height + block_rows - 1) / block_rows
+    );
+    block_count = (block_count == 0) ? 1 : block_count;
+    deflate_block_t* blocks = calloc(block_count, sizeof(deflate_block_t));
+    if(blocks == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    // each block only reads the bitmap and writes its own output
+    #ifdef LIBSXBP_OPENMP_SUPPORT
+    #pragma omp parallel for schedule(dynamic)
+    #endif
+    for(size_t i = 0; i < block_count; i++) {
+        uint32_t first_row = (uint32_t)(i * block_rows);
+        uint32_t end_row = (bitmap.height - first_row < block_rows)
+            ? bitmap.height : first_row + block_rows;
+        blocks[i].status = deflate_rows(
+            bitmap, options, first_row, end_row, &blocks[i]
+        );
+    }
+    // stitch the blocks together, combining their checksums
+    sxbp_status_t result = SXBP_OPERATION_OK;
+    uLong adler = adler32(0L, Z_NULL, 0);
+    size_t size = (
+        png_header_size() +
+        2 + 4 + // zlib header and checksum
+        12 // IEND chunk
+    );
+    for(size_t i = 0; i < block_count; i++) {
+        if(blocks[i].status != SXBP_OPERATION_OK) {
+            result = blocks[i].status;
         }
-       png_write_row(png_ptr, row);
+        adler = adler32_combine(
+            adler, blocks[i].adler, (z_off_t)blocks[i].raw_size
+        );
+        size += 12 + blocks[i].size;
     }
-    // End write
-    png_write_end(png_ptr, NULL);
-    // cleanup
-    cleanup_png_lib(png_ptr, info_ptr, row);
-    // status ok
-    result = SXBP_OPERATION_OK;
+    if(result == SXBP_OPERATION_OK) {
+        buffer->bytes = malloc(size);
+        if(buffer->bytes == NULL) {
+            result = SXBP_MALLOC_REFUSED;
+        } else {
+            buffer->size = size;
+            png_crc_tables_t crc_tables;
+            init_png_crc_tables(&crc_tables);
+            write_png_blocks(
+                &crc_tables, bitmap, blocks, block_count, adler,
+                options.level, buffer->bytes
+            );
+        }
+    }
+    for(size_t i = 0; i < block_count; i++) {
+        free(blocks[i].bytes);
+    }
+    free(blocks);
     return result;
     #endif // LIBSXBP_PNG_SUPPORT
 }
+// re-enable all warnings
+#pragma GCC diagnostic pop
+
+/*
+ * private function, writes a PNG image of the given size with the built-in
+ * encoder to output, fetching each row of pixels from image with get_row(),
+ * and returns where the image ends. The two rows of uncompressed image data
+ * are held in rows.
+ */
+static uint8_t* encode_builtin_png(
+    sxbp_bitmap_t size,
+    void(* get_row)(const void* image, uint32_t y, uint8_t* row),
+    const void* image, uint8_t* output, uint8_t* rows
+) {
+    png_crc_tables_t crc_tables;
+    init_png_crc_tables(&crc_tables);
+    uint8_t* chunk = write_png_header(&crc_tables, size, output);
+    chunk = write_builtin_idat(
+        &crc_tables, size, get_row, image, chunk, rows
+    );
+    // IEND
+    begin_png_chunk(chunk, 0, "IEND");
+    return end_png_chunk(&crc_tables, chunk, 0);
+}
+
+/*
+ * private function, writes a PNG image of the given size with the built-in
+ * encoder to buffer, fetching each row of pixels from image with get_row()
+ */
+static sxbp_status_t write_builtin_png(
+    sxbp_bitmap_t size,
+    void(* get_row)(const void* image, uint32_t y, uint8_t* row),
+    const void* image, sxbp_buffer_t* buffer
+) {
+    size_t row_size = 1 + sxbp_bitmap_row_size(size.width);
+    size_t buffer_size = (
+        png_header_size() + builtin_idat_size_bound(size) +
+        12 // IEND chunk
+    );
+    // the previous and current rows of uncompressed image data
+    uint8_t* rows = malloc(2 * row_size);
+    buffer->bytes = malloc(buffer_size);
+    if(rows == NULL || buffer->bytes == NULL) {
+        free(rows);
+        free(buffer->bytes);
+        buffer->bytes = NULL;
+        return SXBP_MALLOC_REFUSED;
+    }
+    uint8_t* end = encode_builtin_png(
+        size, get_row, image, buffer->bytes, rows
+    );
+    free(rows);
+    buffer->size = (size_t)(end - buffer->bytes);
+    // give back the memory which the image turned out not to need
+    uint8_t* shrunk = realloc(buffer->bytes, buffer->size);
+    if(shrunk != NULL) {
+        buffer->bytes = shrunk;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_backend_png_builtin(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(bitmap.pixels != NULL);
+    assert(buffer->bytes == NULL);
+    return write_builtin_png(bitmap, get_bitmap_row, &bitmap, buffer);
+}
+
+sxbp_status_t sxbp_render_backend_png_builtin_rle(
+    sxbp_rle_bitmap_t image, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(image.runs != NULL);
+    assert(buffer->bytes == NULL);
+    sxbp_bitmap_t size = { .width = image.width, .height = image.height, };
+    return write_builtin_png(size, get_rle_row, &image, buffer);
+}
+
+size_t sxbp_render_backend_png_builtin_size_bound(sxbp_bitmap_t bitmap) {
+    return (
+        png_header_size() + builtin_idat_size_bound(bitmap) +
+        12 + // IEND chunk
+        (2 * (1 + sxbp_bitmap_row_size(bitmap.width))) // working space
+    );
+}
+
+sxbp_status_t sxbp_render_backend_png_builtin_into(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t buffer, size_t* bytes_written
+) {
+    // preconditional assertsions
+    assert(bitmap.pixels != NULL);
+    assert(buffer.bytes != NULL);
+    *bytes_written = 0;
+    size_t bound = sxbp_render_backend_png_builtin_size_bound(bitmap);
+    if(buffer.size < bound) {
+        return SXBP_OPERATION_FAIL;
+    }
+    /*
+     * the image can never reach the last two rows' worth of the bound, so the
+     * uncompressed rows are kept there rather than in allocated memory
+     */
+    uint8_t* rows = buffer.bytes + bound - (
+        2 * (1 + sxbp_bitmap_row_size(bitmap.width))
+    );
+    uint8_t* end = encode_builtin_png(
+        bitmap, get_bitmap_row, &bitmap, buffer.bytes, rows
+    );
+    *bytes_written = (size_t)(end - buffer.bytes);
+    return SXBP_OPERATION_OK;
+}
 
 #ifdef __cplusplus
 } // extern "C"
@@ -11,8 +11,10 @@
  * 
  * @note PNG output support may have not been enabled in the compiled version
  * of libsxbp that you have. If support is not enabled, the library
- * boolean constant SXBP_PNG_SUPPORT will be set to false and the one public
- * function defined in this unit will return SXBP_NOT_IMPLEMENTED.
+ * boolean constant SXBP_PNG_SUPPORT will be set to false and the functions
+ * defined in this unit which use libpng will return SXBP_NOT_IMPLEMENTED.
+ * sxbp_render_backend_png_builtin() needs no libraries, so is always
+ * available.
  *
  * @author Joshua Saxby <joshua.a.saxby+TNOPLuc8vM==@gmail.com
  * @date 2016, 2017
@@ -28,6 +30,8 @@
 #define SAXBOPHONE_SAXBOSPIRAL_BACKEND_PNG_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "../saxbospiral.h"
 #include "../render.h"
@@ -45,6 +49,43 @@ extern "C"{
  */
 extern const bool SXBP_PNG_SUPPORT;
 
+/**
+ * @brief The compression strategies which may be used for PNG images.
+ * @details These correspond to the strategies of zlib, see its documentation
+ * for their details.
+ */
+typedef enum sxbp_png_strategy_t {
+    SXBP_PNG_STRATEGY_DEFAULT, /**< for general data */
+    SXBP_PNG_STRATEGY_FILTERED, /**< for filtered data */
+    SXBP_PNG_STRATEGY_HUFFMAN_ONLY, /**< no string matching, fastest */
+    SXBP_PNG_STRATEGY_RLE, /**< only matches runs, fast for line art */
+    SXBP_PNG_STRATEGY_FIXED, /**< no dynamic Huffman codes */
+} sxbp_png_strategy_t;
+
+/**
+ * @brief Options for how PNG images are compressed.
+ */
+typedef struct sxbp_png_options_t {
+    /**
+     * @brief The compression level, from 0 (none) to 9 (smallest), or -1 for
+     * zlib's default
+     */
+    int8_t level;
+    /** @brief The compression strategy */
+    sxbp_png_strategy_t strategy;
+    /**
+     * @brief The number of rows of pixels in each block which is compressed
+     * separately, or 0 to pick a suitable number
+     */
+    uint32_t block_rows;
+} sxbp_png_options_t;
+
+/**
+ * @brief The default options for compressing PNG images.
+ * @details Default level and strategy, with blocks of around 128KiB.
+ */
+extern const sxbp_png_options_t SXBP_PNG_DEFAULT_OPTIONS;
+
 /**
  * @brief Renders a bitmap image to a PNG image.
  *
@@ -62,6 +103,182 @@ sxbp_status_t sxbp_render_backend_png(
     sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
 );
 
+/**
+ * @brief Calculates an upper bound on the number of bytes of the PNG image of
+ * a bitmap.
+ * @details The exact size of a PNG image isn't known until it has been
+ * compressed, but memory of this size is always enough to hold it.
+ *
+ * @param bitmap Bitmap containing the image to render. Only its width and
+ * height are used.
+ * @return The maximum size of the PNG image in bytes.
+ * @return 0 if PNG support has not been enabled.
+ */
+size_t sxbp_render_backend_png_size_bound(sxbp_bitmap_t bitmap);
+
+/**
+ * @brief Renders a bitmap image to a PNG image in memory provided by the
+ * caller.
+ * @details The bytes written are identical to those written by
+ * sxbp_render_backend_png(), but the image is written straight into the
+ * caller's memory rather than into memory re-allocated as it grows, so the
+ * same memory may be re-used for many images.
+ * sxbp_render_backend_png_size_bound() gives how much is needed.
+ *
+ * @param bitmap Bitmap containing the image to render.
+ * @param buffer The memory to write the PNG image data to, where buffer.size
+ * is the number of bytes available.
+ * @param[out] bytes_written The number of bytes written to buffer, 0 on
+ * failure.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if buffer is too small for the image.
+ * @return SXBP_NOT_IMPLEMENTED if PNG support has not been enabled.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure (libpng itself
+ * still allocates some working memory).
+ *
+ * @note Asserts:
+ * - That bitmap.pixels is not NULL
+ * - That buffer.bytes is not NULL
+ */
+sxbp_status_t sxbp_render_backend_png_into(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t buffer, size_t* bytes_written
+);
+
+/**
+ * @brief Renders a spiral straight to a PNG image, one row at a time.
+ * @details The bytes written are identical to those of rendering the spiral
+ * with sxbp_render_spiral_raw() and then sxbp_render_backend_png(), but the
+ * whole image is never held in memory, as it is generated with
+ * sxbp_render_spiral_rows() and each row is given to libpng as soon as it is
+ * ready.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param write_callback A function pointer as accepted by
+ * sxbp_dump_spiral_stream(), which the image is written through.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the callback failed to write the image.
+ * @return SXBP_NOT_IMPLEMENTED if PNG support has not been enabled.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That write_callback is not NULL
+ */
+sxbp_status_t sxbp_render_backend_png_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+);
+
+/**
+ * @brief Renders a bitmap image to a PNG image, compressing it on multiple
+ * threads.
+ * @details The rows of the image are split into blocks which are compressed
+ * separately, each primed with the end of the block before so that little
+ * compression is lost, and ended on a byte boundary with a zlib sync flush,
+ * so that the blocks join up into one valid compressed stream. When the
+ * library is built with OpenMP support, the blocks are compressed in
+ * parallel. The decoded pixels are identical to those of
+ * sxbp_render_backend_png(), though the compressed bytes differ.
+ *
+ * @param bitmap Bitmap containing the image to render.
+ * @param options How the image should be compressed.
+ * @param[out] buffer Buffer to write out the PNG image data to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the options are invalid.
+ * @return SXBP_NOT_IMPLEMENTED if PNG support has not been enabled.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That bitmap.pixels is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_render_backend_png_parallel(
+    sxbp_bitmap_t bitmap, sxbp_png_options_t options, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Renders a bitmap image to a PNG image with the library's own PNG
+ * encoder, which needs neither libpng nor zlib.
+ * @details The encoder is specialised for 1-bit line art such as spirals. Its
+ * compressor only looks for runs of the same byte and for bytes repeated from
+ * the row above, and codes them with deflate's fixed Huffman codes, which is
+ * much faster than general-purpose compression, though the image is usually
+ * somewhat larger. The decoded pixels are identical to those of
+ * sxbp_render_backend_png(). Only two rows of the uncompressed image are held
+ * in memory at once.
+ *
+ * @param bitmap Bitmap containing the image to render.
+ * @param[out] buffer Buffer to write out the PNG image data to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That bitmap.pixels is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_render_backend_png_builtin(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Renders a run-length encoded bitmap image to a PNG image with the
+ * library's own PNG encoder.
+ * @details This works in the same way as sxbp_render_backend_png_builtin(),
+ * except that each row is expanded from its runs only when it is compressed,
+ * so the pixels are never held in a bitmap.
+ *
+ * @param image Run-length encoded bitmap containing the image to render.
+ * @param[out] buffer Buffer to write out the PNG image data to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That image.runs is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_render_backend_png_builtin_rle(
+    sxbp_rle_bitmap_t image, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Calculates how much memory sxbp_render_backend_png_builtin_into()
+ * needs for the PNG image of a bitmap.
+ *
+ * @param bitmap Bitmap containing the image to render. Only its width and
+ * height are used.
+ * @return The number of bytes needed, which is always more than the size of
+ * the image.
+ */
+size_t sxbp_render_backend_png_builtin_size_bound(sxbp_bitmap_t bitmap);
+
+/**
+ * @brief Renders a bitmap image to a PNG image with the library's own PNG
+ * encoder, in memory provided by the caller.
+ * @details The bytes written are identical to those written by
+ * sxbp_render_backend_png_builtin(), but no memory at all is allocated, so
+ * the same memory may be re-used for many images. The memory after the image
+ * is used as working space while encoding, so its contents are not kept.
+ *
+ * @param bitmap Bitmap containing the image to render.
+ * @param buffer The memory to write the PNG image data to, where buffer.size
+ * is the number of bytes available.
+ * @param[out] bytes_written The number of bytes written to buffer, 0 on
+ * failure.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if buffer is smaller than
+ * sxbp_render_backend_png_builtin_size_bound() gives for the bitmap.
+ *
+ * @note Asserts:
+ * - That bitmap.pixels is not NULL
+ * - That buffer.bytes is not NULL
+ */
+sxbp_status_t sxbp_render_backend_png_builtin_into(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t buffer, size_t* bytes_written
+);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
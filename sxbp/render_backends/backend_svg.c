@@ -0,0 +1,201 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ *
+ * Copyright (C) 2016, 2017, Joshua Saxby joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../saxbospiral.h"
+#include "../plot.h"
+#include "backend_svg.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+// the number of bytes of SVG text collected before each write
+#define SVG_CHUNK_SIZE 4096
+// the longest piece of SVG text written at once, other than fixed strings
+#define SVG_PIECE_MAX_SIZE 256
+
+/*
+ * NOTE: The SVG is drawn in units of half a pixel, so that the centres of
+ * pixels (where the line runs along) fall on whole numbers. Each unit of
+ * length of the spiral is 2 pixels, so 4 of these units.
+ */
+
+/*
+ * private type, collects SVG text into chunks to write through the callback,
+ * remembering whether any write has failed
+ */
+typedef struct svg_writer_t {
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data);
+    void* user_data;
+    char chunk[SVG_CHUNK_SIZE];
+    size_t size;
+    bool failed;
+} svg_writer_t;
+
+// private function, writes out the text collected so far
+static void flush_svg(svg_writer_t* writer) {
+    if(
+        !writer->failed && writer->size > 0 &&
+        writer->write_callback(
+            (const uint8_t*)writer->chunk, writer->size, writer->user_data
+        ) != writer->size
+    ) {
+        writer->failed = true;
+    }
+    writer->size = 0;
+}
+
+/*
+ * private function, adds a piece of text to the current chunk, which must be
+ * no longer than SVG_PIECE_MAX_SIZE
+ */
+static void write_svg(svg_writer_t* writer, const char* text, size_t length) {
+    if(SVG_CHUNK_SIZE - writer->size < length) {
+        flush_svg(writer);
+    }
+    memcpy(writer->chunk + writer->size, text, length);
+    writer->size += length;
+}
+
+sxbp_status_t sxbp_render_backend_svg_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+) {
+    // preconditional assertsions
+    assert(spiral.lines != NULL);
+    assert(write_callback != NULL);
+    // image dimensions match those of the raster renderers
+    sxbp_spiral_stats_t stats = sxbp_spiral_stats(spiral);
+    int64_t width = stats.width;
+    int64_t height = stats.height;
+    int64_t min_x = stats.min.x, min_y = stats.min.y;
+    svg_writer_t* writer = malloc(sizeof(svg_writer_t));
+    if(writer == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    writer->write_callback = write_callback;
+    writer->user_data = user_data;
+    writer->size = 0;
+    writer->failed = false;
+    char piece[SVG_PIECE_MAX_SIZE];
+    int length = sprintf(
+        piece,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%" PRId64 "\" "
+        "height=\"%" PRId64 "\" ",
+        width, height
+    );
+    write_svg(writer, piece, (size_t)length);
+    length = sprintf(
+        piece, "viewBox=\"0 0 %" PRId64 " %" PRId64 "\">\n"
+        "<rect width=\"100%%\" height=\"100%%\" fill=\"white\"/>\n",
+        width * 2, height * 2
+    );
+    write_svg(writer, piece, (size_t)length);
+    // square ends and mitred corners make the line cover whole pixels
+    length = sprintf(
+        piece,
+        "<path fill=\"none\" stroke=\"black\" stroke-width=\"2\" "
+        "stroke-linecap=\"square\" stroke-linejoin=\"miter\" d=\"M%" PRId64
+        " %" PRId64,
+        ((0 - min_x) * 4) + 3, (height * 2) - (((0 - min_y) * 4) + 3)
+    );
+    write_svg(writer, piece, (size_t)length);
+    for(size_t i = 0; i < spiral.size; ) {
+        sxbp_direction_t direction = spiral.lines[i].direction;
+        // merge all following lines going the same way into this one
+        int64_t run = 0;
+        for(; i < spiral.size && spiral.lines[i].direction == direction; i++) {
+            run += spiral.lines[i].length;
+        }
+        if(run == 0) {
+            continue;
+        }
+        sxbp_vector_t vector = SXBP_VECTOR_DIRECTIONS[direction];
+        // relative moves, y is flipped as SVG counts down from the top
+        if(vector.x != 0) {
+            length = sprintf(piece, "h%" PRId64, vector.x * run * 4);
+        } else {
+            length = sprintf(piece, "v%" PRId64, -vector.y * run * 4);
+        }
+        write_svg(writer, piece, (size_t)length);
+    }
+    const char* footer = "\"/>\n</svg>\n";
+    write_svg(writer, footer, strlen(footer));
+    flush_svg(writer);
+    sxbp_status_t result = (
+        writer->failed ? SXBP_OPERATION_FAIL : SXBP_OPERATION_OK
+    );
+    free(writer);
+    return result;
+}
+
+// disable GCC warning about the unused parameter, as only sizes are needed
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+// private function, write callback which only counts the bytes written
+static size_t count_svg_bytes(
+    const uint8_t* bytes, size_t size, void* user_data
+) {
+    *(size_t*)user_data += size;
+    return size;
+}
+// re-enable all warnings
+#pragma GCC diagnostic pop
+
+// private function, write callback which appends to a buffer of known size
+static size_t copy_svg_bytes(
+    const uint8_t* bytes, size_t size, void* user_data
+) {
+    sxbp_buffer_t* buffer = (sxbp_buffer_t*)user_data;
+    memcpy(buffer->bytes + buffer->size, bytes, size);
+    buffer->size += size;
+    return size;
+}
+
+sxbp_status_t sxbp_render_backend_svg(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(spiral.lines != NULL);
+    assert(buffer->bytes == NULL);
+    // render twice, first to find the size and then to fill the buffer
+    size_t size = 0;
+    sxbp_status_t result = sxbp_render_backend_svg_stream(
+        spiral, count_svg_bytes, (void*)&size
+    );
+    if(result != SXBP_OPERATION_OK) {
+        return result;
+    }
+    buffer->bytes = malloc(size);
+    // check fo memory allocation failure
+    if(buffer->bytes == NULL) {
+        return SXBP_MALLOC_REFUSED;
+    }
+    buffer->size = 0;
+    return sxbp_render_backend_svg_stream(
+        spiral, copy_svg_bytes, (void*)buffer
+    );
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
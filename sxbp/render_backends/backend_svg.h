@@ -0,0 +1,89 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ */
+
+/**
+ * @file
+ *
+ * @brief This compilation unit provides functionality to render a spiral to
+ * an SVG vector image, straight from its lines without building a bitmap.
+ *
+ * @remark Reference materials used for the SVG format are located at
+ * <https://www.w3.org/TR/SVG11/>
+ *
+ * @author Joshua Saxby <joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ * @date 2016, 2017
+ *
+ * @copyright Copyright (C) Joshua Saxby 2016, 2017
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef SAXBOPHONE_SAXBOSPIRAL_BACKEND_SVG_H
+#define SAXBOPHONE_SAXBOSPIRAL_BACKEND_SVG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../saxbospiral.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/**
+ * @brief Renders a spiral to an SVG image.
+ * @details The image is the same size as that of sxbp_render_spiral_raw(),
+ * with the line of the spiral drawn as a single path of 1 pixel thickness
+ * over a white background, so that it covers the same pixels (apart from the
+ * second pixel of the first line, which the raster renderers leave out).
+ * Consecutive lines going in the same direction are merged into one, and all
+ * co-ordinates are integers, so the size of the image is proportional to the
+ * number of turns of the spiral rather than to its area.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param[out] buffer Buffer to write out the SVG image data to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_render_backend_svg(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Renders a spiral to an SVG image, writing it out a piece at a time.
+ * @details The bytes written are identical to those of
+ * sxbp_render_backend_svg(), but only a small fixed amount of memory is used.
+ *
+ * @param spiral The spiral which should be rendered.
+ * @param write_callback A function pointer as accepted by
+ * sxbp_dump_spiral_stream(), which the image is written through.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the callback failed to write the image.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That write_callback is not NULL
+ */
+sxbp_status_t sxbp_render_backend_svg_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+// end of header file
+#endif
@@ -0,0 +1,535 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ *
+ * Copyright (C) 2016, 2017, Joshua Saxby joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../saxbospiral.h"
+#include "../render.h"
+#include "backend_tiff.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+// the size of the TIFF file header, which the compressed image follows
+#define TIFF_HEADER_SIZE 8
+// the number of entries in the image file directory (IFD) of each image
+#define TIFF_IFD_ENTRY_COUNT 13
+// the resolution the image is tagged with, in pixels per inch
+#define TIFF_RESOLUTION 72
+// the run length of the largest makeup code
+#define G4_LONGEST_MAKEUP 2560
+/*
+ * runs this long or longer can't be coded with one makeup code and one
+ * terminating code, so are started with the largest makeup code
+ */
+#define G4_LONG_RUN (G4_LONGEST_MAKEUP + 64)
+// the number of makeup codes in the table of each colour, for 64 to 1728
+#define G4_COLOUR_MAKEUP_COUNT 27
+// the number of makeup codes shared by both colours, for 1792 to 2560
+#define G4_EXTENDED_MAKEUP_COUNT 13
+
+// the text of the Software tag of each image
+static const char TIFF_SOFTWARE[] = "libsxbp v" LIBSXBP_VERSION_STRING;
+
+// private type, a code of the CCITT fax compression scheme
+typedef struct g4_code_t {
+    uint16_t code;
+    uint8_t length;
+} g4_code_t;
+
+// codes of white runs of 0 to 63 pixels
+static const g4_code_t G4_WHITE_TERMINATING[64] = {
+    { 0x035, 8, }, { 0x007, 6, }, { 0x007, 4, }, { 0x008, 4, }, { 0x00b, 4, },
+    { 0x00c, 4, }, { 0x00e, 4, }, { 0x00f, 4, }, { 0x013, 5, }, { 0x014, 5, },
+    { 0x007, 5, }, { 0x008, 5, }, { 0x008, 6, }, { 0x003, 6, }, { 0x034, 6, },
+    { 0x035, 6, }, { 0x02a, 6, }, { 0x02b, 6, }, { 0x027, 7, }, { 0x00c, 7, },
+    { 0x008, 7, }, { 0x017, 7, }, { 0x003, 7, }, { 0x004, 7, }, { 0x028, 7, },
+    { 0x02b, 7, }, { 0x013, 7, }, { 0x024, 7, }, { 0x018, 7, }, { 0x002, 8, },
+    { 0x003, 8, }, { 0x01a, 8, }, { 0x01b, 8, }, { 0x012, 8, }, { 0x013, 8, },
+    { 0x014, 8, }, { 0x015, 8, }, { 0x016, 8, }, { 0x017, 8, }, { 0x028, 8, },
+    { 0x029, 8, }, { 0x02a, 8, }, { 0x02b, 8, }, { 0x02c, 8, }, { 0x02d, 8, },
+    { 0x004, 8, }, { 0x005, 8, }, { 0x00a, 8, }, { 0x00b, 8, }, { 0x052, 8, },
+    { 0x053, 8, }, { 0x054, 8, }, { 0x055, 8, }, { 0x024, 8, }, { 0x025, 8, },
+    { 0x058, 8, }, { 0x059, 8, }, { 0x05a, 8, }, { 0x05b, 8, }, { 0x04a, 8, },
+    { 0x04b, 8, }, { 0x032, 8, }, { 0x033, 8, }, { 0x034, 8, },
+};
+// codes of white runs of multiples of 64 pixels, from 64 to 1728
+static const g4_code_t G4_WHITE_MAKEUP[G4_COLOUR_MAKEUP_COUNT] = {
+    { 0x01b, 5, }, { 0x012, 5, }, { 0x017, 6, }, { 0x037, 7, }, { 0x036, 8, },
+    { 0x037, 8, }, { 0x064, 8, }, { 0x065, 8, }, { 0x068, 8, }, { 0x067, 8, },
+    { 0x0cc, 9, }, { 0x0cd, 9, }, { 0x0d2, 9, }, { 0x0d3, 9, }, { 0x0d4, 9, },
+    { 0x0d5, 9, }, { 0x0d6, 9, }, { 0x0d7, 9, }, { 0x0d8, 9, }, { 0x0d9, 9, },
+    { 0x0da, 9, }, { 0x0db, 9, }, { 0x098, 9, }, { 0x099, 9, }, { 0x09a, 9, },
+    { 0x018, 6, }, { 0x09b, 9, },
+};
+// codes of black runs of 0 to 63 pixels
+static const g4_code_t G4_BLACK_TERMINATING[64] = {
+    { 0x037, 10, }, { 0x002, 3, }, { 0x003, 2, }, { 0x002, 2, }, { 0x003, 3, },
+    { 0x003, 4, }, { 0x002, 4, }, { 0x003, 5, }, { 0x005, 6, }, { 0x004, 6, },
+    { 0x004, 7, }, { 0x005, 7, }, { 0x007, 7, }, { 0x004, 8, }, { 0x007, 8, },
+    { 0x018, 9, }, { 0x017, 10, }, { 0x018, 10, }, { 0x008, 10, },
+    { 0x067, 11, }, { 0x068, 11, }, { 0x06c, 11, }, { 0x037, 11, },
+    { 0x028, 11, }, { 0x017, 11, }, { 0x018, 11, }, { 0x0ca, 12, },
+    { 0x0cb, 12, }, { 0x0cc, 12, }, { 0x0cd, 12, }, { 0x068, 12, },
+    { 0x069, 12, }, { 0x06a, 12, }, { 0x06b, 12, }, { 0x0d2, 12, },
+    { 0x0d3, 12, }, { 0x0d4, 12, }, { 0x0d5, 12, }, { 0x0d6, 12, },
+    { 0x0d7, 12, }, { 0x06c, 12, }, { 0x06d, 12, }, { 0x0da, 12, },
+    { 0x0db, 12, }, { 0x054, 12, }, { 0x055, 12, }, { 0x056, 12, },
+    { 0x057, 12, }, { 0x064, 12, }, { 0x065, 12, }, { 0x052, 12, },
+    { 0x053, 12, }, { 0x024, 12, }, { 0x037, 12, }, { 0x038, 12, },
+    { 0x027, 12, }, { 0x028, 12, }, { 0x058, 12, }, { 0x059, 12, },
+    { 0x02b, 12, }, { 0x02c, 12, }, { 0x05a, 12, }, { 0x066, 12, },
+    { 0x067, 12, },
+};
+// codes of black runs of multiples of 64 pixels, from 64 to 1728
+static const g4_code_t G4_BLACK_MAKEUP[G4_COLOUR_MAKEUP_COUNT] = {
+    { 0x00f, 10, }, { 0x0c8, 12, }, { 0x0c9, 12, }, { 0x05b, 12, },
+    { 0x033, 12, }, { 0x034, 12, }, { 0x035, 12, }, { 0x06c, 13, },
+    { 0x06d, 13, }, { 0x04a, 13, }, { 0x04b, 13, }, { 0x04c, 13, },
+    { 0x04d, 13, }, { 0x072, 13, }, { 0x073, 13, }, { 0x074, 13, },
+    { 0x075, 13, }, { 0x076, 13, }, { 0x077, 13, }, { 0x052, 13, },
+    { 0x053, 13, }, { 0x054, 13, }, { 0x055, 13, }, { 0x05a, 13, },
+    { 0x05b, 13, }, { 0x064, 13, }, { 0x065, 13, },
+};
+// codes of runs of either colour of multiples of 64 pixels, from 1792 to 2560
+static const g4_code_t G4_EXTENDED_MAKEUP[G4_EXTENDED_MAKEUP_COUNT] = {
+    { 0x008, 11, }, { 0x00c, 11, }, { 0x00d, 11, }, { 0x012, 12, },
+    { 0x013, 12, }, { 0x014, 12, }, { 0x015, 12, }, { 0x016, 12, },
+    { 0x017, 12, }, { 0x01c, 12, }, { 0x01d, 12, }, { 0x01e, 12, },
+    { 0x01f, 12, },
+};
+
+
+// the code which flags a pass mode
+static const g4_code_t G4_PASS = { 0x1, 4, };
+// the code which flags a horizontal mode, followed by two runs
+static const g4_code_t G4_HORIZONTAL = { 0x1, 3, };
+// the codes of vertical modes, for a1 being 3 to the right to 3 to the left
+static const g4_code_t G4_VERTICAL[7] = {
+    { 0x03, 7, }, { 0x03, 6, }, { 0x3, 3, }, { 0x1, 1, }, { 0x2, 3, },
+    { 0x02, 6, }, { 0x02, 7, },
+};
+// the end of facsimile block code, written twice after the last row
+static const g4_code_t G4_EOL = { 0x001, 12, };
+
+/*
+ * private type, holds the state of the bits of the TIFF image as they are
+ * written into a buffer which grows as needed
+ */
+typedef struct tiff_writer_t {
+    uint8_t* bytes;
+    size_t size;
+    size_t capacity;
+    // bits waiting to be written out, most significant first
+    uint32_t bits;
+    uint8_t bit_count;
+    // set to SXBP_MALLOC_REFUSED if the buffer couldn't be grown
+    sxbp_status_t status;
+} tiff_writer_t;
+
+/*
+ * private function, makes sure the writer has room for size more bytes,
+ * doubling the capacity of its buffer if needed. Returns false if the memory
+ * couldn't be allocated.
+ */
+static bool reserve_tiff_bytes(tiff_writer_t* writer, size_t size) {
+    if(writer->status != SXBP_OPERATION_OK) {
+        return false;
+    }
+    if(writer->capacity - writer->size >= size) {
+        return true;
+    }
+    size_t capacity = writer->capacity * 2;
+    if(capacity < writer->size + size) {
+        capacity = writer->size + size;
+    }
+    uint8_t* bytes = realloc(writer->bytes, capacity);
+    if(bytes == NULL) {
+        writer->status = SXBP_MALLOC_REFUSED;
+        return false;
+    }
+    writer->bytes = bytes;
+    writer->capacity = capacity;
+    return true;
+}
+
+// private function, writes a code, most significant bit first
+static void write_g4_code(tiff_writer_t* writer, g4_code_t code) {
+    writer->bits = (writer->bits << code.length) | code.code;
+    writer->bit_count = (uint8_t)(writer->bit_count + code.length);
+    while(writer->bit_count >= 8) {
+        writer->bit_count = (uint8_t)(writer->bit_count - 8);
+        if(reserve_tiff_bytes(writer, 1)) {
+            writer->bytes[writer->size] = (uint8_t)(
+                writer->bits >> writer->bit_count
+            );
+            writer->size++;
+        }
+    }
+    // only the bits not yet written out need to be kept
+    writer->bits &= (1u << writer->bit_count) - 1;
+}
+
+/*
+ * private function, writes the codes for a run of the given length of white
+ * pixels if black is false, or black pixels if it is true
+ */
+static void write_g4_run(tiff_writer_t* writer, uint32_t length, bool black) {
+    const g4_code_t* terminating = (
+        black ? G4_BLACK_TERMINATING : G4_WHITE_TERMINATING
+    );
+    const g4_code_t* makeup = black ? G4_BLACK_MAKEUP : G4_WHITE_MAKEUP;
+    // very long runs are split up with the largest makeup code
+    while(length >= G4_LONG_RUN) {
+        write_g4_code(writer, G4_EXTENDED_MAKEUP[G4_EXTENDED_MAKEUP_COUNT - 1]);
+        length -= G4_LONGEST_MAKEUP;
+    }
+    if(length >= 64) {
+        uint32_t multiple = length / 64;
+        length -= multiple * 64;
+        // the shared extended codes carry on from the end of the colour's own
+        if(multiple <= G4_COLOUR_MAKEUP_COUNT) {
+            write_g4_code(writer, makeup[multiple - 1]);
+        } else {
+            uint32_t extended = multiple - (G4_COLOUR_MAKEUP_COUNT + 1);
+            write_g4_code(writer, G4_EXTENDED_MAKEUP[extended]);
+        }
+    }
+    write_g4_code(writer, terminating[length]);
+}
+
+// private function, gives the colour of pixel x of a row, true for black
+static bool g4_pixel(const uint8_t* row, uint32_t x) {
+    return (row[x / 8] >> (7 - (x % 8))) & 1;
+}
+
+/*
+ * private function, gives the position of the first pixel of row from start
+ * onwards which isn't of the given colour, or width if there isn't one.
+ * Whole bytes of the same colour are skipped over at once.
+ */
+static uint32_t find_g4_change(
+    const uint8_t* row, uint32_t start, uint32_t width, bool black
+) {
+    uint8_t same = black ? 0xff : 0x00;
+    uint32_t x = start;
+    while(x < width) {
+        if(x % 8 == 0 && row[x / 8] == same) {
+            x += 8;
+        } else if(g4_pixel(row, x) != black) {
+            return x;
+        } else {
+            x++;
+        }
+    }
+    return width;
+}
+
+/*
+ * private function, finds the changing elements of a row of width pixels
+ * packed as in a bitmap, which are the pixels which differ in colour from the
+ * pixel before them, where there is an imaginary white pixel before the start
+ * of the row. Returns how many there are.
+ */
+static size_t find_bitmap_changes(
+    const uint8_t* row, uint32_t width, uint32_t* changes
+) {
+    size_t count = 0;
+    bool black = false;
+    uint32_t x = find_g4_change(row, 0, width, black);
+    while(x < width) {
+        changes[count] = x;
+        count++;
+        black = !black;
+        x = find_g4_change(row, x, width, black);
+    }
+    return count;
+}
+
+/*
+ * private function, finds the changing elements of row y of the bitmap
+ * pointed to by image, for write_tiff_g4()
+ */
+static size_t get_bitmap_changes(
+    const void* image, uint32_t y, uint32_t* changes
+) {
+    const sxbp_bitmap_t* bitmap = (const sxbp_bitmap_t*)image;
+    const uint8_t* row = (
+        bitmap->pixels + (y * sxbp_bitmap_row_size(bitmap->width))
+    );
+    return find_bitmap_changes(row, bitmap->width, changes);
+}
+
+/*
+ * private function, finds the changing elements of row y of the run-length
+ * encoded bitmap pointed to by image, for write_tiff_g4(). These are simply
+ * the ends of the runs, as runs never touch.
+ */
+static size_t get_rle_changes(
+    const void* image, uint32_t y, uint32_t* changes
+) {
+    const sxbp_rle_bitmap_t* rle = (const sxbp_rle_bitmap_t*)image;
+    size_t count = 0;
+    for(size_t i = rle->row_starts[y]; i < rle->row_starts[y + 1]; i++) {
+        uint32_t end = rle->runs[i].x + rle->runs[i].length;
+        changes[count] = rle->runs[i].x;
+        count++;
+        // a run reaching the edge of the image doesn't change back to white
+        if(end < rle->width) {
+            changes[count] = end;
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+ * private function, encodes one row of width pixels in the 2-dimensional
+ * coding of CCITT Group 4, relative to the reference row above it. Both rows
+ * are given as their changing elements in ascending order, followed by at
+ * least three copies of width, so that looking past the last change always
+ * finds the end of the row.
+ */
+static void encode_g4_row(
+    tiff_writer_t* writer, const uint32_t* changes, const uint32_t* reference,
+    uint32_t width
+) {
+    uint32_t a0 = 0;
+    // a1 is changes[a1_index], and a0 is black when a1_index is odd
+    size_t a1_index = 0;
+    // the first change of the reference row to the right of a0
+    size_t r = 0;
+    // at the start, a0 is the imaginary pixel to the left of the row
+    bool start = true;
+    for(;;) {
+        while(!start && reference[r] <= a0) {
+            r++;
+        }
+        start = false;
+        // b1 is the first change to the right of a0 to the other colour to a0
+        size_t b1_index = r + ((r % 2) != (a1_index % 2));
+        uint32_t a1 = changes[a1_index];
+        uint32_t b1 = reference[b1_index];
+        uint32_t b2 = reference[b1_index + 1];
+        bool colour = (a1_index % 2) == 1;
+        if(b2 < a1) {
+            // pass mode, the run of the reference row ends before a1
+            write_g4_code(writer, G4_PASS);
+            a0 = b2;
+        } else if(a1 + 3 >= b1 && b1 + 3 >= a1) {
+            // vertical mode, a1 is within 3 pixels of b1
+            write_g4_code(writer, G4_VERTICAL[3 + b1 - a1]);
+            a0 = a1;
+            a1_index++;
+        } else {
+            // horizontal mode, the next two runs are coded in full
+            uint32_t a2 = changes[a1_index + 1];
+            write_g4_code(writer, G4_HORIZONTAL);
+            write_g4_run(writer, a1 - a0, colour);
+            write_g4_run(writer, a2 - a1, !colour);
+            a0 = a2;
+            a1_index += 2;
+        }
+        if(a0 >= width) {
+            return;
+        }
+    }
+}
+
+// private function, writes a 16-bit unsigned integer as little-endian bytes
+static void dump_tiff_uint16(uint16_t value, uint8_t* bytes) {
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+// private function, writes a 32-bit unsigned integer as little-endian bytes
+static void dump_tiff_uint32(uint32_t value, uint8_t* bytes) {
+    for(uint8_t i = 0; i < 4; i++) {
+        bytes[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+/*
+ * private function, writes one IFD entry to bytes and returns where the next
+ * one should go. Values of type SHORT and LONG are stored in the entry itself
+ * (short ones padded out to 4 bytes), others are the offset of the data.
+ */
+static uint8_t* write_tiff_entry(
+    uint8_t* bytes, uint16_t tag, uint16_t type, uint32_t count,
+    uint32_t value
+) {
+    dump_tiff_uint16(tag, bytes);
+    dump_tiff_uint16(type, bytes + 2);
+    dump_tiff_uint32(count, bytes + 4);
+    dump_tiff_uint32(value, bytes + 8);
+    return bytes + 12;
+}
+
+/*
+ * private function, writes the IFD of the TIFF image of bitmap followed by
+ * the data which its entries point to, starting at the given offset of bytes.
+ * The image data must be stored in one strip immediately after the header.
+ */
+static void write_tiff_ifd(
+    sxbp_bitmap_t bitmap, uint32_t strip_size, uint8_t* bytes,
+    uint32_t ifd_offset
+) {
+    // the data which doesn't fit in the entries follows the IFD
+    uint32_t resolution_offset = (
+        ifd_offset + 2 + (TIFF_IFD_ENTRY_COUNT * 12) + 4
+    );
+    uint32_t software_offset = resolution_offset + 16;
+    uint8_t* entry = bytes + ifd_offset;
+    dump_tiff_uint16(TIFF_IFD_ENTRY_COUNT, entry);
+    entry += 2;
+    // entries must be in ascending order of tag
+    entry = write_tiff_entry(entry, 256, 4, 1, bitmap.width); // ImageWidth
+    entry = write_tiff_entry(entry, 257, 4, 1, bitmap.height); // ImageLength
+    entry = write_tiff_entry(entry, 258, 3, 1, 1); // BitsPerSample
+    entry = write_tiff_entry(entry, 259, 3, 1, 4); // Compression, CCITT G4
+    // PhotometricInterpretation, WhiteIsZero like the pixels of bitmaps
+    entry = write_tiff_entry(entry, 262, 3, 1, 0);
+    // StripOffsets, the one strip follows the header
+    entry = write_tiff_entry(entry, 273, 4, 1, TIFF_HEADER_SIZE);
+    entry = write_tiff_entry(entry, 277, 3, 1, 1); // SamplesPerPixel
+    entry = write_tiff_entry(entry, 278, 4, 1, bitmap.height); // RowsPerStrip
+    entry = write_tiff_entry(entry, 279, 4, 1, strip_size); // StripByteCounts
+    // XResolution and YResolution
+    entry = write_tiff_entry(entry, 282, 5, 1, resolution_offset);
+    entry = write_tiff_entry(entry, 283, 5, 1, resolution_offset + 8);
+    entry = write_tiff_entry(entry, 296, 3, 1, 2); // ResolutionUnit, inches
+    // Software
+    entry = write_tiff_entry(
+        entry, 305, 2, sizeof(TIFF_SOFTWARE), software_offset
+    );
+    // there are no more IFDs
+    dump_tiff_uint32(0, entry);
+    // both resolutions are the same fraction
+    for(uint8_t i = 0; i < 2; i++) {
+        dump_tiff_uint32(TIFF_RESOLUTION, bytes + resolution_offset + (8 * i));
+        dump_tiff_uint32(1, bytes + resolution_offset + (8 * i) + 4);
+    }
+    memcpy(bytes + software_offset, TIFF_SOFTWARE, sizeof(TIFF_SOFTWARE));
+}
+
+/*
+ * private function, writes a TIFF image of the given size to buffer,
+ * fetching the changing elements of each row from image with get_changes()
+ */
+static sxbp_status_t write_tiff_g4(
+    sxbp_bitmap_t size,
+    size_t(* get_changes)(const void* image, uint32_t y, uint32_t* changes),
+    const void* image, sxbp_buffer_t* buffer
+) {
+    tiff_writer_t writer = {
+        .bytes = NULL, .size = 0, .capacity = 0, .bits = 0, .bit_count = 0,
+        .status = SXBP_OPERATION_OK,
+    };
+    /*
+     * the changing elements of the current row and the row above, each of
+     * which may have as many as there are pixels, plus the copies of the width
+     * which follow them
+     */
+    uint32_t* changes = malloc(((size_t)size.width + 4) * sizeof(uint32_t));
+    uint32_t* reference = malloc(((size_t)size.width + 4) * sizeof(uint32_t));
+    if(
+        changes == NULL || reference == NULL ||
+        !reserve_tiff_bytes(&writer, TIFF_HEADER_SIZE)
+    ) {
+        free(changes);
+        free(reference);
+        free(writer.bytes);
+        return SXBP_MALLOC_REFUSED;
+    }
+    // little-endian byte order, then the magic number
+    memcpy(writer.bytes, "II*\0", 4);
+    writer.size = TIFF_HEADER_SIZE;
+    // the row above the first is taken to be white, so has no changes
+    for(uint8_t i = 0; i < 3; i++) {
+        reference[i] = size.width;
+    }
+    for(uint32_t y = 0; y < size.height; y++) {
+        size_t count = get_changes(image, y, changes);
+        for(uint8_t i = 0; i < 3; i++) {
+            changes[count + i] = size.width;
+        }
+        encode_g4_row(&writer, changes, reference, size.width);
+        // this row is the reference for the next
+        uint32_t* swap = reference;
+        reference = changes;
+        changes = swap;
+    }
+    free(changes);
+    free(reference);
+    // end of facsimile block, padded out to a whole byte
+    write_g4_code(&writer, G4_EOL);
+    write_g4_code(&writer, G4_EOL);
+    if(writer.bit_count > 0) {
+        g4_code_t padding = { 0, (uint8_t)(8 - writer.bit_count), };
+        write_g4_code(&writer, padding);
+    }
+    uint32_t strip_size = (uint32_t)(writer.size - TIFF_HEADER_SIZE);
+    // the IFD must start on a word boundary
+    size_t ifd_offset = writer.size + (writer.size % 2);
+    size_t ifd_size = (
+        2 + (TIFF_IFD_ENTRY_COUNT * 12) + 4 + 16 + sizeof(TIFF_SOFTWARE)
+    );
+    if(
+        !reserve_tiff_bytes(&writer, (ifd_offset - writer.size) + ifd_size)
+    ) {
+        free(writer.bytes);
+        return writer.status;
+    }
+    // TIFF offsets are 32-bit, so larger images can't be stored
+    if(ifd_offset + ifd_size > UINT32_MAX) {
+        free(writer.bytes);
+        return SXBP_OPERATION_FAIL;
+    }
+    writer.bytes[writer.size] = 0;
+    dump_tiff_uint32((uint32_t)ifd_offset, writer.bytes + 4);
+    write_tiff_ifd(size, strip_size, writer.bytes, (uint32_t)ifd_offset);
+    buffer->size = ifd_offset + ifd_size;
+    // give back the memory which the image turned out not to need
+    buffer->bytes = realloc(writer.bytes, buffer->size);
+    if(buffer->bytes == NULL) {
+        buffer->bytes = writer.bytes;
+    }
+    return SXBP_OPERATION_OK;
+}
+
+sxbp_status_t sxbp_render_backend_tiff_g4(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(bitmap.pixels != NULL);
+    assert(buffer->bytes == NULL);
+    return write_tiff_g4(bitmap, get_bitmap_changes, &bitmap, buffer);
+}
+
+sxbp_status_t sxbp_render_backend_tiff_g4_rle(
+    sxbp_rle_bitmap_t image, sxbp_buffer_t* buffer
+) {
+    // preconditional assertsions
+    assert(image.runs != NULL);
+    assert(buffer->bytes == NULL);
+    sxbp_bitmap_t size = { .width = image.width, .height = image.height, };
+    return write_tiff_g4(size, get_rle_changes, &image, buffer);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,86 @@
+/*
+ * This source file forms part of libsxbp, a library which generates
+ * experimental 2D spiral-like shapes based on input binary data.
+ */
+
+/**
+ * @file
+ *
+ * @brief This compilation unit provides functionality to render a bitmap struct
+ * to a bilevel TIFF image compressed with CCITT Group 4 (stored in a buffer).
+ *
+ * @remark Reference materials used for the TIFF format and the compression
+ * scheme are the TIFF 6.0 specification and ITU-T recommendations T.4 and T.6.
+ *
+ * @author Joshua Saxby <joshua.a.saxby+TNOPLuc8vM==@gmail.com
+ * @date 2016, 2017
+ *
+ * @copyright Copyright (C) Joshua Saxby 2016, 2017
+ *
+ * @copyright
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#ifndef SAXBOPHONE_SAXBOSPIRAL_BACKEND_TIFF_H
+#define SAXBOPHONE_SAXBOSPIRAL_BACKEND_TIFF_H
+
+#include "../saxbospiral.h"
+#include "../render.h"
+
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+/**
+ * @brief Renders a bitmap image to a TIFF image compressed with CCITT Group 4.
+ * @details Group 4 codes each row by where its changes of colour are relative
+ * to those of the row above, which suits sparse line art such as spirals
+ * well, giving small files quickly. No external libraries are needed. The
+ * image is stored in one strip, and may be used as an image writer callback
+ * for sxbp_render_spiral_image().
+ *
+ * @param bitmap Bitmap containing the image to render.
+ * @param[out] buffer Buffer to write out the TIFF image data to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the image is too large for a TIFF file.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That bitmap.pixels is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_render_backend_tiff_g4(
+    sxbp_bitmap_t bitmap, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Renders a run-length encoded bitmap image to a TIFF image compressed
+ * with CCITT Group 4.
+ * @details The bytes written are identical to those of
+ * sxbp_render_backend_tiff_g4() for the same pixels. Group 4 codes the
+ * positions where each row changes colour, which are just the ends of the
+ * runs, so the pixels are never expanded and time taken is proportional to the
+ * number of runs rather than to the area of the image.
+ *
+ * @param image Run-length encoded bitmap containing the image to render.
+ * @param[out] buffer Buffer to write out the TIFF image data to.
+ * @return SXBP_OPERATION_OK on success.
+ * @return SXBP_OPERATION_FAIL if the image is too large for a TIFF file.
+ * @return SXBP_MALLOC_REFUSED on memory allocation failure.
+ *
+ * @note Asserts:
+ * - That image.runs is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_status_t sxbp_render_backend_tiff_g4_rle(
+    sxbp_rle_bitmap_t image, sxbp_buffer_t* buffer
+);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+// end of header file
+#endif
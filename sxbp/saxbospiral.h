@@ -176,6 +176,18 @@ typedef struct sxbp_co_ord_cache_t {
     /** @brief the index of the spiral line for which this set of cached co-ords
      * is valid up to */
     size_t validity;
+    /**
+     * @brief the smallest and largest of the cached co-ords, which are the
+     * bottom-left and top-right corners of the bounding box of the spiral
+     * @private
+     */
+    sxbp_co_ord_t bounds[2];
+    /**
+     * @brief the index into the cached co-ords of where the smallest x, the
+     * smallest y, the largest x and the largest y were first reached
+     * @private
+     */
+    size_t extremes[4];
 } sxbp_co_ord_cache_t;
 
 /**
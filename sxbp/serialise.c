@@ -9,12 +9,13 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 #include <assert.h>
+#include <stdbool.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "saxbospiral.h"
+#include "initialise.h"
 #include "serialise.h"
 
 
@@ -32,6 +33,25 @@ const size_t SXBP_FILE_HEADER_SIZE = (
     4 // number of seconds accuracy of solve time, 32 bit uint
 );
 const size_t SXBP_LINE_T_PACK_SIZE = 4;
+/*
+ * the number of bytes of line data which the streaming functions pack or
+ * unpack at a time (this must be a multiple of SXBP_LINE_T_PACK_SIZE)
+ */
+#define STREAM_CHUNK_SIZE 4096
+/*
+ * the number of lines below which packing and unpacking is not worth splitting
+ * across threads (only used when built with OpenMP support)
+ */
+#define PARALLEL_LINES_THRESHOLD 65536
+/*
+ * the number of lines in each block of the index of a spiral in the compact
+ * format, which bounds how many lines before a requested range are decoded
+ */
+#define LINE_INDEX_BLOCK_SIZE 1024
+const size_t SXBP_NATIVE_FILE_HEADER_SIZE = (
+    26 + // the same fields as the standard header, in the same order
+    6 // zero padding, to align the lines that follow to 32 bytes
+);
 
 /*
  * NOTE: The following load_x and dump_x functions all use big-endian
@@ -103,21 +123,314 @@ static void dump_uint32_t(
     }
 }
 
-sxbp_serialise_result_t sxbp_load_spiral(
-    sxbp_buffer_t buffer, sxbp_spiral_t* spiral
+/*
+ * NOTE: Unlike the others, the following two functions use little-endian
+ * representation, as used by the data section of the native file format.
+ */
+
+// loads a little-endian 32-bit unsigned integer from the given bytes
+static uint32_t load_uint32_le(const uint8_t* bytes) {
+    return (
+        (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+        ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24)
+    );
+}
+
+// dumps a 32-bit unsigned integer of value to the given bytes, little-endian
+static void dump_uint32_le(uint32_t value, uint8_t* bytes) {
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+    bytes[2] = (uint8_t)(value >> 16);
+    bytes[3] = (uint8_t)(value >> 24);
+}
+
+/*
+ * private function, returns the number of bytes needed to store the given
+ * line length as a variable-length integer in the compact format
+ */
+static size_t varint_size(sxbp_length_t length) {
+    size_t size = 1;
+    while(length >= 0x80) {
+        length >>= 7;
+        size++;
+    }
+    return size;
+}
+
+/*
+ * private function, writes the header common to all spiral file formats
+ * (with the given magic number) to the start of buffer
+ *
+ * Asserts:
+ * - That buffer->bytes is not NULL
+ */
+static void dump_header(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer, const char* magic_number
 ) {
     // preconditional assertions
-    assert(buffer.bytes != NULL);
-    assert(spiral->lines == NULL);
-    sxbp_serialise_result_t result; // build struct for returning success / failure
-    // first, if header is too small for header + 1 line, then return early
-    if(buffer.size < SXBP_FILE_HEADER_SIZE + SXBP_LINE_T_PACK_SIZE) {
-        result.status = SXBP_OPERATION_FAIL; // flag failure
-        result.diagnostic = SXBP_DESERIALISE_BAD_HEADER_SIZE; // failure reason
-        return result;
+    assert(buffer->bytes != NULL);
+    // write magic number to buffer
+    memcpy(buffer->bytes, magic_number, 4);
+    // write out version info to buffer
+    dump_uint16_t(LIB_SXBP_VERSION.major, buffer, 4);
+    dump_uint16_t(LIB_SXBP_VERSION.minor, buffer, 6);
+    dump_uint16_t(LIB_SXBP_VERSION.patch, buffer, 8);
+    // write second part of data header
+    dump_uint32_t(spiral.size, buffer, 10);
+    dump_uint32_t(spiral.solved_count, buffer, 14);
+    dump_uint32_t(spiral.seconds_spent, buffer, 18);
+    dump_uint32_t(spiral.seconds_accuracy, buffer, 22);
+}
+
+/*
+ * private function, returns whether the in-memory representation of
+ * sxbp_line_t on this platform is the same as the native file format's, which
+ * stores the direction in the 2 least significant bits of a little-endian
+ * 32-bit word and the length in the 30 bits above it.
+ */
+static bool native_layout_matches(void) {
+    if(sizeof(sxbp_line_t) != SXBP_LINE_T_PACK_SIZE) {
+        return false;
+    }
+    sxbp_line_t line = { .direction = SXBP_LEFT, .length = 0x2468ace, };
+    uint8_t expected[4];
+    dump_uint32_le(((uint32_t)line.length << 2) | line.direction, expected);
+    return memcmp(&line, expected, sizeof(line)) == 0;
+}
+
+/*
+ * private function, returns whether each line on this platform, copied into a
+ * uint32_t, holds its length in the upper 30 bits and its direction in the
+ * lower 2. This is the case where native_layout_matches() and the platform is
+ * little-endian, and means lines can be converted a whole word at a time.
+ */
+static bool line_words_match(void) {
+    if(!native_layout_matches()) {
+        return false;
+    }
+    sxbp_line_t line = { .direction = SXBP_LEFT, .length = 0x2468ace, };
+    uint32_t word;
+    memcpy(&word, &line, sizeof(word));
+    return word == (((uint32_t)line.length << 2) | line.direction);
+}
+
+/*
+ * private function, converts a line of the standard format (as copied into a
+ * uint32_t straight from its big-endian bytes on a little-endian platform)
+ * into the word holding the same line in memory where line_words_match().
+ * That is, its bytes are swapped and it is rotated left by 2 bits.
+ *
+ * NOTE: This is written as plain shifts and masks of the whole word, rather
+ * than as a byte swap, which compilers turn into an instruction which can't
+ * be vectorised without byte shuffles (such as on plain x86-64 with SSE2).
+ */
+static uint32_t unpack_line_word(uint32_t word) {
+    return (
+        ((word & 0x0000003f) << 26) | ((word & 0x0000ff00) << 10) |
+        ((word >> 6) & 0x0003fc00) | ((word >> 22) & 0x000003fc) |
+        ((word >> 6) & 0x00000003)
+    );
+}
+
+/*
+ * private function, the reverse of unpack_line_word(), rotating right by 2
+ * bits and then swapping the bytes in the same way
+ */
+static uint32_t pack_line_word(uint32_t word) {
+    return (
+        (word >> 26) | ((word & 0x00000003) << 6) |
+        ((word >> 10) & 0x0000ff00) | ((word << 6) & 0x00ff0000) |
+        ((word << 22) & 0xff000000)
+    );
+}
+
+/*
+ * private function, unpacks count lines from the fixed-width representation
+ * used by the data section of the standard format in bytes, into lines
+ *
+ * NOTE: Where line_words_match(), each line is copied in as a word, converted
+ * with unpack_line_word() and copied out again, a loop which optimising
+ * compilers vectorise. Elsewhere, the loop can't be vectorised as each line's
+ * bitfields are set one at a time. With OpenMP support enabled, very large
+ * line counts are also split across threads.
+ */
+static void unpack_lines_fixed(
+    const uint8_t* bytes, size_t count, sxbp_line_t* lines
+) {
+    if(line_words_match()) {
+        // lines are copied to as plain bytes, which is what they're made of
+        uint8_t* words = (uint8_t*)lines;
+        #ifdef LIBSXBP_OPENMP_SUPPORT
+        #pragma omp parallel for if(count >= PARALLEL_LINES_THRESHOLD) schedule(static)
+        #endif
+        for(size_t i = 0; i < count; i++) {
+            uint32_t word;
+            memcpy(&word, bytes + (i * SXBP_LINE_T_PACK_SIZE), sizeof(word));
+            word = unpack_line_word(word);
+            memcpy(words + (i * SXBP_LINE_T_PACK_SIZE), &word, sizeof(word));
+        }
+        return;
+    }
+    // convert each serialised line segment in bytes into a line_t struct
+    #ifdef LIBSXBP_OPENMP_SUPPORT
+    #pragma omp parallel for if(count >= PARALLEL_LINES_THRESHOLD) schedule(static)
+    #endif
+    for(size_t i = 0; i < count; i++) {
+        const uint8_t* packed = bytes + (i * SXBP_LINE_T_PACK_SIZE);
+        uint32_t word = (
+            ((uint32_t)packed[0] << 24) | ((uint32_t)packed[1] << 16) |
+            ((uint32_t)packed[2] << 8) | (uint32_t)packed[3]
+        );
+        // direction is stored in 2 most significant bits of each 32-bit word
+        lines[i].direction = word >> 30;
+        // length is stored as the 30 least significant bits
+        lines[i].length = word & 0x3fffffff;
+    }
+}
+
+/*
+ * private function, packs count lines into the fixed-width representation
+ * used by the data section of the standard format, writing them to bytes
+ *
+ * NOTE: This is the reverse of unpack_lines_fixed(), with the same word at a
+ * time conversion where line_words_match().
+ */
+static void pack_lines_fixed(
+    const sxbp_line_t* lines, size_t count, uint8_t* bytes
+) {
+    if(line_words_match()) {
+        // lines are copied from as plain bytes, which is what they're made of
+        const uint8_t* words = (const uint8_t*)lines;
+        #ifdef LIBSXBP_OPENMP_SUPPORT
+        #pragma omp parallel for if(count >= PARALLEL_LINES_THRESHOLD) schedule(static)
+        #endif
+        for(size_t i = 0; i < count; i++) {
+            uint32_t word;
+            memcpy(&word, words + (i * SXBP_LINE_T_PACK_SIZE), sizeof(word));
+            word = pack_line_word(word);
+            memcpy(bytes + (i * SXBP_LINE_T_PACK_SIZE), &word, sizeof(word));
+        }
+        return;
+    }
+    #ifdef LIBSXBP_OPENMP_SUPPORT
+    #pragma omp parallel for if(count >= PARALLEL_LINES_THRESHOLD) schedule(static)
+    #endif
+    for(size_t i = 0; i < count; i++) {
+        // map direction to 2 most significant bits, length to the other 30
+        uint32_t word = (
+            ((uint32_t)lines[i].direction << 30) | (uint32_t)lines[i].length
+        );
+        uint8_t* packed = bytes + (i * SXBP_LINE_T_PACK_SIZE);
+        packed[0] = (uint8_t)(word >> 24);
+        packed[1] = (uint8_t)(word >> 16);
+        packed[2] = (uint8_t)(word >> 8);
+        packed[3] = (uint8_t)word;
+    }
+}
+
+/*
+ * private function, decodes the compact data section of buffer into the
+ * already-allocated lines of spiral. Returns SXBP_DESERIALISE_OK if the data
+ * section was valid, SXBP_DESERIALISE_BAD_DATA_SIZE if not.
+ */
+static sxbp_deserialise_diagnostic_t load_lines_compact(
+    sxbp_buffer_t buffer, sxbp_spiral_t* spiral
+) {
+    size_t index = SXBP_FILE_HEADER_SIZE;
+    size_t turn_bytes = (spiral->size - 1 + 7) / 8;
+    // the first byte holds the direction of the first line
+    sxbp_direction_t current = buffer.bytes[index] & 0x03;
+    index++;
+    if(buffer.size - index < turn_bytes) {
+        return SXBP_DESERIALISE_BAD_DATA_SIZE;
     }
+    // every other direction is one turn on from the direction before it
+    spiral->lines[0].direction = current;
+    for(size_t i = 1; i < spiral->size; i++) {
+        uint8_t bit = (
+            buffer.bytes[index + ((i - 1) / 8)] >> (7 - ((i - 1) % 8))
+        ) & 1;
+        current = sxbp_change_direction(
+            current, (bit == 0) ? SXBP_CLOCKWISE : SXBP_ANTI_CLOCKWISE
+        );
+        spiral->lines[i].direction = current;
+    }
+    index += turn_bytes;
+    // then the lengths follow as little-endian base 128 varints
+    for(size_t i = 0; i < spiral->size; i++) {
+        uint32_t length = 0;
+        uint8_t shift = 0;
+        uint8_t byte;
+        do {
+            // the data ran out or the varint was too long for a line length
+            if(index == buffer.size || shift > 28) {
+                return SXBP_DESERIALISE_BAD_DATA_SIZE;
+            }
+            byte = buffer.bytes[index];
+            length |= (uint32_t)(byte & 0x7f) << shift;
+            shift += 7;
+            index++;
+        } while(byte & 0x80);
+        // line lengths are only 30 bits wide
+        if(length > 0x3fffffff) {
+            return SXBP_DESERIALISE_BAD_DATA_SIZE;
+        }
+        spiral->lines[i].length = length;
+    }
+    // there should be no data left over afterwards
+    if(index != buffer.size) {
+        return SXBP_DESERIALISE_BAD_DATA_SIZE;
+    }
+    return SXBP_DESERIALISE_OK;
+}
+
+/*
+ * private function, unpacks count lines from the little-endian representation
+ * used by the data section of the native format in bytes, into lines
+ */
+static void unpack_lines_native(
+    const uint8_t* bytes, size_t count, sxbp_line_t* lines
+) {
+    #ifdef LIBSXBP_OPENMP_SUPPORT
+    #pragma omp parallel for if(count >= PARALLEL_LINES_THRESHOLD) schedule(static)
+    #endif
+    for(size_t i = 0; i < count; i++) {
+        uint32_t word = load_uint32_le(bytes + (i * SXBP_LINE_T_PACK_SIZE));
+        lines[i].direction = word & 0x03;
+        lines[i].length = word >> 2;
+    }
+}
+
+/*
+ * private function, works out which format the spiral data in buffer is in
+ * from its magic number. Data with an unrecognised magic number is treated as
+ * the standard format, so that it is rejected with the standard diagnostics.
+ */
+static sxbp_file_format_t detect_format(sxbp_buffer_t buffer) {
+    if(buffer.size >= 4 && strncmp((char*)buffer.bytes, "sxbc", 4) == 0) {
+        return SXBP_FILE_FORMAT_COMPACT;
+    } else if(buffer.size >= 4 && strncmp((char*)buffer.bytes, "sxbn", 4) == 0) {
+        return SXBP_FILE_FORMAT_NATIVE;
+    } else {
+        return SXBP_FILE_FORMAT_STANDARD;
+    }
+}
+
+/*
+ * private function, checks the magic number and version in the header of the
+ * spiral data in buffer, which must be at least SXBP_FILE_HEADER_SIZE bytes
+ * and be of the given format (as returned by detect_format())
+ */
+static sxbp_serialise_result_t validate_header_fields(
+    sxbp_buffer_t buffer, sxbp_file_format_t format
+) {
+    sxbp_serialise_result_t result; // build struct for returning success / failure
+    result.diagnostic = SXBP_DESERIALISE_OK;
     // check for magic number and return early if not right
-    if(strncmp((char*)buffer.bytes, "sxbp", 4) != 0) {
+    if(
+        (format == SXBP_FILE_FORMAT_STANDARD) &&
+        (strncmp((char*)buffer.bytes, "sxbp", 4) != 0)
+    ) {
         result.status = SXBP_OPERATION_FAIL; // flag failure
         result.diagnostic = SXBP_DESERIALISE_BAD_MAGIC_NUMBER; // failure reason
         return result;
@@ -128,9 +441,16 @@ sxbp_serialise_result_t sxbp_load_spiral(
         .minor = load_uint16_t(&buffer, 6),
         .patch = load_uint16_t(&buffer, 8),
     };
-    // we don't accept anything less than v0.26.0, so the min is v0.26.0
+    /*
+     * we don't accept anything less than v0.26.0, so the min is v0.26.0
+     * the compact and native formats were introduced in v0.27.0
+     */
     // TODO: Add this as a library constant - to add in next minor release
-    sxbp_version_t min_version = { .major = 0, .minor = 26, .patch = 0, };
+    sxbp_version_t min_version = {
+        .major = 0,
+        .minor = (format == SXBP_FILE_FORMAT_STANDARD) ? 26 : 27,
+        .patch = 0,
+    };
     // check for version compatibility
     if(sxbp_version_less_than(buffer_version, min_version)) {
         // check failed
@@ -138,18 +458,103 @@ sxbp_serialise_result_t sxbp_load_spiral(
         result.diagnostic = SXBP_DESERIALISE_BAD_VERSION; // failure reason
         return result;
     }
+    result.status = SXBP_OPERATION_OK;
+    return result;
+}
+
+/*
+ * private function, checks that the header of the spiral data in buffer is
+ * valid. The buffer need only hold the header and the first line, it is not
+ * checked whether it holds any more than this. On success, the format of the
+ * data is written to format.
+ */
+static sxbp_serialise_result_t validate_header(
+    sxbp_buffer_t buffer, sxbp_file_format_t* format
+) {
+    sxbp_serialise_result_t result; // build struct for returning success / failure
+    result.diagnostic = SXBP_DESERIALISE_OK;
+    *format = detect_format(buffer);
+    /*
+     * the smallest data section possible is one line's worth, which in the
+     * compact format is one byte for the first direction and one for a length
+     */
+    size_t header_size = (
+        (*format == SXBP_FILE_FORMAT_NATIVE) ? SXBP_NATIVE_FILE_HEADER_SIZE :
+        SXBP_FILE_HEADER_SIZE
+    );
+    size_t min_data_size = (
+        (*format == SXBP_FILE_FORMAT_COMPACT) ? 2 : SXBP_LINE_T_PACK_SIZE
+    );
+    // first, if header is too small for header + 1 line, then return early
+    if(buffer.size < header_size + min_data_size) {
+        result.status = SXBP_OPERATION_FAIL; // flag failure
+        result.diagnostic = SXBP_DESERIALISE_BAD_HEADER_SIZE; // failure reason
+        return result;
+    }
+    return validate_header_fields(buffer, *format);
+}
+
+/*
+ * private function, checks that the header of the spiral data in buffer is
+ * valid and (where this can be checked up-front) that its data section is the
+ * right size for it. On success, the format of the data is written to format.
+ */
+static sxbp_serialise_result_t validate_buffer(
+    sxbp_buffer_t buffer, sxbp_file_format_t* format
+) {
+    sxbp_serialise_result_t result = validate_header(buffer, format);
+    if(result.status != SXBP_OPERATION_OK) {
+        return result;
+    }
+    size_t header_size = (
+        (*format == SXBP_FILE_FORMAT_NATIVE) ? SXBP_NATIVE_FILE_HEADER_SIZE :
+        SXBP_FILE_HEADER_SIZE
+    );
     // get size of spiral object contained in buffer
     uint32_t spiral_size = load_uint32_t(&buffer, 10);
-    // Check that the file data section is large enough for the spiral size
-    if((buffer.size - SXBP_FILE_HEADER_SIZE) != (SXBP_LINE_T_PACK_SIZE * spiral_size)) {
+    uint64_t data_size = buffer.size - header_size;
+    /*
+     * Check that the file data section is large enough for the spiral size.
+     * The exact size of the compact format's data section is only known once
+     * it is decoded, but every line takes at least one byte for its length and
+     * every line after the first a bit for its turn, besides the byte for the
+     * first direction. Checking this before anything is allocated stops a
+     * small file from claiming billions of lines.
+     */
+    if(
+        (*format == SXBP_FILE_FORMAT_COMPACT) ?
+        (
+            (spiral_size == 0) ||
+            (
+                data_size <
+                1 + (uint64_t)spiral_size + ((uint64_t)spiral_size + 6) / 8
+            )
+        ) :
+        (data_size != (uint64_t)SXBP_LINE_T_PACK_SIZE * spiral_size)
+    ) {
         // this check failed
         result.status = SXBP_OPERATION_FAIL; // flag failure
         result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE; // failure reason
         return result;
     }
+    result.status = SXBP_OPERATION_OK;
+    return result;
+}
+
+sxbp_serialise_result_t sxbp_load_spiral(
+    sxbp_buffer_t buffer, sxbp_spiral_t* spiral
+) {
+    // preconditional assertions
+    assert(buffer.bytes != NULL);
+    assert(spiral->lines == NULL);
+    sxbp_file_format_t format;
+    sxbp_serialise_result_t result = validate_buffer(buffer, &format);
+    if(result.status != SXBP_OPERATION_OK) {
+        return result;
+    }
     // good to go
     // populate spiral struct, loading some more values
-    spiral->size = spiral_size;
+    spiral->size = load_uint32_t(&buffer, 10);
     spiral->solved_count = load_uint32_t(&buffer, 14);
     spiral->seconds_spent = load_uint32_t(&buffer, 18);
     spiral->seconds_accuracy = load_uint32_t(&buffer, 22);
@@ -160,85 +565,748 @@ sxbp_serialise_result_t sxbp_load_spiral(
         result.status = SXBP_MALLOC_REFUSED; // flag failure
         return result;
     }
-    // convert each serialised line segment in buffer into a line_t struct
-    for(size_t i = 0; i < spiral_size; i++) {
-        // direction is stored in 2 most significant bits of each 32-bit sequence
-        spiral->lines[i].direction = (
-            buffer.bytes[SXBP_FILE_HEADER_SIZE + (i * SXBP_LINE_T_PACK_SIZE)] >> 6
-        );
-        /*
-         * length is stored as 30 least significant bits, so we have to unpack
-         * it handle first byte on it's own as we only need least 6 bits of it
-         * bit mask and shift 3 bytes to left
-         */
-        spiral->lines[i].length = (
-            buffer.bytes[SXBP_FILE_HEADER_SIZE + (i * SXBP_LINE_T_PACK_SIZE)]
-            & 0x3f // <= binary value is 0b00111111
-        ) << 24;
-        // handle remaining 3 bytes in loop
-        for(uint8_t j = 0; j < 3; j++) {
-            spiral->lines[i].length |= (
-                buffer.bytes[SXBP_FILE_HEADER_SIZE + (i * SXBP_LINE_T_PACK_SIZE) + 1 + j]
-            ) << (8 * (2 - j));
+    if(format == SXBP_FILE_FORMAT_COMPACT) {
+        result.diagnostic = load_lines_compact(buffer, spiral);
+        if(result.diagnostic != SXBP_DESERIALISE_OK) {
+            // don't hand back a half-decoded spiral
+            free(spiral->lines);
+            spiral->lines = NULL;
+            result.status = SXBP_OPERATION_FAIL;
+            return result;
         }
+    } else if(format == SXBP_FILE_FORMAT_NATIVE) {
+        unpack_lines_native(
+            buffer.bytes + SXBP_NATIVE_FILE_HEADER_SIZE, spiral->size,
+            spiral->lines
+        );
+    } else {
+        unpack_lines_fixed(
+            buffer.bytes + SXBP_FILE_HEADER_SIZE, spiral->size, spiral->lines
+        );
     }
     // return ok status
     result.status = SXBP_OPERATION_OK;
     return result;
 }
 
-sxbp_serialise_result_t sxbp_dump_spiral(
-    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+sxbp_serialise_result_t sxbp_view_spiral(
+    sxbp_buffer_t buffer, sxbp_spiral_t* spiral
+) {
+    // preconditional assertions
+    assert(buffer.bytes != NULL);
+    assert(spiral->lines == NULL);
+    sxbp_file_format_t format;
+    sxbp_serialise_result_t result = validate_buffer(buffer, &format);
+    if(result.status != SXBP_OPERATION_OK) {
+        return result;
+    }
+    uint8_t* data = buffer.bytes + SXBP_NATIVE_FILE_HEADER_SIZE;
+    // only native data laid out and aligned as this platform expects will do
+    if(
+        (format != SXBP_FILE_FORMAT_NATIVE) || !native_layout_matches() ||
+        ((uintptr_t)data % sizeof(sxbp_line_t) != 0)
+    ) {
+        result.status = SXBP_NOT_IMPLEMENTED;
+        return result;
+    }
+    spiral->size = load_uint32_t(&buffer, 10);
+    spiral->solved_count = load_uint32_t(&buffer, 14);
+    spiral->seconds_spent = load_uint32_t(&buffer, 18);
+    spiral->seconds_accuracy = load_uint32_t(&buffer, 22);
+    // no copy needed, the data section already is an array of lines
+    spiral->lines = (sxbp_line_t*)(void*)data;
+    result.status = SXBP_OPERATION_OK;
+    return result;
+}
+
+size_t sxbp_dump_spiral_size(
+    sxbp_spiral_t spiral, sxbp_file_format_t format
 ) {
     // preconditional assertions
-    assert(buffer->bytes == NULL);
     assert(spiral.lines != NULL);
-    sxbp_serialise_result_t result; // build struct for returning success / failure
-    // populate buffer struct, base size on header + spiral size
-    buffer->size = (SXBP_FILE_HEADER_SIZE + (SXBP_LINE_T_PACK_SIZE * spiral.size));
+    switch(format) {
+        case SXBP_FILE_FORMAT_COMPACT: {
+            if(spiral.size == 0) {
+                return 0;
+            }
+            // one byte for the first direction, then one bit per turn after it
+            size_t size = SXBP_FILE_HEADER_SIZE + 1 + ((spiral.size - 1 + 7) / 8);
+            for(size_t i = 0; i < spiral.size; i++) {
+                // directions can only be derived if every line turns
+                if(
+                    (i > 0) && (
+                        (spiral.lines[i].direction % 2) ==
+                        (spiral.lines[i - 1].direction % 2)
+                    )
+                ) {
+                    return 0;
+                }
+                size += varint_size(spiral.lines[i].length);
+            }
+            return size;
+        }
+        case SXBP_FILE_FORMAT_NATIVE:
+            return (
+                SXBP_NATIVE_FILE_HEADER_SIZE +
+                (SXBP_LINE_T_PACK_SIZE * spiral.size)
+            );
+        default:
+            return SXBP_FILE_HEADER_SIZE + (SXBP_LINE_T_PACK_SIZE * spiral.size);
+    }
+}
+
+/*
+ * private function, writes the data section of the compact format for spiral
+ * to bytes, which must have room for it and be zeroed
+ */
+static void dump_lines_compact(sxbp_spiral_t spiral, uint8_t* bytes) {
+    size_t turn_bytes = (spiral.size - 1 + 7) / 8;
+    size_t index = 0;
+    bytes[index] = spiral.lines[0].direction;
+    index++;
+    // turn bits are stored most significant bit first, 1 for anti-clockwise
+    for(size_t i = 1; i < spiral.size; i++) {
+        sxbp_direction_t clockwise = sxbp_change_direction(
+            spiral.lines[i - 1].direction, SXBP_CLOCKWISE
+        );
+        if(spiral.lines[i].direction != clockwise) {
+            bytes[index + ((i - 1) / 8)] |= (uint8_t)(
+                1 << (7 - ((i - 1) % 8))
+            );
+        }
+    }
+    index += turn_bytes;
+    // lengths are stored as little-endian base 128 varints
+    for(size_t i = 0; i < spiral.size; i++) {
+        sxbp_length_t length = spiral.lines[i].length;
+        while(length >= 0x80) {
+            bytes[index] = (uint8_t)((length & 0x7f) | 0x80);
+            length >>= 7;
+            index++;
+        }
+        bytes[index] = (uint8_t)length;
+        index++;
+    }
+}
+
+sxbp_serialise_result_t sxbp_dump_spiral_into(
+    sxbp_spiral_t spiral, sxbp_file_format_t format, sxbp_buffer_t buffer,
+    size_t* bytes_written
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(buffer.bytes != NULL);
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_FAIL, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    *bytes_written = 0;
+    size_t size = sxbp_dump_spiral_size(spiral, format);
+    // the spiral can't be stored in this format, or there isn't room for it
+    if(size == 0 || buffer.size < size) {
+        return result;
+    }
+    switch(format) {
+        case SXBP_FILE_FORMAT_COMPACT:
+            // the turn bits are OR'ed in, so must start out as zero
+            memset(buffer.bytes, 0, size);
+            dump_header(spiral, &buffer, "sxbc");
+            dump_lines_compact(spiral, buffer.bytes + SXBP_FILE_HEADER_SIZE);
+            break;
+        case SXBP_FILE_FORMAT_NATIVE:
+            dump_header(spiral, &buffer, "sxbn");
+            // the header padding must be zero
+            memset(
+                buffer.bytes + SXBP_FILE_HEADER_SIZE, 0,
+                SXBP_NATIVE_FILE_HEADER_SIZE - SXBP_FILE_HEADER_SIZE
+            );
+            #ifdef LIBSXBP_OPENMP_SUPPORT
+            #pragma omp parallel for if(spiral.size >= PARALLEL_LINES_THRESHOLD) schedule(static)
+            #endif
+            for(size_t i = 0; i < spiral.size; i++) {
+                dump_uint32_le(
+                    ((uint32_t)spiral.lines[i].length << 2) |
+                    spiral.lines[i].direction,
+                    buffer.bytes + SXBP_NATIVE_FILE_HEADER_SIZE +
+                    (i * SXBP_LINE_T_PACK_SIZE)
+                );
+            }
+            break;
+        default:
+            dump_header(spiral, &buffer, "sxbp");
+            pack_lines_fixed(
+                spiral.lines, spiral.size, buffer.bytes + SXBP_FILE_HEADER_SIZE
+            );
+            break;
+    }
+    *bytes_written = size;
+    result.status = SXBP_OPERATION_OK;
+    return result;
+}
+
+/*
+ * private function, allocates buffer to the exact size needed to serialise
+ * spiral in the given format and serialises it into it
+ */
+static sxbp_serialise_result_t dump_spiral_allocated(
+    sxbp_spiral_t spiral, sxbp_file_format_t format, sxbp_buffer_t* buffer
+) {
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_FAIL, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    size_t size = sxbp_dump_spiral_size(spiral, format);
+    if(size == 0) {
+        return result;
+    }
     // allocate memory for buffer
-    buffer->bytes = calloc(1, buffer->size);
+    buffer->bytes = malloc(size);
     // catch memory allocation failure
     if(buffer->bytes == NULL) {
         result.status = SXBP_MALLOC_REFUSED;
         return result;
     }
-    // write magic number to buffer
-    sprintf((char*)buffer->bytes, "sxbp");
-    // write out version info to buffer
-    dump_uint16_t(LIB_SXBP_VERSION.major, buffer, 4);
-    dump_uint16_t(LIB_SXBP_VERSION.minor, buffer, 6);
-    dump_uint16_t(LIB_SXBP_VERSION.patch, buffer, 8);
-    // write second part of data header
-    dump_uint32_t(spiral.size, buffer, 10);
-    dump_uint32_t(spiral.solved_count, buffer, 14);
-    dump_uint32_t(spiral.seconds_spent, buffer, 18);
-    dump_uint32_t(spiral.seconds_accuracy, buffer, 22);
-    // now write the data section
-    for(size_t i = 0; i < spiral.size; i++) {
-        /*
-         * serialise each line in the spiral to 4 bytes, handle first byte first
-         * map direction to 2 most significant bits
-         */
-        buffer->bytes[
-            SXBP_FILE_HEADER_SIZE + (i * SXBP_LINE_T_PACK_SIZE)
-        ] = (spiral.lines[i].direction << 6);
-        // handle first 6 bits of the length
-        buffer->bytes[
-            SXBP_FILE_HEADER_SIZE + (i * SXBP_LINE_T_PACK_SIZE)
-        ] |= (spiral.lines[i].length >> 24);
-        // handle remaining 3 bytes in a loop
-        for(uint8_t j = 0; j < 3; j++) {
-            buffer->bytes[
-                SXBP_FILE_HEADER_SIZE + (i * SXBP_LINE_T_PACK_SIZE) + 1 + j
-            ] = (uint8_t)(spiral.lines[i].length >> (8 * (2 - j)));
+    buffer->size = size;
+    return sxbp_dump_spiral_into(spiral, format, *buffer, &buffer->size);
+}
+
+sxbp_serialise_result_t sxbp_dump_spiral(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+) {
+    // preconditional assertions
+    assert(buffer->bytes == NULL);
+    assert(spiral.lines != NULL);
+    return dump_spiral_allocated(spiral, SXBP_FILE_FORMAT_STANDARD, buffer);
+}
+
+sxbp_serialise_result_t sxbp_dump_spiral_compact(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+) {
+    // preconditional assertions
+    assert(buffer->bytes == NULL);
+    assert(spiral.lines != NULL);
+    assert(spiral.size > 0);
+    return dump_spiral_allocated(spiral, SXBP_FILE_FORMAT_COMPACT, buffer);
+}
+
+sxbp_serialise_result_t sxbp_dump_spiral_native(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+) {
+    // preconditional assertions
+    assert(buffer->bytes == NULL);
+    assert(spiral.lines != NULL);
+    return dump_spiral_allocated(spiral, SXBP_FILE_FORMAT_NATIVE, buffer);
+}
+
+/*
+ * private function, calls read_callback as many times as needed to fill size
+ * bytes, stopping early only if it returns 0 (i.e. at the end of the stream).
+ * Returns the number of bytes read.
+ */
+static size_t read_fully(
+    size_t(* read_callback)(uint8_t* bytes, size_t size, void* user_data),
+    void* user_data, uint8_t* bytes, size_t size
+) {
+    size_t bytes_read = 0;
+    while(bytes_read < size) {
+        size_t count = read_callback(
+            bytes + bytes_read, size - bytes_read, user_data
+        );
+        if(count == 0) {
+            break;
+        }
+        bytes_read += count;
+    }
+    return bytes_read;
+}
+
+sxbp_serialise_result_t sxbp_load_spiral_stream(
+    size_t(* read_callback)(uint8_t* bytes, size_t size, void* user_data),
+    void* user_data, sxbp_spiral_t* spiral
+) {
+    // preconditional assertions
+    assert(read_callback != NULL);
+    assert(spiral->lines == NULL);
+    sxbp_serialise_result_t result; // build struct for returning success / failure
+    uint8_t chunk[STREAM_CHUNK_SIZE];
+    // read the header and the first line, which is all validate_header() needs
+    sxbp_buffer_t header = {
+        .bytes = chunk,
+        .size = read_fully(
+            read_callback, user_data, chunk,
+            SXBP_FILE_HEADER_SIZE + SXBP_LINE_T_PACK_SIZE
+        ),
+    };
+    /*
+     * only the standard format can be streamed - this is checked first, as the
+     * native format's header is larger than what has been read so far
+     */
+    if(detect_format(header) != SXBP_FILE_FORMAT_STANDARD) {
+        result.status = SXBP_NOT_IMPLEMENTED;
+        result.diagnostic = SXBP_DESERIALISE_OK;
+        return result;
+    }
+    sxbp_file_format_t format;
+    result = validate_header(header, &format);
+    if(result.status != SXBP_OPERATION_OK) {
+        return result;
+    }
+    uint32_t spiral_size = load_uint32_t(&header, 10);
+    if(spiral_size == 0) {
+        result.status = SXBP_OPERATION_FAIL; // flag failure
+        result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE; // failure reason
+        return result;
+    }
+    // populate spiral struct, loading some more values
+    spiral->size = spiral_size;
+    spiral->solved_count = load_uint32_t(&header, 14);
+    spiral->seconds_spent = load_uint32_t(&header, 18);
+    spiral->seconds_accuracy = load_uint32_t(&header, 22);
+    /*
+     * the size in the header can't be trusted until that many lines have
+     * actually been read, so memory is only allocated for the lines as they
+     * arrive, doubling as it fills up, rather than for all of them up front
+     */
+    size_t capacity = STREAM_CHUNK_SIZE / SXBP_LINE_T_PACK_SIZE;
+    if(capacity > spiral->size) {
+        capacity = spiral->size;
+    }
+    spiral->lines = malloc(sizeof(sxbp_line_t) * capacity);
+    // catch allocation error
+    if(spiral->lines == NULL) {
+        result.status = SXBP_MALLOC_REFUSED; // flag failure
+        return result;
+    }
+    // the first line was read along with the header
+    unpack_lines_fixed(chunk + SXBP_FILE_HEADER_SIZE, 1, spiral->lines);
+    // read the remaining lines a chunk at a time
+    for(size_t i = 1; i < spiral->size; ) {
+        size_t lines = spiral->size - i;
+        if(lines > STREAM_CHUNK_SIZE / SXBP_LINE_T_PACK_SIZE) {
+            lines = STREAM_CHUNK_SIZE / SXBP_LINE_T_PACK_SIZE;
+        }
+        size_t chunk_size = lines * SXBP_LINE_T_PACK_SIZE;
+        if(read_fully(read_callback, user_data, chunk, chunk_size) != chunk_size) {
+            // the stream ended before all the lines were read
+            free(spiral->lines);
+            spiral->lines = NULL;
+            result.status = SXBP_OPERATION_FAIL; // flag failure
+            result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE; // failure reason
+            return result;
+        }
+        if(i + lines > capacity) {
+            // double the memory allocated, but never beyond the spiral's size
+            capacity = (capacity * 2 < i + lines) ? i + lines : capacity * 2;
+            if(capacity > spiral->size) {
+                capacity = spiral->size;
+            }
+            sxbp_line_t* grown = realloc(
+                spiral->lines, sizeof(sxbp_line_t) * capacity
+            );
+            // catch allocation error
+            if(grown == NULL) {
+                free(spiral->lines);
+                spiral->lines = NULL;
+                result.status = SXBP_MALLOC_REFUSED; // flag failure
+                return result;
+            }
+            spiral->lines = grown;
+        }
+        unpack_lines_fixed(chunk, lines, spiral->lines + i);
+        i += lines;
+    }
+    // like sxbp_load_spiral(), reject any data following the last line
+    if(read_fully(read_callback, user_data, chunk, 1) != 0) {
+        free(spiral->lines);
+        spiral->lines = NULL;
+        result.status = SXBP_OPERATION_FAIL; // flag failure
+        result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE; // failure reason
+        return result;
+    }
+    // return ok status
+    result.status = SXBP_OPERATION_OK;
+    return result;
+}
+
+sxbp_serialise_result_t sxbp_dump_spiral_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+) {
+    // preconditional assertions
+    assert(spiral.lines != NULL);
+    assert(write_callback != NULL);
+    sxbp_serialise_result_t result; // build struct for returning success / failure
+    result.status = SXBP_OPERATION_FAIL;
+    uint8_t chunk[STREAM_CHUNK_SIZE];
+    sxbp_buffer_t header = { .bytes = chunk, .size = SXBP_FILE_HEADER_SIZE, };
+    dump_header(spiral, &header, "sxbp");
+    if(write_callback(chunk, header.size, user_data) != header.size) {
+        return result;
+    }
+    // write the lines a chunk at a time
+    for(size_t i = 0; i < spiral.size; ) {
+        size_t lines = spiral.size - i;
+        if(lines > STREAM_CHUNK_SIZE / SXBP_LINE_T_PACK_SIZE) {
+            lines = STREAM_CHUNK_SIZE / SXBP_LINE_T_PACK_SIZE;
+        }
+        size_t chunk_size = lines * SXBP_LINE_T_PACK_SIZE;
+        pack_lines_fixed(spiral.lines + i, lines, chunk);
+        if(write_callback(chunk, chunk_size, user_data) != chunk_size) {
+            return result;
         }
+        i += lines;
     }
     // return ok status
     result.status = SXBP_OPERATION_OK;
     return result;
 }
 
+sxbp_serialise_result_t sxbp_peek_spiral(
+    sxbp_buffer_t buffer, sxbp_spiral_info_t* info
+) {
+    // preconditional assertions
+    assert(buffer.bytes != NULL);
+    sxbp_serialise_result_t result; // build struct for returning success / failure
+    // only the fields common to the headers of all formats are needed
+    if(buffer.size < SXBP_FILE_HEADER_SIZE) {
+        result.status = SXBP_OPERATION_FAIL; // flag failure
+        result.diagnostic = SXBP_DESERIALISE_BAD_HEADER_SIZE; // failure reason
+        return result;
+    }
+    info->format = detect_format(buffer);
+    result = validate_header_fields(buffer, info->format);
+    if(result.status != SXBP_OPERATION_OK) {
+        return result;
+    }
+    info->version.major = load_uint16_t(&buffer, 4);
+    info->version.minor = load_uint16_t(&buffer, 6);
+    info->version.patch = load_uint16_t(&buffer, 8);
+    info->version.string = NULL;
+    info->size = load_uint32_t(&buffer, 10);
+    info->solved_count = load_uint32_t(&buffer, 14);
+    info->seconds_spent = load_uint32_t(&buffer, 18);
+    info->seconds_accuracy = load_uint32_t(&buffer, 22);
+    return result;
+}
+
+/*
+ * private function, calls read_at_callback as many times as needed to fill
+ * size bytes from offset onwards, stopping early only if it returns 0 (i.e.
+ * at the end of the data). Returns the number of bytes read.
+ */
+static size_t read_at_fully(
+    size_t(* read_at_callback)(
+        uint8_t* bytes, size_t size, size_t offset, void* user_data
+    ),
+    void* user_data, uint8_t* bytes, size_t size, size_t offset
+) {
+    size_t bytes_read = 0;
+    while(bytes_read < size) {
+        size_t count = read_at_callback(
+            bytes + bytes_read, size - bytes_read, offset + bytes_read,
+            user_data
+        );
+        if(count == 0) {
+            break;
+        }
+        bytes_read += count;
+    }
+    return bytes_read;
+}
+
+/*
+ * private function, reads through the data section of a spiral in the compact
+ * format, recording in index the direction and the offset of the length of
+ * the first line of each block. Returns SXBP_DESERIALISE_OK if the data
+ * section was valid, SXBP_DESERIALISE_BAD_DATA_SIZE if not.
+ */
+static sxbp_deserialise_diagnostic_t index_lines_compact(
+    size_t(* read_at_callback)(
+        uint8_t* bytes, size_t size, size_t offset, void* user_data
+    ),
+    void* user_data, sxbp_line_index_t* index
+) {
+    uint32_t size = index->info.size;
+    uint8_t chunk[STREAM_CHUNK_SIZE];
+    size_t offset = SXBP_FILE_HEADER_SIZE;
+    // the first byte holds the direction of the first line
+    if(read_at_fully(read_at_callback, user_data, chunk, 1, offset) != 1) {
+        return SXBP_DESERIALISE_BAD_DATA_SIZE;
+    }
+    sxbp_direction_t current = chunk[0] & 0x03;
+    index->directions[0] = current;
+    offset++;
+    // follow the turn bits a chunk at a time, noting the start of each block
+    size_t turn_bytes = ((size_t)size - 1 + 7) / 8;
+    uint32_t line = 1;
+    for(size_t i = 0; i < turn_bytes; ) {
+        size_t count = turn_bytes - i;
+        if(count > STREAM_CHUNK_SIZE) {
+            count = STREAM_CHUNK_SIZE;
+        }
+        if(
+            read_at_fully(read_at_callback, user_data, chunk, count, offset) !=
+            count
+        ) {
+            return SXBP_DESERIALISE_BAD_DATA_SIZE;
+        }
+        for(size_t j = 0; j < count * 8 && line < size; j++) {
+            uint8_t bit = (chunk[j / 8] >> (7 - (j % 8))) & 1;
+            current = sxbp_change_direction(
+                current, (bit == 0) ? SXBP_CLOCKWISE : SXBP_ANTI_CLOCKWISE
+            );
+            if(line % LINE_INDEX_BLOCK_SIZE == 0) {
+                index->directions[line / LINE_INDEX_BLOCK_SIZE] = current;
+            }
+            line++;
+        }
+        i += count;
+        offset += count;
+    }
+    // then read through the varint lengths, noting the start of each block
+    line = 0;
+    uint32_t length = 0;
+    uint8_t shift = 0;
+    while(line < size) {
+        size_t count = read_at_callback(
+            chunk, STREAM_CHUNK_SIZE, offset, user_data
+        );
+        if(count == 0) {
+            return SXBP_DESERIALISE_BAD_DATA_SIZE;
+        }
+        size_t j = 0;
+        for(; j < count && line < size; j++) {
+            if(shift == 0 && line % LINE_INDEX_BLOCK_SIZE == 0) {
+                index->offsets[line / LINE_INDEX_BLOCK_SIZE] = offset + j;
+            }
+            // the varint was too long for a line length
+            if(shift > 28) {
+                return SXBP_DESERIALISE_BAD_DATA_SIZE;
+            }
+            length |= (uint32_t)(chunk[j] & 0x7f) << shift;
+            shift += 7;
+            if(!(chunk[j] & 0x80)) {
+                // line lengths are only 30 bits wide
+                if(length > 0x3fffffff) {
+                    return SXBP_DESERIALISE_BAD_DATA_SIZE;
+                }
+                line++;
+                length = 0;
+                shift = 0;
+            }
+        }
+        offset += j;
+    }
+    index->end = offset;
+    return SXBP_DESERIALISE_OK;
+}
+
+sxbp_serialise_result_t sxbp_index_spiral(
+    size_t(* read_at_callback)(
+        uint8_t* bytes, size_t size, size_t offset, void* user_data
+    ),
+    void* user_data, sxbp_line_index_t* index
+) {
+    // preconditional assertions
+    assert(read_at_callback != NULL);
+    sxbp_serialise_result_t result; // build struct for returning success / failure
+    index->offsets = NULL;
+    index->directions = NULL;
+    index->end = 0;
+    uint8_t header_bytes[STREAM_CHUNK_SIZE];
+    sxbp_buffer_t header = {
+        .bytes = header_bytes,
+        .size = read_at_fully(
+            read_at_callback, user_data, header_bytes, SXBP_FILE_HEADER_SIZE, 0
+        ),
+    };
+    result = sxbp_peek_spiral(header, &index->info);
+    if(result.status != SXBP_OPERATION_OK) {
+        return result;
+    }
+    // spirals with no lines are not accepted by sxbp_load_spiral() either
+    if(index->info.size == 0) {
+        result.status = SXBP_OPERATION_FAIL; // flag failure
+        result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE; // failure reason
+        return result;
+    }
+    // only the compact format needs anything more than the header
+    if(index->info.format != SXBP_FILE_FORMAT_COMPACT) {
+        return result;
+    }
+    size_t blocks = (
+        ((size_t)index->info.size + LINE_INDEX_BLOCK_SIZE - 1) /
+        LINE_INDEX_BLOCK_SIZE
+    );
+    index->offsets = calloc(blocks, sizeof(size_t));
+    index->directions = calloc(blocks, sizeof(uint8_t));
+    // catch allocation error
+    if(index->offsets == NULL || index->directions == NULL) {
+        sxbp_free_line_index(index);
+        result.status = SXBP_MALLOC_REFUSED; // flag failure
+        return result;
+    }
+    result.diagnostic = index_lines_compact(read_at_callback, user_data, index);
+    if(result.diagnostic != SXBP_DESERIALISE_OK) {
+        sxbp_free_line_index(index);
+        result.status = SXBP_OPERATION_FAIL; // flag failure
+    }
+    return result;
+}
+
+/*
+ * private function, loads lines [start, end) of a spiral in the compact format
+ * into lines, decoding from the start of the block containing line start.
+ * Returns SXBP_DESERIALISE_OK if the lines were read successfully,
+ * SXBP_DESERIALISE_BAD_DATA_SIZE if not.
+ */
+static sxbp_deserialise_diagnostic_t load_lines_range_compact(
+    size_t(* read_at_callback)(
+        uint8_t* bytes, size_t size, size_t offset, void* user_data
+    ),
+    void* user_data, const sxbp_line_index_t* index,
+    uint32_t start, uint32_t end, sxbp_line_t* lines
+) {
+    uint8_t chunk[STREAM_CHUNK_SIZE];
+    size_t block = start / LINE_INDEX_BLOCK_SIZE;
+    uint32_t first = (uint32_t)block * LINE_INDEX_BLOCK_SIZE;
+    // follow the turn bits on from the direction of the first line of block
+    sxbp_direction_t current = index->directions[block];
+    if(first == start) {
+        lines[0].direction = current;
+    }
+    // the turn bit of each line after the first is bit (line - 1)
+    size_t last_byte = (end >= 2) ? (end - 2) / 8 : 0;
+    for(uint32_t line = first + 1; line < end; ) {
+        size_t byte_index = (line - 1) / 8;
+        size_t count = last_byte - byte_index + 1;
+        if(count > STREAM_CHUNK_SIZE) {
+            count = STREAM_CHUNK_SIZE;
+        }
+        if(
+            read_at_fully(
+                read_at_callback, user_data, chunk, count,
+                SXBP_FILE_HEADER_SIZE + 1 + byte_index
+            ) != count
+        ) {
+            return SXBP_DESERIALISE_BAD_DATA_SIZE;
+        }
+        for(; line < end && (line - 1) / 8 < byte_index + count; line++) {
+            uint8_t bit = (
+                chunk[((line - 1) / 8) - byte_index] >> (7 - ((line - 1) % 8))
+            ) & 1;
+            current = sxbp_change_direction(
+                current, (bit == 0) ? SXBP_CLOCKWISE : SXBP_ANTI_CLOCKWISE
+            );
+            if(line >= start) {
+                lines[line - start].direction = current;
+            }
+        }
+    }
+    // decode the lengths on from the first line of block
+    size_t offset = index->offsets[block];
+    uint32_t line = first;
+    uint32_t length = 0;
+    uint8_t shift = 0;
+    while(line < end) {
+        size_t count = index->end - offset;
+        if(count > STREAM_CHUNK_SIZE) {
+            count = STREAM_CHUNK_SIZE;
+        }
+        if(
+            (count == 0) ||
+            (
+                read_at_fully(
+                    read_at_callback, user_data, chunk, count, offset
+                ) != count
+            )
+        ) {
+            return SXBP_DESERIALISE_BAD_DATA_SIZE;
+        }
+        for(size_t j = 0; j < count && line < end; j++) {
+            if(shift > 28) {
+                return SXBP_DESERIALISE_BAD_DATA_SIZE;
+            }
+            length |= (uint32_t)(chunk[j] & 0x7f) << shift;
+            shift += 7;
+            if(!(chunk[j] & 0x80)) {
+                if(line >= start) {
+                    lines[line - start].length = length;
+                }
+                line++;
+                length = 0;
+                shift = 0;
+            }
+        }
+        offset += count;
+    }
+    return SXBP_DESERIALISE_OK;
+}
+
+sxbp_serialise_result_t sxbp_load_spiral_lines(
+    size_t(* read_at_callback)(
+        uint8_t* bytes, size_t size, size_t offset, void* user_data
+    ),
+    void* user_data, const sxbp_line_index_t* index,
+    uint32_t start, uint32_t end, sxbp_line_t* lines
+) {
+    // preconditional assertions
+    assert(read_at_callback != NULL);
+    assert(start <= end);
+    assert(end <= index->info.size);
+    assert(lines != NULL);
+    sxbp_serialise_result_t result = {
+        .status = SXBP_OPERATION_OK, .diagnostic = SXBP_DESERIALISE_OK,
+    };
+    if(start == end) {
+        return result;
+    }
+    if(index->info.format == SXBP_FILE_FORMAT_COMPACT) {
+        result.diagnostic = load_lines_range_compact(
+            read_at_callback, user_data, index, start, end, lines
+        );
+    } else {
+        // fixed-size lines can be read directly, a chunk at a time
+        size_t header_size = (
+            (index->info.format == SXBP_FILE_FORMAT_NATIVE) ?
+            SXBP_NATIVE_FILE_HEADER_SIZE : SXBP_FILE_HEADER_SIZE
+        );
+        uint8_t chunk[STREAM_CHUNK_SIZE];
+        for(uint32_t i = start; i < end; ) {
+            size_t count = end - i;
+            if(count > STREAM_CHUNK_SIZE / SXBP_LINE_T_PACK_SIZE) {
+                count = STREAM_CHUNK_SIZE / SXBP_LINE_T_PACK_SIZE;
+            }
+            size_t chunk_size = count * SXBP_LINE_T_PACK_SIZE;
+            if(
+                read_at_fully(
+                    read_at_callback, user_data, chunk, chunk_size,
+                    header_size + ((size_t)i * SXBP_LINE_T_PACK_SIZE)
+                ) != chunk_size
+            ) {
+                result.diagnostic = SXBP_DESERIALISE_BAD_DATA_SIZE;
+                break;
+            }
+            if(index->info.format == SXBP_FILE_FORMAT_NATIVE) {
+                unpack_lines_native(chunk, count, lines + (i - start));
+            } else {
+                unpack_lines_fixed(chunk, count, lines + (i - start));
+            }
+            i += (uint32_t)count;
+        }
+    }
+    if(result.diagnostic != SXBP_DESERIALISE_OK) {
+        result.status = SXBP_OPERATION_FAIL; // flag failure
+    }
+    return result;
+}
+
+void sxbp_free_line_index(sxbp_line_index_t* index) {
+    free(index->offsets);
+    free(index->directions);
+    index->offsets = NULL;
+    index->directions = NULL;
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
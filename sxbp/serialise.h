@@ -57,15 +57,83 @@ typedef struct sxbp_serialise_result_t {
     sxbp_deserialise_diagnostic_t diagnostic;
 } sxbp_serialise_result_t;
 
+/**
+ * @brief The file formats which a spiral may be serialised in.
+ */
+typedef enum sxbp_file_format_t {
+    /** @brief 'sxbp', as written by sxbp_dump_spiral() */
+    SXBP_FILE_FORMAT_STANDARD,
+    /** @brief 'sxbc', as written by sxbp_dump_spiral_compact() */
+    SXBP_FILE_FORMAT_COMPACT,
+    /** @brief 'sxbn', as written by sxbp_dump_spiral_native() */
+    SXBP_FILE_FORMAT_NATIVE,
+} sxbp_file_format_t;
+
+/**
+ * @brief The metadata held in the header of a serialised spiral.
+ */
+typedef struct sxbp_spiral_info_t {
+    /** @brief the format the spiral is serialised in */
+    sxbp_file_format_t format;
+    /**
+     * @brief the version of libsxbp which serialised the spiral
+     * @note The `string` field of this is always NULL.
+     */
+    sxbp_version_t version;
+    /** @brief the number of lines in the spiral */
+    uint32_t size;
+    /** @brief the number of lines of the spiral which have been solved */
+    uint32_t solved_count;
+    /** @brief the number of seconds spent solving the spiral */
+    uint32_t seconds_spent;
+    /** @brief the accuracy of seconds_spent */
+    uint32_t seconds_accuracy;
+} sxbp_spiral_info_t;
+
+/**
+ * @brief An index of a serialised spiral, used to load ranges of its lines
+ * without reading the rest of them.
+ * @details Indexes are built with sxbp_index_spiral() and freed with
+ * sxbp_free_line_index(). For the standard and native formats, whose lines
+ * are of a fixed size, the index only holds the header of the spiral. For the
+ * compact format, it also holds where each block of lines starts.
+ */
+typedef struct sxbp_line_index_t {
+    /** @brief the metadata from the header of the spiral */
+    sxbp_spiral_info_t info;
+    /**
+     * @brief the offset of the length of the first line of each block
+     * (compact format only, NULL otherwise)
+     * @private
+     */
+    size_t* offsets;
+    /**
+     * @brief the direction of the first line of each block (compact format
+     * only, NULL otherwise)
+     * @private
+     */
+    uint8_t* directions;
+    /**
+     * @brief the offset of the end of the spiral's data (compact format only)
+     * @private
+     */
+    size_t end;
+} sxbp_line_index_t;
+
 /** @brief The size of the file header in bytes */
 extern const size_t SXBP_FILE_HEADER_SIZE;
 /** @brief The size in bytes of one line when stored in the file */
 extern const size_t SXBP_LINE_T_PACK_SIZE;
+/** @brief The size of the file header of the native file format in bytes */
+extern const size_t SXBP_NATIVE_FILE_HEADER_SIZE;
 
 /**
  * @brief De-serialises a spiral from a buffer.
  * @details Reads in a binary representation of a spiral and populates a given
  * spiral with the data which represents this spiral (if input data is valid).
+ * The standard format written by sxbp_dump_spiral(), the compact format
+ * written by sxbp_dump_spiral_compact() and the native format written by
+ * sxbp_dump_spiral_native() are all accepted.
  *
  * @param buffer The data buffer to load the spiral from.
  * @param[out] spiral The spiral to write the spiral data to.
@@ -107,6 +175,307 @@ sxbp_serialise_result_t sxbp_dump_spiral(
     sxbp_spiral_t spiral, sxbp_buffer_t* buffer
 );
 
+/**
+ * @brief Serialises a spiral to a buffer, in the compact file format.
+ * @details The compact format shares the header of the standard format (but
+ * with the magic number 'sxbc'), and is followed by a data section which
+ * stores the direction of the first line, then one bit per subsequent line
+ * giving the direction it turns in (these are the bits of the data the spiral
+ * was initialised from) and lastly the length of each line as a
+ * variable-length integer. As most lines of a spiral are short, files written
+ * in this format are typically several times smaller than the standard format.
+ * They are loaded by sxbp_load_spiral() in the same way as the standard format.
+ *
+ * @param spiral The spiral which should be serialised to buffer.
+ * @param[out] buffer The data buffer to write out the spiral data to.
+ * @return A result with status SXBP_OPERATION_OK on success.
+ * @return A result with status SXBP_OPERATION_FAIL if the spiral cannot be
+ * stored in the compact format, because not every line turns 90 degrees from
+ * the one before it (which is always true of spirals built with
+ * sxbp_init_spiral()).
+ * @return A result with status SXBP_MALLOC_REFUSED on memory allocation
+ * failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That spiral.size is not 0
+ * - That buffer->bytes is NULL
+ */
+sxbp_serialise_result_t sxbp_dump_spiral_compact(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Serialises a spiral to a buffer, in the native file format.
+ * @details The native format shares the fields of the standard header (but
+ * with the magic number 'sxbn'), padded to SXBP_NATIVE_FILE_HEADER_SIZE bytes.
+ * It is followed by one little-endian 32-bit word per line, holding the
+ * direction in the 2 least significant bits and the length in the 30 bits
+ * above them. On common platforms this is the in-memory layout of
+ * sxbp_line_t, so the lines of a file in this format can be used in-place
+ * with sxbp_view_spiral(), without any decoding or copying.
+ *
+ * @param spiral The spiral which should be serialised to buffer.
+ * @param[out] buffer The data buffer to write out the spiral data to.
+ * @return A result with status SXBP_OPERATION_OK on success.
+ * @return A result with status SXBP_MALLOC_REFUSED on memory allocation
+ * failure.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That buffer->bytes is NULL
+ */
+sxbp_serialise_result_t sxbp_dump_spiral_native(
+    sxbp_spiral_t spiral, sxbp_buffer_t* buffer
+);
+
+/**
+ * @brief Calculates the exact number of bytes needed to serialise a spiral in
+ * a given file format.
+ *
+ * @param spiral The spiral which is to be serialised.
+ * @param format The file format it is to be serialised in.
+ * @return The size of the spiral once serialised, in bytes.
+ * @return 0 if the spiral cannot be serialised in the compact format (see
+ * sxbp_dump_spiral_compact()).
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ */
+size_t sxbp_dump_spiral_size(sxbp_spiral_t spiral, sxbp_file_format_t format);
+
+/**
+ * @brief Serialises a spiral in a given file format to memory provided by the
+ * caller.
+ * @details The bytes written are identical to those written by
+ * sxbp_dump_spiral(), sxbp_dump_spiral_compact() or sxbp_dump_spiral_native()
+ * for the same format, but no memory is allocated, so the same memory may be
+ * re-used for many spirals. sxbp_dump_spiral_size() gives how much is needed.
+ *
+ * @param spiral The spiral which should be serialised.
+ * @param format The file format to serialise the spiral in.
+ * @param buffer The memory to write the serialised spiral to, where
+ * buffer.size is the number of bytes available.
+ * @param[out] bytes_written The number of bytes written to buffer, 0 on
+ * failure.
+ * @return A result with status SXBP_OPERATION_OK on success.
+ * @return A result with status SXBP_OPERATION_FAIL if buffer is too small, or
+ * the spiral cannot be serialised in the compact format.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That buffer.bytes is not NULL
+ */
+sxbp_serialise_result_t sxbp_dump_spiral_into(
+    sxbp_spiral_t spiral, sxbp_file_format_t format, sxbp_buffer_t buffer,
+    size_t* bytes_written
+);
+
+/**
+ * @brief Provides a spiral whose lines are read directly from a buffer
+ * holding a spiral in the native file format, without copying them.
+ * @details This takes constant time regardless of the size of the spiral.
+ * The buffer may be memory which the caller has mapped from a file (e.g. with
+ * `mmap()`), in which case the lines are only paged in as they are used and
+ * the page cache is shared between all processes viewing the same file.
+ *
+ * @param buffer The data buffer holding the spiral. Its bytes must remain
+ * valid for as long as the spiral is used.
+ * @param[out] spiral The spiral to write the spiral data to. Its lines point
+ * into the buffer, so they must not be freed, and must not be modified if the
+ * buffer is read-only. The spiral may be passed to any function which does
+ * not modify the lines of a spiral, such as those which render spirals.
+ * @return A result with status SXBP_OPERATION_OK on success.
+ * @return A result with status SXBP_NOT_IMPLEMENTED if the buffer holds a
+ * spiral in any format other than the native one, if the memory layout of
+ * lines on this platform differs from the native format's, or if the buffer's
+ * data section is not suitably aligned. sxbp_load_spiral() may be used to
+ * load the spiral (by copying it) in these cases.
+ * @return Any failure result which sxbp_load_spiral() may return, if the
+ * buffer does not hold a valid spiral.
+ *
+ * @note Asserts:
+ * - That buffer.bytes is not NULL
+ * - That spiral->lines is NULL
+ */
+sxbp_serialise_result_t sxbp_view_spiral(
+    sxbp_buffer_t buffer, sxbp_spiral_t* spiral
+);
+
+/**
+ * @brief De-serialises a spiral from a stream of bytes, as produced by
+ * sxbp_dump_spiral() or sxbp_dump_spiral_stream().
+ * @details The stream is read through a callback, in chunks of bounded size,
+ * so the serialised form of the spiral never has to be held in memory all at
+ * once. Validation is the same as that done by sxbp_load_spiral(), so the
+ * stream must end straight after the last line. Memory for the lines is
+ * allocated as they are read, so a stream claiming to hold more lines than it
+ * does fails with SXBP_DESERIALISE_BAD_DATA_SIZE without first allocating
+ * memory for all of them.
+ *
+ * @param read_callback A function pointer with the following signature:
+ * @code
+ * size_t callback_name(uint8_t* bytes, size_t size, void* user_data)
+ * @endcode
+ * It should read up to size bytes into bytes and return the number of bytes
+ * read, which should only be 0 at the end of the stream or on error. The
+ * function sxbp_file_read_callback() is provided for reading from files.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle or socket.
+ * @param[out] spiral The spiral to write the spiral data to.
+ * @return For information on return values, see the documentation of the return
+ * types.
+ * @return A result with status SXBP_NOT_IMPLEMENTED if the stream holds a
+ * spiral in the compact or native formats, which cannot be streamed.
+ *
+ * @note Asserts:
+ * - That read_callback is not NULL
+ * - That spiral->lines is NULL
+ *
+ * @see sxbp_status_t for generic error return codes and
+ * sxbp_deserialise_diagnostic_t for file-specific error return codes.
+ */
+sxbp_serialise_result_t sxbp_load_spiral_stream(
+    size_t(* read_callback)(uint8_t* bytes, size_t size, void* user_data),
+    void* user_data, sxbp_spiral_t* spiral
+);
+
+/**
+ * @brief Serialises a spiral to a stream of bytes.
+ * @details The bytes written are identical to those which sxbp_dump_spiral()
+ * produces, but are passed to a callback in chunks of bounded size, so the
+ * serialised form of the spiral never has to be held in memory all at once.
+ *
+ * @param spiral The spiral which should be serialised.
+ * @param write_callback A function pointer with the following signature:
+ * @code
+ * size_t callback_name(const uint8_t* bytes, size_t size, void* user_data)
+ * @endcode
+ * It should write all size bytes from bytes and return the number of bytes
+ * written, anything less than size is treated as an error. The function
+ * sxbp_file_write_callback() is provided for writing to files.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle or socket.
+ * @return A result with status SXBP_OPERATION_OK on success.
+ * @return A result with status SXBP_OPERATION_FAIL if the callback failed to
+ * write all of the bytes given to it.
+ *
+ * @note Asserts:
+ * - That spiral.lines is not NULL
+ * - That write_callback is not NULL
+ */
+sxbp_serialise_result_t sxbp_dump_spiral_stream(
+    sxbp_spiral_t spiral,
+    size_t(* write_callback)(const uint8_t* bytes, size_t size, void* user_data),
+    void* user_data
+);
+
+/**
+ * @brief Reads the metadata of a spiral from the header of its serialised
+ * form, without loading any of its lines.
+ * @details Only the first SXBP_FILE_HEADER_SIZE bytes of the spiral are
+ * needed, of any of the formats accepted by sxbp_load_spiral(). The magic
+ * number and version are validated in the same way as by sxbp_load_spiral(),
+ * but the data section is not checked.
+ *
+ * @param buffer A buffer holding at least the header of the spiral.
+ * @param[out] info The metadata of the spiral.
+ * @return For information on return values, see the documentation of the return
+ * types.
+ *
+ * @note Asserts:
+ * - That buffer.bytes is not NULL
+ *
+ * @see sxbp_status_t for generic error return codes and
+ * sxbp_deserialise_diagnostic_t for file-specific error return codes.
+ */
+sxbp_serialise_result_t sxbp_peek_spiral(
+    sxbp_buffer_t buffer, sxbp_spiral_info_t* info
+);
+
+/**
+ * @brief Builds an index of a serialised spiral, for loading ranges of its
+ * lines with sxbp_load_spiral_lines().
+ * @details The spiral is read through a callback which can read from any
+ * offset, such as a file or memory mapping. For the standard and native
+ * formats, only the header is read. For the compact format, the data section
+ * is read once from start to end (in chunks of bounded size) to find where
+ * each block of lines starts.
+ *
+ * @param read_at_callback A function pointer with the following signature:
+ * @code
+ * size_t callback_name(
+ *     uint8_t* bytes, size_t size, size_t offset, void* user_data
+ * )
+ * @endcode
+ * It should read up to size bytes starting from the given offset into bytes
+ * and return the number of bytes read, which should only be less than size
+ * at the end of the data or on error. The function
+ * sxbp_file_read_at_callback() is provided for reading from files.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle.
+ * @param[out] index The index to build.
+ * @return For information on return values, see the documentation of the return
+ * types.
+ *
+ * @note Asserts:
+ * - That read_at_callback is not NULL
+ *
+ * @see sxbp_status_t for generic error return codes and
+ * sxbp_deserialise_diagnostic_t for file-specific error return codes.
+ */
+sxbp_serialise_result_t sxbp_index_spiral(
+    size_t(* read_at_callback)(
+        uint8_t* bytes, size_t size, size_t offset, void* user_data
+    ),
+    void* user_data, sxbp_line_index_t* index
+);
+
+/**
+ * @brief Loads a range of lines of a serialised spiral, without reading the
+ * rest of them.
+ * @details For the standard and native formats, exactly the bytes of the
+ * requested lines are read. For the compact format, reading starts from the
+ * start of the block containing the first requested line.
+ *
+ * @param read_at_callback A function pointer as accepted by
+ * sxbp_index_spiral(), which reads from the same data as the index was built
+ * from.
+ * @param user_data An optional void pointer which is passed on to the
+ * callback, such as a file handle.
+ * @param index The index of the spiral, built with sxbp_index_spiral().
+ * @param start The index of the first line to load.
+ * @param end The index of the line after the last line to load.
+ * @param[out] lines An array of at least end - start lines to load the lines
+ * into.
+ * @return A result with status SXBP_OPERATION_OK on success.
+ * @return A result with status SXBP_OPERATION_FAIL and diagnostic
+ * SXBP_DESERIALISE_BAD_DATA_SIZE if the data ended before all of the lines
+ * could be read, or was invalid.
+ * @return A result with status SXBP_MALLOC_REFUSED on memory allocation
+ * failure.
+ *
+ * @note Asserts:
+ * - That read_at_callback is not NULL
+ * - That start is less than or equal to end
+ * - That end is less than or equal to index->info.size
+ * - That lines is not NULL
+ */
+sxbp_serialise_result_t sxbp_load_spiral_lines(
+    size_t(* read_at_callback)(
+        uint8_t* bytes, size_t size, size_t offset, void* user_data
+    ),
+    void* user_data, const sxbp_line_index_t* index,
+    uint32_t start, uint32_t end, sxbp_line_t* lines
+);
+
+/**
+ * @brief Frees the memory held by an index built with sxbp_index_spiral().
+ *
+ * @param[in,out] index The index to free.
+ */
+void sxbp_free_line_index(sxbp_line_index_t* index);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
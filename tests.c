@@ -15,20 +15,80 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
+/*
+ * on POSIX systems, concurrent writers are also tested in separate processes,
+ * which needs the feature test macro for fork() when building as strict C99
+ */
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__APPLE__) && defined(__MACH__))
+#define TESTS_POSIX_PROCESSES
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#ifdef TESTS_POSIX_PROCESSES
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// zlib is only available to check PNG output with if PNG support is enabled
+#ifdef LIBSXBP_PNG_SUPPORT
+#include <zlib.h>
+#endif
 
 #include "sxbp/saxbospiral.h"
 #include "sxbp/initialise.h"
 #include "sxbp/plot.h"
 #include "sxbp/solve.h"
 #include "sxbp/serialise.h"
+#include "sxbp/archive.h"
+#include "sxbp/checkpoint.h"
+#include "sxbp/file.h"
+#include "sxbp/journal.h"
+#include "sxbp/render.h"
+#include "sxbp/render_backends/backend_pbm.h"
+#include "sxbp/render_backends/backend_pgm.h"
+#include "sxbp/render_backends/backend_png.h"
+#include "sxbp/render_backends/backend_svg.h"
+#include "sxbp/render_backends/backend_tiff.h"
 
 
 static const size_t EXPECTED_FILE_HEADER_SIZE = 26;
 
+/*
+ * builds an unsolved spiral from data_size bytes (at most 300) of a fixed
+ * pattern of data, with all of its lines' lengths left at 0
+ */
+static sxbp_spiral_t make_test_spiral(size_t data_size) {
+    uint8_t data[300];
+    for(size_t i = 0; i < data_size; i++) {
+        data[i] = (uint8_t)(i * 37);
+    }
+    sxbp_buffer_t data_buffer = { .bytes = data, .size = data_size, };
+    sxbp_spiral_t spiral = sxbp_blank_spiral();
+    sxbp_init_spiral(data_buffer, &spiral);
+    return spiral;
+}
+
+/*
+ * builds an unsolved spiral as make_test_spiral() does, but with lines of
+ * varied lengths, so that it overlaps itself
+ */
+static sxbp_spiral_t make_overlapping_spiral(size_t data_size) {
+    sxbp_spiral_t spiral = make_test_spiral(data_size);
+    for(uint32_t i = 0; i < spiral.size; i++) {
+        spiral.lines[i].length = 1 + (i % 7);
+    }
+    return spiral;
+}
+
 
 static bool test_sxbp_change_direction(void) {
     if(sxbp_change_direction(SXBP_UP, SXBP_CLOCKWISE) != SXBP_RIGHT) {
@@ -684,68 +744,2347 @@ static bool test_sxbp_dump_spiral(void) {
     return result;
 }
 
-// this function takes a bool containing the test suite status,
-// a function pointer to a test case function, and a string containing the
-// test case's name. it will run the test case function and return the success
-// or failure status, which should be stored in the test suite status bool.
-static bool run_test_case(
-    bool test_suite_state, bool(* test_case_func)(), char* test_case_name
+static bool test_sxbp_dump_spiral_compact(void) {
+    // success / failure variable
+    bool result = true;
+    // build input struct
+    sxbp_spiral_t input = {
+        .size = 16,
+        .solved_count = 5,
+        .seconds_spent = 3125,
+        .seconds_accuracy = 1,
+    };
+    input.lines = calloc(sizeof(sxbp_line_t), 16);
+    sxbp_direction_t directions[16] = {
+        SXBP_UP, SXBP_LEFT, SXBP_DOWN, SXBP_LEFT, SXBP_DOWN, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT, SXBP_UP, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT,
+    };
+    // include one long line to exercise multi-byte lengths
+    sxbp_length_t lengths[16] = {
+        1, 1, 1, 1, 1, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 300,
+    };
+    for(uint8_t i = 0; i < 16; i++) {
+        input.lines[i].direction = directions[i];
+        input.lines[i].length = lengths[i];
+    }
+    /*
+     * expected size is the file header, 1 byte for the first direction,
+     * 2 bytes of turn bits, 15 single-byte lengths and 1 two-byte length
+     */
+    size_t expected_size = EXPECTED_FILE_HEADER_SIZE + 1 + 2 + 15 + 2;
+
+    // dump to compact format, then load it back in again
+    sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+    sxbp_spiral_t output = sxbp_blank_spiral();
+    if(sxbp_dump_spiral_compact(input, &buffer).status != SXBP_OPERATION_OK) {
+        result = false;
+    } else if(buffer.size != expected_size) {
+        result = false;
+    } else if(sxbp_load_spiral(buffer, &output).status != SXBP_OPERATION_OK) {
+        result = false;
+    } else if(
+        (output.size != input.size) ||
+        (output.solved_count != input.solved_count) ||
+        (output.seconds_spent != input.seconds_spent) ||
+        (output.seconds_accuracy != input.seconds_accuracy)
+    ) {
+        result = false;
+    } else {
+        for(uint8_t i = 0; i < 16; i++) {
+            if(
+                (output.lines[i].direction != directions[i]) ||
+                (output.lines[i].length != lengths[i])
+            ) {
+                result = false;
+            }
+        }
+    }
+    free(output.lines);
+
+    // a truncated compact file should be rejected
+    if(buffer.bytes != NULL) {
+        buffer.size--;
+        sxbp_spiral_t truncated = sxbp_blank_spiral();
+        sxbp_serialise_result_t truncated_result = sxbp_load_spiral(
+            buffer, &truncated
+        );
+        if(
+            (truncated_result.status != SXBP_OPERATION_FAIL) ||
+            (truncated_result.diagnostic != SXBP_DESERIALISE_BAD_DATA_SIZE) ||
+            (truncated.lines != NULL)
+        ) {
+            result = false;
+        }
+        // as should one claiming far more lines than its data could hold
+        buffer.size++;
+        buffer.bytes[10] = buffer.bytes[11] = 0xff;
+        buffer.bytes[12] = buffer.bytes[13] = 0xff;
+        sxbp_spiral_t oversized = sxbp_blank_spiral();
+        sxbp_serialise_result_t oversized_result = sxbp_load_spiral(
+            buffer, &oversized
+        );
+        if(
+            (oversized_result.status != SXBP_OPERATION_FAIL) ||
+            (oversized_result.diagnostic != SXBP_DESERIALISE_BAD_DATA_SIZE) ||
+            (oversized.lines != NULL)
+        ) {
+            result = false;
+        }
+    }
+
+    // free memory
+    free(input.lines);
+    free(buffer.bytes);
+
+    return result;
+}
+
+static bool test_sxbp_view_spiral(void) {
+    // success / failure variable
+    bool result = true;
+    // build input struct
+    sxbp_spiral_t input = {
+        .size = 16,
+        .solved_count = 5,
+        .seconds_spent = 3125,
+        .seconds_accuracy = 1,
+    };
+    input.lines = calloc(sizeof(sxbp_line_t), 16);
+    sxbp_direction_t directions[16] = {
+        SXBP_UP, SXBP_LEFT, SXBP_DOWN, SXBP_LEFT, SXBP_DOWN, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT, SXBP_UP, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT,
+    };
+    sxbp_length_t lengths[16] = {
+        1, 1, 1, 1, 1, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 1,
+    };
+    for(uint8_t i = 0; i < 16; i++) {
+        input.lines[i].direction = directions[i];
+        input.lines[i].length = lengths[i];
+    }
+
+    sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+    sxbp_spiral_t loaded = sxbp_blank_spiral();
+    sxbp_spiral_t viewed = sxbp_blank_spiral();
+    sxbp_dump_spiral_native(input, &buffer);
+    // the native format should load by copying on any platform
+    if(sxbp_load_spiral(buffer, &loaded).status != SXBP_OPERATION_OK) {
+        result = false;
+    } else {
+        for(uint8_t i = 0; i < 16; i++) {
+            if(
+                (loaded.lines[i].direction != directions[i]) ||
+                (loaded.lines[i].length != lengths[i])
+            ) {
+                result = false;
+            }
+        }
+    }
+    // and where it can be viewed, the view should point into the buffer
+    sxbp_serialise_result_t view_result = sxbp_view_spiral(buffer, &viewed);
+    if(view_result.status == SXBP_OPERATION_OK) {
+        if(
+            ((uint8_t*)viewed.lines != buffer.bytes + 32) ||
+            (viewed.size != 16) || (viewed.solved_count != 5)
+        ) {
+            result = false;
+        } else {
+            for(uint8_t i = 0; i < 16; i++) {
+                if(
+                    (viewed.lines[i].direction != directions[i]) ||
+                    (viewed.lines[i].length != lengths[i])
+                ) {
+                    result = false;
+                }
+            }
+        }
+    } else if(view_result.status != SXBP_NOT_IMPLEMENTED) {
+        result = false;
+    }
+
+    // free memory
+    free(input.lines);
+    free(loaded.lines);
+    free(buffer.bytes);
+
+    return result;
+}
+
+// state for the test stream callbacks for the next test case
+typedef struct test_stream_t {
+    uint8_t bytes[128];
+    size_t size;
+    size_t index;
+} test_stream_t;
+
+// test write callback, appends bytes to a test_stream_t
+static size_t test_stream_write(
+    const uint8_t* bytes, size_t size, void* user_data
 ) {
-    printf("%s: ", test_case_name);
-    fflush(stdout);
-    bool test_result = (*test_case_func)();
-    printf("%s\n", (test_result ? "PASS" : "FAIL"));
-    return test_suite_state && test_result;
+    test_stream_t* stream = (test_stream_t*)user_data;
+    if(stream->size + size > sizeof(stream->bytes)) {
+        return 0;
+    }
+    memcpy(stream->bytes + stream->size, bytes, size);
+    stream->size += size;
+    return size;
 }
 
-int main(void) {
-    // set up test suite status flag
+// test read callback, reads at most 3 bytes at a time from a test_stream_t
+static size_t test_stream_read(uint8_t* bytes, size_t size, void* user_data) {
+    test_stream_t* stream = (test_stream_t*)user_data;
+    size_t count = stream->size - stream->index;
+    count = (count < size) ? count : size;
+    count = (count < 3) ? count : 3;
+    memcpy(bytes, stream->bytes + stream->index, count);
+    stream->index += count;
+    return count;
+}
+
+static bool test_sxbp_dump_and_load_spiral_stream(void) {
+    // success / failure variable
     bool result = true;
-    // call run_test_case() for each test case
-    result = run_test_case(
-        result, test_sxbp_change_direction, "test_sxbp_change_direction"
-    );
-    result = run_test_case(
-        result, test_sxbp_init_spiral, "test_sxbp_init_spiral"
-    );
-    result = run_test_case(
-        result, test_sxbp_spiral_points, "test_sxbp_spiral_points"
-    );
-    result = run_test_case(
-        result, test_sxbp_cache_spiral_points_blank,
-        "test_sxbp_cache_spiral_points_blank"
-    );
-    result = run_test_case(
-        result, test_sxbp_plot_spiral, "test_sxbp_plot_spiral"
-    );
-    result = run_test_case(
-        result, test_sxbp_plot_spiral_partial, "test_sxbp_plot_spiral_partial"
-    );
-    result = run_test_case(
-        result, test_sxbp_plot_spiral_progress_callback,
-        "test_sxbp_plot_spiral_progress_callback"
-    );
-    result = run_test_case(
-        result, test_sxbp_load_spiral, "test_sxbp_load_spiral"
-    );
-    result = run_test_case(
-        result, test_sxbp_load_spiral_rejects_missing_magic_number,
-        "test_sxbp_load_spiral_rejects_missing_magic_number"
-    );
-    result = run_test_case(
-        result, test_sxbp_load_spiral_rejects_too_small_for_header,
-        "test_sxbp_load_spiral_rejects_too_small_for_header"
+    // build input struct
+    sxbp_spiral_t input = {
+        .size = 16,
+        .solved_count = 5,
+        .seconds_spent = 3125,
+        .seconds_accuracy = 1,
+    };
+    input.lines = calloc(sizeof(sxbp_line_t), 16);
+    sxbp_direction_t directions[16] = {
+        SXBP_UP, SXBP_LEFT, SXBP_DOWN, SXBP_LEFT, SXBP_DOWN, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT, SXBP_UP, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT,
+    };
+    sxbp_length_t lengths[16] = {
+        1, 1, 1, 1, 1, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 1,
+    };
+    for(uint8_t i = 0; i < 16; i++) {
+        input.lines[i].direction = directions[i];
+        input.lines[i].length = lengths[i];
+    }
+
+    // the streamed bytes should be identical to those of sxbp_dump_spiral()
+    test_stream_t stream = { .size = 0, .index = 0, };
+    sxbp_buffer_t expected = { .size = 0, .bytes = NULL, };
+    sxbp_dump_spiral(input, &expected);
+    sxbp_dump_spiral_stream(input, test_stream_write, (void*)&stream);
+    if(
+        (stream.size != expected.size) ||
+        (memcmp(stream.bytes, expected.bytes, expected.size) != 0)
+    ) {
+        result = false;
+    }
+    // and should load back in again
+    sxbp_spiral_t output = sxbp_blank_spiral();
+    if(
+        sxbp_load_spiral_stream(
+            test_stream_read, (void*)&stream, &output
+        ).status != SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else {
+        for(uint8_t i = 0; i < 16; i++) {
+            if(
+                (output.lines[i].direction != directions[i]) ||
+                (output.lines[i].length != lengths[i])
+            ) {
+                result = false;
+            }
+        }
+    }
+    // data following the last line should be rejected, as when not streamed
+    test_stream_t trailing = { .size = stream.size + 7, .index = 0, };
+    memcpy(trailing.bytes, stream.bytes, stream.size);
+    memset(trailing.bytes + stream.size, 0xa5, 7);
+    sxbp_buffer_t trailing_buffer = {
+        .bytes = trailing.bytes, .size = trailing.size,
+    };
+    sxbp_spiral_t unstreamed_trailing = sxbp_blank_spiral();
+    sxbp_spiral_t streamed_trailing = sxbp_blank_spiral();
+    sxbp_serialise_result_t trailing_results[2] = {
+        sxbp_load_spiral(trailing_buffer, &unstreamed_trailing),
+        sxbp_load_spiral_stream(
+            test_stream_read, (void*)&trailing, &streamed_trailing
+        ),
+    };
+    for(uint8_t i = 0; i < 2; i++) {
+        if(
+            (trailing_results[i].status != SXBP_OPERATION_FAIL) ||
+            (trailing_results[i].diagnostic != SXBP_DESERIALISE_BAD_DATA_SIZE)
+        ) {
+            result = false;
+        }
+    }
+    free(unstreamed_trailing.lines);
+    free(streamed_trailing.lines);
+    /*
+     * a stream claiming billions of lines but holding only one should be
+     * rejected for its size, without trying to allocate them all first
+     */
+    test_stream_t oversized = { .size = 30, .index = 0, };
+    memcpy(oversized.bytes, stream.bytes, oversized.size);
+    oversized.bytes[10] = 0xff;
+    oversized.bytes[11] = 0xff;
+    oversized.bytes[12] = 0xff;
+    oversized.bytes[13] = 0xf0;
+    sxbp_spiral_t oversized_output = sxbp_blank_spiral();
+    sxbp_serialise_result_t oversized_result = sxbp_load_spiral_stream(
+        test_stream_read, (void*)&oversized, &oversized_output
     );
-    result = run_test_case(
-        result, test_sxbp_load_spiral_rejects_too_small_data_section,
-        "test_sxbp_load_spiral_rejects_too_small_data_section"
+    if(
+        (oversized_result.status != SXBP_OPERATION_FAIL) ||
+        (oversized_result.diagnostic != SXBP_DESERIALISE_BAD_DATA_SIZE) ||
+        (oversized_output.lines != NULL)
+    ) {
+        result = false;
+    }
+    // a stream which ends early should be rejected
+    sxbp_spiral_t truncated = sxbp_blank_spiral();
+    stream.size -= 2;
+    stream.index = 0;
+    sxbp_serialise_result_t truncated_result = sxbp_load_spiral_stream(
+        test_stream_read, (void*)&stream, &truncated
     );
-    result = run_test_case(
-        result, test_sxbp_load_spiral_rejects_wrong_version,
-        "test_sxbp_load_spiral_rejects_wrong_version"
+    if(
+        (truncated_result.status != SXBP_OPERATION_FAIL) ||
+        (truncated_result.diagnostic != SXBP_DESERIALISE_BAD_DATA_SIZE)
+    ) {
+        result = false;
+    }
+    // the native and compact formats can't be streamed, and should say so
+    sxbp_buffer_t others[2] = {
+        { .size = 0, .bytes = NULL, }, { .size = 0, .bytes = NULL, },
+    };
+    sxbp_dump_spiral_native(input, &others[0]);
+    sxbp_dump_spiral_compact(input, &others[1]);
+    for(uint8_t f = 0; f < 2; f++) {
+        test_stream_t other = { .size = others[f].size, .index = 0, };
+        memcpy(other.bytes, others[f].bytes, others[f].size);
+        sxbp_spiral_t unstreamed = sxbp_blank_spiral();
+        sxbp_serialise_result_t other_result = sxbp_load_spiral_stream(
+            test_stream_read, (void*)&other, &unstreamed
+        );
+        if(
+            (other_result.status != SXBP_NOT_IMPLEMENTED) ||
+            (other_result.diagnostic != SXBP_DESERIALISE_OK) ||
+            (unstreamed.lines != NULL)
+        ) {
+            result = false;
+        }
+        free(others[f].bytes);
+    }
+
+    // free memory
+    free(input.lines);
+    free(output.lines);
+    free(expected.bytes);
+
+    return result;
+}
+
+static bool test_sxbp_dump_and_load_large_spiral(void) {
+    // success / failure variable
+    bool result = true;
+    // large enough that packing may be split across multiple threads
+    uint32_t size = 100000;
+    sxbp_spiral_t input = sxbp_blank_spiral();
+    input.size = size;
+    input.lines = calloc(sizeof(sxbp_line_t), size);
+    for(uint32_t i = 0; i < size; i++) {
+        input.lines[i].direction = i % 4;
+        // exercise every bit of the 30-bit line lengths
+        input.lines[i].length = (i * 2654435761UL) & 0x3fffffff;
+    }
+    sxbp_buffer_t standard = { .size = 0, .bytes = NULL, };
+    sxbp_buffer_t native = { .size = 0, .bytes = NULL, };
+    sxbp_dump_spiral(input, &standard);
+    sxbp_dump_spiral_native(input, &native);
+    // check the packing of the last line by hand
+    uint32_t word = (
+        ((uint32_t)input.lines[size - 1].direction << 30) |
+        input.lines[size - 1].length
     );
-    result = run_test_case(
-        result, test_sxbp_dump_spiral, "test_sxbp_dump_spiral"
+    size_t last = standard.size - SXBP_LINE_T_PACK_SIZE;
+    if(
+        (standard.bytes[last] != (uint8_t)(word >> 24)) ||
+        (standard.bytes[last + 1] != (uint8_t)(word >> 16)) ||
+        (standard.bytes[last + 2] != (uint8_t)(word >> 8)) ||
+        (standard.bytes[last + 3] != (uint8_t)word)
+    ) {
+        result = false;
+    }
+    // both formats should load back in to the same lines
+    sxbp_spiral_t from_standard = sxbp_blank_spiral();
+    sxbp_spiral_t from_native = sxbp_blank_spiral();
+    if(
+        (sxbp_load_spiral(standard, &from_standard).status != SXBP_OPERATION_OK)
+        || (sxbp_load_spiral(native, &from_native).status != SXBP_OPERATION_OK)
+    ) {
+        result = false;
+    } else {
+        for(uint32_t i = 0; i < size; i++) {
+            if(
+                (from_standard.lines[i].direction != input.lines[i].direction)
+                || (from_standard.lines[i].length != input.lines[i].length)
+                || (from_native.lines[i].direction != input.lines[i].direction)
+                || (from_native.lines[i].length != input.lines[i].length)
+            ) {
+                result = false;
+            }
+        }
+    }
+
+    // free memory
+    free(input.lines);
+    free(from_standard.lines);
+    free(from_native.lines);
+    free(standard.bytes);
+    free(native.bytes);
+
+    return result;
+}
+
+// test read-at callback, reads at most 5 bytes at a time from a sxbp_buffer_t
+static size_t test_buffer_read_at(
+    uint8_t* bytes, size_t size, size_t offset, void* user_data
+) {
+    sxbp_buffer_t* buffer = (sxbp_buffer_t*)user_data;
+    if(offset >= buffer->size) {
+        return 0;
+    }
+    size_t count = buffer->size - offset;
+    count = (count < size) ? count : size;
+    count = (count < 5) ? count : 5;
+    memcpy(bytes, buffer->bytes + offset, count);
+    return count;
+}
+
+static bool test_sxbp_peek_spiral_and_load_spiral_lines(void) {
+    // success / failure variable
+    bool result = true;
+    // build a spiral spanning several blocks of the compact format's index
+    sxbp_spiral_t input = make_test_spiral(300);
+    input.solved_count = 123;
+    input.seconds_spent = 45;
+    for(uint32_t i = 0; i < input.size; i++) {
+        // mix of lengths taking one, two and three bytes as varints
+        input.lines[i].length = (i * 97) % 20000;
+    }
+    sxbp_buffer_t buffers[3] = {
+        { .size = 0, .bytes = NULL, },
+        { .size = 0, .bytes = NULL, },
+        { .size = 0, .bytes = NULL, },
+    };
+    sxbp_dump_spiral(input, &buffers[0]);
+    sxbp_dump_spiral_compact(input, &buffers[1]);
+    sxbp_dump_spiral_native(input, &buffers[2]);
+    sxbp_file_format_t formats[3] = {
+        SXBP_FILE_FORMAT_STANDARD, SXBP_FILE_FORMAT_COMPACT,
+        SXBP_FILE_FORMAT_NATIVE,
+    };
+    // ranges at the start, end and straddling blocks of the spiral
+    uint32_t ranges[4][2] = {
+        { 0, 1, }, { 1000, 2100, }, { 2047, 2049, }, { 2400, 2401, },
+    };
+    sxbp_line_t lines[1100];
+    for(uint8_t f = 0; f < 3; f++) {
+        // the header alone should be enough to peek at
+        sxbp_buffer_t header = {
+            .bytes = buffers[f].bytes, .size = SXBP_FILE_HEADER_SIZE,
+        };
+        sxbp_spiral_info_t info;
+        if(
+            (sxbp_peek_spiral(header, &info).status != SXBP_OPERATION_OK) ||
+            (info.format != formats[f]) || (info.size != input.size) ||
+            (info.solved_count != 123) || (info.seconds_spent != 45)
+        ) {
+            result = false;
+        }
+        sxbp_line_index_t index;
+        if(
+            sxbp_index_spiral(
+                test_buffer_read_at, (void*)&buffers[f], &index
+            ).status != SXBP_OPERATION_OK
+        ) {
+            result = false;
+            continue;
+        }
+        for(uint8_t r = 0; r < 4; r++) {
+            uint32_t start = ranges[r][0];
+            uint32_t end = ranges[r][1];
+            if(
+                sxbp_load_spiral_lines(
+                    test_buffer_read_at, (void*)&buffers[f], &index,
+                    start, end, lines
+                ).status != SXBP_OPERATION_OK
+            ) {
+                result = false;
+                continue;
+            }
+            for(uint32_t i = start; i < end; i++) {
+                if(
+                    (lines[i - start].direction != input.lines[i].direction) ||
+                    (lines[i - start].length != input.lines[i].length)
+                ) {
+                    result = false;
+                }
+            }
+        }
+        // a truncated file should be caught when its lines are read
+        buffers[f].size -= 2;
+        if(
+            sxbp_load_spiral_lines(
+                test_buffer_read_at, (void*)&buffers[f], &index,
+                input.size - 1, input.size, lines
+            ).status != SXBP_OPERATION_FAIL
+        ) {
+            result = false;
+        }
+        sxbp_free_line_index(&index);
+    }
+    // a header which is too small should be rejected
+    sxbp_buffer_t too_small = {
+        .bytes = buffers[0].bytes, .size = SXBP_FILE_HEADER_SIZE - 1,
+    };
+    sxbp_spiral_info_t info;
+    if(
+        sxbp_peek_spiral(too_small, &info).diagnostic !=
+        SXBP_DESERIALISE_BAD_HEADER_SIZE
+    ) {
+        result = false;
+    }
+
+    // free memory
+    free(input.lines);
+    for(uint8_t f = 0; f < 3; f++) {
+        free(buffers[f].bytes);
+    }
+
+    return result;
+}
+
+// test write callback, appends bytes to a sxbp_buffer_t, growing it as needed
+static size_t test_buffer_write(
+    const uint8_t* bytes, size_t size, void* user_data
+) {
+    sxbp_buffer_t* buffer = (sxbp_buffer_t*)user_data;
+    uint8_t* grown = realloc(buffer->bytes, buffer->size + size);
+    if(grown == NULL) {
+        return 0;
+    }
+    memcpy(grown + buffer->size, bytes, size);
+    buffer->bytes = grown;
+    buffer->size += size;
+    return size;
+}
+
+// test callback for sxbp_archive_for_each(), marks each entry as visited
+static sxbp_status_t test_archive_visit(
+    sxbp_buffer_t spiral_data, uint32_t entry_index, void* user_data
+) {
+    bool* visited = (bool*)user_data;
+    sxbp_spiral_t spiral = sxbp_blank_spiral();
+    if(sxbp_load_spiral(spiral_data, &spiral).status != SXBP_OPERATION_OK) {
+        return SXBP_OPERATION_FAIL;
+    }
+    free(spiral.lines);
+    visited[entry_index] = true;
+    return SXBP_OPERATION_OK;
+}
+
+static bool test_sxbp_archive(void) {
+    // success / failure variable
+    bool result = true;
+    // serialise two different spirals
+    sxbp_buffer_t spirals[2] = {
+        { .size = 0, .bytes = NULL, }, { .size = 0, .bytes = NULL, },
+    };
+    for(uint8_t s = 0; s < 2; s++) {
+        uint8_t data[2] = { (uint8_t)(s + 1), 0x5a, };
+        sxbp_buffer_t data_buffer = { .bytes = data, .size = 2, };
+        sxbp_spiral_t spiral = sxbp_blank_spiral();
+        sxbp_init_spiral(data_buffer, &spiral);
+        sxbp_dump_spiral(spiral, &spirals[s]);
+        free(spiral.lines);
+    }
+    // write the first spiral twice, with and without de-duplication
+    for(uint8_t deduplicate = 0; deduplicate < 2; deduplicate++) {
+        sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+        sxbp_archive_writer_t writer;
+        if(
+            (
+                sxbp_begin_archive(
+                    test_buffer_write, (void*)&buffer, deduplicate, &writer
+                ) != SXBP_OPERATION_OK
+            ) ||
+            (sxbp_archive_append(&writer, spirals[0]) != SXBP_OPERATION_OK) ||
+            (sxbp_archive_append(&writer, spirals[1]) != SXBP_OPERATION_OK) ||
+            (sxbp_archive_append(&writer, spirals[0]) != SXBP_OPERATION_OK) ||
+            (sxbp_finish_archive(&writer) != SXBP_OPERATION_OK)
+        ) {
+            result = false;
+        }
+        sxbp_archive_t archive;
+        if(
+            sxbp_open_archive(buffer, &archive).status != SXBP_OPERATION_OK
+        ) {
+            result = false;
+        } else {
+            // duplicates should only be stored when not de-duplicating
+            if(archive.count != (deduplicate ? 2 : 3)) {
+                result = false;
+            }
+            // both spirals should be found by their hashes
+            for(uint8_t s = 0; s < 2; s++) {
+                sxbp_buffer_t found;
+                if(
+                    (
+                        sxbp_archive_find(
+                            &archive, sxbp_hash_spiral_data(spirals[s]), &found
+                        ).status != SXBP_OPERATION_OK
+                    ) ||
+                    (found.size != spirals[s].size) ||
+                    (memcmp(found.bytes, spirals[s].bytes, found.size) != 0)
+                ) {
+                    result = false;
+                }
+            }
+            // every entry should be visited
+            bool visited[3] = { false, false, false, };
+            if(
+                sxbp_archive_for_each(
+                    &archive, test_archive_visit, (void*)visited
+                ) != SXBP_OPERATION_OK
+            ) {
+                result = false;
+            }
+            for(uint32_t i = 0; i < archive.count; i++) {
+                if(!visited[i]) {
+                    result = false;
+                }
+            }
+        }
+        // a truncated archive should be rejected
+        buffer.size--;
+        if(sxbp_open_archive(buffer, &archive).status != SXBP_OPERATION_FAIL) {
+            result = false;
+        }
+        free(buffer.bytes);
+    }
+    // enough spirals to grow the de-duplication table should all be kept once
+    sxbp_buffer_t many = { .size = 0, .bytes = NULL, };
+    sxbp_archive_writer_t many_writer;
+    if(
+        sxbp_begin_archive(test_buffer_write, (void*)&many, true, &many_writer)
+        != SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else {
+        for(uint16_t pass = 0; pass < 2; pass++) {
+            for(uint16_t s = 0; s < 300; s++) {
+                uint8_t data[2] = { (uint8_t)(s >> 8), (uint8_t)s, };
+                sxbp_buffer_t data_buffer = { .bytes = data, .size = 2, };
+                sxbp_spiral_t spiral = sxbp_blank_spiral();
+                sxbp_buffer_t spiral_data = { .size = 0, .bytes = NULL, };
+                sxbp_init_spiral(data_buffer, &spiral);
+                sxbp_dump_spiral(spiral, &spiral_data);
+                if(
+                    sxbp_archive_append(&many_writer, spiral_data) !=
+                    SXBP_OPERATION_OK
+                ) {
+                    result = false;
+                }
+                free(spiral.lines);
+                free(spiral_data.bytes);
+            }
+        }
+        if(
+            (many_writer.count != 300) ||
+            (many_writer.table_size < 2 * many_writer.count) ||
+            (sxbp_finish_archive(&many_writer) != SXBP_OPERATION_OK)
+        ) {
+            result = false;
+        }
+    }
+    free(many.bytes);
+    // a writer whose header can't be written should hold no memory afterwards
+    test_stream_t full = { .size = sizeof(full.bytes), .index = 0, };
+    sxbp_archive_writer_t failed;
+    if(
+        (
+            sxbp_begin_archive(test_stream_write, (void*)&full, true, &failed)
+            != SXBP_OPERATION_FAIL
+        ) ||
+        (failed.entries != NULL) || (failed.table != NULL) ||
+        (failed.checks != NULL)
+    ) {
+        result = false;
+    }
+
+    // free memory
+    free(spirals[0].bytes);
+    free(spirals[1].bytes);
+
+    return result;
+}
+
+static bool test_sxbp_dump_spiral_into(void) {
+    // success / failure variable
+    bool result = true;
+    uint8_t data[3] = { 0x4f, 0x12, 0xa0, };
+    sxbp_buffer_t data_buffer = { .bytes = data, .size = 3, };
+    sxbp_spiral_t input = sxbp_blank_spiral();
+    sxbp_init_spiral(data_buffer, &input);
+    for(uint32_t i = 0; i < input.size; i++) {
+        input.lines[i].length = i * 11;
+    }
+    sxbp_buffer_t expected[3] = {
+        { .size = 0, .bytes = NULL, },
+        { .size = 0, .bytes = NULL, },
+        { .size = 0, .bytes = NULL, },
+    };
+    sxbp_dump_spiral(input, &expected[0]);
+    sxbp_dump_spiral_compact(input, &expected[1]);
+    sxbp_dump_spiral_native(input, &expected[2]);
+    sxbp_file_format_t formats[3] = {
+        SXBP_FILE_FORMAT_STANDARD, SXBP_FILE_FORMAT_COMPACT,
+        SXBP_FILE_FORMAT_NATIVE,
+    };
+    // the same memory is re-used for each format, dirty from the last
+    uint8_t memory[256];
+    memset(memory, 0xff, sizeof(memory));
+    for(uint8_t f = 0; f < 3; f++) {
+        size_t size = sxbp_dump_spiral_size(input, formats[f]);
+        size_t written = 0;
+        sxbp_buffer_t buffer = { .bytes = memory, .size = size, };
+        if(
+            (size != expected[f].size) ||
+            (
+                sxbp_dump_spiral_into(
+                    input, formats[f], buffer, &written
+                ).status != SXBP_OPERATION_OK
+            ) ||
+            (written != size) ||
+            (memcmp(memory, expected[f].bytes, size) != 0)
+        ) {
+            result = false;
+        }
+        // one byte too few isn't enough
+        buffer.size--;
+        if(
+            sxbp_dump_spiral_into(
+                input, formats[f], buffer, &written
+            ).status != SXBP_OPERATION_FAIL || written != 0
+        ) {
+            result = false;
+        }
+        free(expected[f].bytes);
+    }
+    // spirals with lines which don't turn can't be stored compactly
+    input.lines[1].direction = input.lines[0].direction;
+    if(sxbp_dump_spiral_size(input, SXBP_FILE_FORMAT_COMPACT) != 0) {
+        result = false;
+    }
+
+    // free memory
+    free(input.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_spiral_raw(void) {
+    // success / failure variable
+    bool result = true;
+    // a spiral of three lines, going up, right and then down
+    sxbp_spiral_t spiral = sxbp_blank_spiral();
+    spiral.size = 3;
+    spiral.lines = calloc(sizeof(sxbp_line_t), spiral.size);
+    sxbp_direction_t directions[3] = { SXBP_UP, SXBP_RIGHT, SXBP_DOWN, };
+    for(uint8_t i = 0; i < 3; i++) {
+        spiral.lines[i].direction = directions[i];
+        spiral.lines[i].length = 1;
+    }
+    // expected image, the second pixel of the first line is never drawn
+    bool expected[5][5] = {
+        { false, false, false, false, false, },
+        { false, true, true, true, false, },
+        { false, false, false, true, false, },
+        { false, true, false, true, false, },
+        { false, false, false, false, false, },
+    };
+    sxbp_bitmap_t image = { .pixels = NULL, };
+    if(sxbp_render_spiral_raw(spiral, &image) != SXBP_OPERATION_OK) {
+        result = false;
+    } else if(image.width != 5 || image.height != 5) {
+        result = false;
+    } else {
+        for(uint32_t y = 0; y < 5; y++) {
+            for(uint32_t x = 0; x < 5; x++) {
+                if(sxbp_get_bitmap_pixel(image, x, y) != expected[y][x]) {
+                    result = false;
+                }
+            }
+            // unused bits at the end of each row should be clear
+            if((image.pixels[y] & 0x07) != 0) {
+                result = false;
+            }
+        }
+    }
+
+    // free memory
+    sxbp_free_bitmap(&image);
+    free(spiral.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_backends_into(void) {
+    // success / failure variable
+    bool result = true;
+    // build a small bitmap with a diagonal line through it
+    sxbp_bitmap_t bitmap = { .pixels = NULL, };
+    sxbp_init_bitmap(13, 5, &bitmap);
+    for(uint32_t x = 0; x < bitmap.width; x++) {
+        bitmap.pixels[
+            ((x % bitmap.height) * sxbp_bitmap_row_size(bitmap.width)) + (x / 8)
+        ] |= 0x80 >> (x % 8);
+    }
+    sxbp_buffer_t expected = { .size = 0, .bytes = NULL, };
+    uint8_t memory[1024];
+    size_t written = 0;
+    sxbp_buffer_t buffer = { .bytes = memory, };
+    // the PBM image should be identical and exactly the size given
+    sxbp_render_backend_pbm(bitmap, &expected);
+    buffer.size = sxbp_render_backend_pbm_size(bitmap);
+    memset(memory, 0xff, sizeof(memory));
+    if(
+        (buffer.size != expected.size) ||
+        (
+            sxbp_render_backend_pbm_into(bitmap, buffer, &written) !=
+            SXBP_OPERATION_OK
+        ) ||
+        (written != expected.size) ||
+        (memcmp(memory, expected.bytes, written) != 0)
+    ) {
+        result = false;
+    }
+    free(expected.bytes);
+    buffer.size--;
+    if(
+        sxbp_render_backend_pbm_into(bitmap, buffer, &written) !=
+        SXBP_OPERATION_FAIL
+    ) {
+        result = false;
+    }
+    // the PNG image should be identical and fit within the bound given
+    if(SXBP_PNG_SUPPORT) {
+        expected.bytes = NULL;
+        sxbp_render_backend_png(bitmap, &expected);
+        buffer.size = sxbp_render_backend_png_size_bound(bitmap);
+        if(
+            (buffer.size < expected.size) || (buffer.size > sizeof(memory)) ||
+            (
+                sxbp_render_backend_png_into(bitmap, buffer, &written) !=
+                SXBP_OPERATION_OK
+            ) ||
+            (written != expected.size) ||
+            (memcmp(memory, expected.bytes, written) != 0)
+        ) {
+            result = false;
+        }
+        buffer.size = expected.size - 1;
+        if(
+            sxbp_render_backend_png_into(bitmap, buffer, &written) !=
+            SXBP_OPERATION_FAIL
+        ) {
+            result = false;
+        }
+        free(expected.bytes);
+    }
+
+    // free memory
+    sxbp_free_bitmap(&bitmap);
+
+    return result;
+}
+
+static bool test_sxbp_render_backend_streams(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_spiral_t spiral = make_overlapping_spiral(40);
+    // the streamed images should be identical to those rendered from bitmaps
+    sxbp_buffer_t expected = { .size = 0, .bytes = NULL, };
+    sxbp_buffer_t streamed = { .size = 0, .bytes = NULL, };
+    if(
+        (
+            sxbp_render_spiral_image(
+                spiral, &expected, sxbp_render_backend_pbm
+            ) != SXBP_OPERATION_OK
+        ) ||
+        (
+            sxbp_render_backend_pbm_stream(
+                spiral, test_buffer_write, (void*)&streamed
+            ) != SXBP_OPERATION_OK
+        ) ||
+        (streamed.size != expected.size) ||
+        (memcmp(streamed.bytes, expected.bytes, expected.size) != 0)
+    ) {
+        result = false;
+    }
+    free(expected.bytes);
+    free(streamed.bytes);
+    if(SXBP_PNG_SUPPORT) {
+        expected.bytes = NULL;
+        streamed.bytes = NULL;
+        streamed.size = 0;
+        if(
+            (
+                sxbp_render_spiral_image(
+                    spiral, &expected, sxbp_render_backend_png
+                ) != SXBP_OPERATION_OK
+            ) ||
+            (
+                sxbp_render_backend_png_stream(
+                    spiral, test_buffer_write, (void*)&streamed
+                ) != SXBP_OPERATION_OK
+            ) ||
+            (streamed.size != expected.size) ||
+            (memcmp(streamed.bytes, expected.bytes, expected.size) != 0)
+        ) {
+            result = false;
+        }
+        free(expected.bytes);
+        free(streamed.bytes);
+    }
+
+    // free memory
+    free(spiral.lines);
+
+    return result;
+}
+
+// test callback for sxbp_render_spiral_tiles(), copies each tile into a bitmap
+static sxbp_status_t test_copy_tile(
+    sxbp_bitmap_t tile, uint32_t x, uint32_t y, void* user_data
+) {
+    sxbp_bitmap_t* image = (sxbp_bitmap_t*)user_data;
+    size_t row_size = sxbp_bitmap_row_size(image->width);
+    for(uint32_t ty = 0; ty < tile.height; ty++) {
+        for(uint32_t tx = 0; tx < tile.width; tx++) {
+            if(sxbp_get_bitmap_pixel(tile, tx, ty)) {
+                image->pixels[((y + ty) * row_size) + ((x + tx) / 8)] |= (
+                    (uint8_t)(0x80 >> ((x + tx) % 8))
+                );
+            }
+        }
+    }
+    return SXBP_OPERATION_OK;
+}
+
+static bool test_sxbp_render_spiral_tiles(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_spiral_t spiral = make_overlapping_spiral(40);
+    sxbp_bitmap_t expected = { .pixels = NULL, };
+    sxbp_render_spiral_raw(spiral, &expected);
+    // tiles of awkward sizes, which don't divide the image evenly
+    uint32_t sizes[3][2] = { { 7, 5, }, { 13, 1, }, { 0, 0, }, };
+    for(uint8_t i = 0; i < 3; i++) {
+        sxbp_bitmap_t image = { .pixels = NULL, };
+        sxbp_init_bitmap(expected.width, expected.height, &image);
+        if(
+            (
+                sxbp_render_spiral_tiles(
+                    spiral, sizes[i][0], sizes[i][1], 1024 * 1024, NULL,
+                    test_copy_tile, (void*)&image
+                ) != SXBP_OPERATION_OK
+            ) ||
+            (
+                memcmp(
+                    image.pixels, expected.pixels,
+                    sxbp_bitmap_row_size(image.width) * image.height
+                ) != 0
+            )
+        ) {
+            result = false;
+        }
+        sxbp_free_bitmap(&image);
+    }
+    // rendering should be refused if it can't be done within the memory limit
+    if(
+        sxbp_render_spiral_tiles(
+            spiral, 0, 0, 64, NULL, test_copy_tile, (void*)&expected
+        ) != SXBP_MALLOC_REFUSED
+    ) {
+        result = false;
+    }
+
+    // free memory
+    sxbp_free_bitmap(&expected);
+    free(spiral.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_spiral_parallel(void) {
+    // success / failure variable
+    bool result = true;
+    // an unsolved spiral tall enough to be split into many bands
+    sxbp_spiral_t spiral = make_overlapping_spiral(300);
+    // rendering in parallel bands should give the same image
+    sxbp_bitmap_t expected = { .pixels = NULL, };
+    sxbp_bitmap_t image = { .pixels = NULL, };
+    sxbp_render_spiral_raw(spiral, &expected);
+    if(
+        (sxbp_render_spiral_parallel(spiral, &image) != SXBP_OPERATION_OK) ||
+        (image.width != expected.width) || (image.height != expected.height) ||
+        (
+            memcmp(
+                image.pixels, expected.pixels,
+                sxbp_bitmap_row_size(image.width) * image.height
+            ) != 0
+        )
+    ) {
+        result = false;
+    }
+
+    // free memory
+    sxbp_free_bitmap(&expected);
+    sxbp_free_bitmap(&image);
+    free(spiral.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_spiral_viewport(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_spiral_t spiral = make_overlapping_spiral(300);
+    sxbp_bitmap_t expected = { .pixels = NULL, };
+    sxbp_render_spiral_raw(spiral, &expected);
+    sxbp_segment_index_t index = { .list = { .segments = NULL, }, };
+    if(sxbp_index_spiral_segments(spiral, &index) != SXBP_OPERATION_OK) {
+        result = false;
+    }
+    // the whole spiral at a scale of 2 should match the full render
+    sxbp_viewport_t viewport = sxbp_spiral_viewport(&index, 2.0);
+    sxbp_bitmap_t image = { .pixels = NULL, };
+    if(
+        (viewport.width != expected.width) ||
+        (viewport.height != expected.height) ||
+        (
+            sxbp_render_spiral_viewport(&index, viewport, &image) !=
+            SXBP_OPERATION_OK
+        ) ||
+        (
+            memcmp(
+                image.pixels, expected.pixels,
+                sxbp_bitmap_row_size(image.width) * image.height
+            ) != 0
+        )
+    ) {
+        result = false;
+    }
+    sxbp_free_bitmap(&image);
+    // a region of it should match the same region of the full render
+    viewport.x += 100.0;
+    viewport.y += 37.0;
+    viewport.width = 123;
+    viewport.height = 45;
+    if(
+        sxbp_render_spiral_viewport(&index, viewport, &image) !=
+        SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else {
+        // pixels of the region are offset, rows counting from the bottom
+        uint32_t left = 200;
+        uint32_t top = expected.height - 74 - image.height;
+        for(uint32_t y = 0; y < image.height; y++) {
+            for(uint32_t x = 0; x < image.width; x++) {
+                if(
+                    sxbp_get_bitmap_pixel(image, x, y) !=
+                    sxbp_get_bitmap_pixel(expected, left + x, top + y)
+                ) {
+                    result = false;
+                }
+            }
+        }
+    }
+    sxbp_free_bitmap(&image);
+    // a region outside of the spiral should be blank
+    viewport.x = -1e6;
+    if(
+        sxbp_render_spiral_viewport(&index, viewport, &image) !=
+        SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else {
+        size_t image_size = sxbp_bitmap_row_size(image.width) * image.height;
+        for(size_t i = 0; i < image_size; i++) {
+            if(image.pixels[i] != 0) {
+                result = false;
+            }
+        }
+    }
+    sxbp_free_bitmap(&image);
+
+    // free memory
+    sxbp_free_segment_index(&index);
+    sxbp_free_bitmap(&expected);
+    free(spiral.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_spiral_scaled(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_spiral_t spiral = make_overlapping_spiral(40);
+    sxbp_bitmap_t expected = { .pixels = NULL, };
+    sxbp_render_spiral_raw(spiral, &expected);
+    // each pixel should be shaded by the black pixels in its block
+    uint32_t factors[3] = { 1, 3, 8, };
+    for(uint8_t i = 0; i < 3; i++) {
+        uint32_t factor = factors[i];
+        sxbp_greymap_t image = { .pixels = NULL, };
+        if(
+            (
+                sxbp_render_spiral_scaled(spiral, factor, &image) !=
+                SXBP_OPERATION_OK
+            ) ||
+            (image.width != (expected.width + factor - 1) / factor) ||
+            (image.height != (expected.height + factor - 1) / factor)
+        ) {
+            result = false;
+            sxbp_free_greymap(&image);
+            continue;
+        }
+        for(uint32_t y = 0; y < image.height; y++) {
+            for(uint32_t x = 0; x < image.width; x++) {
+                uint32_t count = 0;
+                for(uint32_t by = y * factor; by < (y + 1) * factor; by++) {
+                    for(uint32_t bx = x * factor; bx < (x + 1) * factor; bx++) {
+                        if(
+                            bx < expected.width && by < expected.height &&
+                            sxbp_get_bitmap_pixel(expected, bx, by)
+                        ) {
+                            count++;
+                        }
+                    }
+                }
+                uint32_t area = factor * factor;
+                if(
+                    image.pixels[(y * image.width) + x] !=
+                    ((count * 255) + (area / 2)) / area
+                ) {
+                    result = false;
+                }
+            }
+        }
+        sxbp_free_greymap(&image);
+    }
+    // each level of a mipmap should be within a shade of rendering directly
+    sxbp_greymap_t levels[3] = {
+        { .pixels = NULL, }, { .pixels = NULL, }, { .pixels = NULL, },
+    };
+    sxbp_greymap_t direct = { .pixels = NULL, };
+    if(
+        (sxbp_render_spiral_mipmap(spiral, 2, 3, levels) != SXBP_OPERATION_OK) ||
+        (sxbp_render_spiral_scaled(spiral, 4, &direct) != SXBP_OPERATION_OK) ||
+        (levels[1].width != direct.width) ||
+        (levels[1].height != direct.height) ||
+        (levels[2].width != (direct.width + 1) / 2)
+    ) {
+        result = false;
+    } else {
+        for(size_t i = 0; i < (size_t)direct.width * direct.height; i++) {
+            if(abs(levels[1].pixels[i] - direct.pixels[i]) > 1) {
+                result = false;
+            }
+        }
+    }
+    // PGM images should have black as 0
+    sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+    if(
+        (sxbp_render_backend_pgm(direct, &buffer) != SXBP_OPERATION_OK) ||
+        (buffer.size < (size_t)direct.width * direct.height) ||
+        (memcmp(buffer.bytes, "P5\n", 3) != 0) ||
+        (
+            buffer.bytes[buffer.size - 1] !=
+            255 - direct.pixels[(size_t)direct.width * direct.height - 1]
+        )
+    ) {
+        result = false;
+    }
+
+    // free memory
+    free(buffer.bytes);
+    sxbp_free_greymap(&direct);
+    for(uint8_t i = 0; i < 3; i++) {
+        sxbp_free_greymap(&levels[i]);
+    }
+    sxbp_free_bitmap(&expected);
+    free(spiral.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_backend_svg(void) {
+    // success / failure variable
+    bool result = true;
+    // a spiral with two lines going up, which should be merged into one
+    sxbp_spiral_t spiral = sxbp_blank_spiral();
+    spiral.size = 4;
+    spiral.lines = calloc(sizeof(sxbp_line_t), spiral.size);
+    sxbp_direction_t directions[4] = { SXBP_UP, SXBP_UP, SXBP_RIGHT, SXBP_DOWN, };
+    sxbp_length_t lengths[4] = { 1, 2, 1, 1, };
+    for(uint8_t i = 0; i < 4; i++) {
+        spiral.lines[i].direction = directions[i];
+        spiral.lines[i].length = lengths[i];
+    }
+    const char* expected = (
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"5\" height=\"9\" "
+        "viewBox=\"0 0 10 18\">\n"
+        "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+        "<path fill=\"none\" stroke=\"black\" stroke-width=\"2\" "
+        "stroke-linecap=\"square\" stroke-linejoin=\"miter\" "
+        "d=\"M3 15v-12h4v4\"/>\n"
+        "</svg>\n"
+    );
+    sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+    sxbp_buffer_t streamed = { .size = 0, .bytes = NULL, };
+    if(
+        (sxbp_render_backend_svg(spiral, &buffer) != SXBP_OPERATION_OK) ||
+        (buffer.size != strlen(expected)) ||
+        (memcmp(buffer.bytes, expected, buffer.size) != 0) ||
+        (
+            sxbp_render_backend_svg_stream(
+                spiral, test_buffer_write, (void*)&streamed
+            ) != SXBP_OPERATION_OK
+        ) ||
+        (streamed.size != buffer.size) ||
+        (memcmp(streamed.bytes, buffer.bytes, buffer.size) != 0)
+    ) {
+        result = false;
+    }
+
+    // free memory
+    free(buffer.bytes);
+    free(streamed.bytes);
+    free(spiral.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_backend_png_parallel(void) {
+    // success / failure variable
+    bool result = true;
+    // PNG support is optional, so there's nothing to test without it
+    if(!SXBP_PNG_SUPPORT) {
+        return result;
+    }
+    // build a bitmap with a diagonal line through it
+    sxbp_bitmap_t bitmap = { .pixels = NULL, };
+    sxbp_init_bitmap(13, 40, &bitmap);
+    for(uint32_t y = 0; y < bitmap.height; y++) {
+        uint32_t x = y % bitmap.width;
+        bitmap.pixels[(y * sxbp_bitmap_row_size(bitmap.width)) + (x / 8)] |= (
+            (uint8_t)(0x80 >> (x % 8))
+        );
+    }
+    // small blocks should give one IDAT chunk for each block of rows
+    sxbp_png_options_t options = {
+        .level = 9, .strategy = SXBP_PNG_STRATEGY_RLE, .block_rows = 7,
+    };
+    sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+    const uint8_t signature[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n',
+    };
+    if(
+        (
+            sxbp_render_backend_png_parallel(bitmap, options, &buffer) !=
+            SXBP_OPERATION_OK
+        ) ||
+        (buffer.size < 8) ||
+        (memcmp(buffer.bytes, signature, 8) != 0)
+    ) {
+        result = false;
+    } else {
+        // walk the chunks, which should end with IEND at the end of the buffer
+        size_t index = 8;
+        uint32_t idat_count = 0;
+        bool ended = false;
+        // the payloads of the IDAT chunks together make up one zlib stream
+        uint8_t* stream = malloc(buffer.size);
+        size_t stream_size = 0;
+        while(!ended && buffer.size - index >= 12) {
+            uint32_t length = (
+                ((uint32_t)buffer.bytes[index] << 24) |
+                ((uint32_t)buffer.bytes[index + 1] << 16) |
+                ((uint32_t)buffer.bytes[index + 2] << 8) |
+                (uint32_t)buffer.bytes[index + 3]
+            );
+            if(buffer.size - index - 12 < length) {
+                break;
+            }
+            if(memcmp(buffer.bytes + index + 4, "IDAT", 4) == 0) {
+                idat_count++;
+                memcpy(stream + stream_size, buffer.bytes + index + 8, length);
+                stream_size += length;
+            }
+            ended = (memcmp(buffer.bytes + index + 4, "IEND", 4) == 0);
+            index += 12 + (size_t)length;
+        }
+        if(!ended || index != buffer.size || idat_count != 6) {
+            result = false;
+        }
+        #ifdef LIBSXBP_PNG_SUPPORT
+        /*
+         * the stitched stream should inflate, passing zlib's Adler-32 check,
+         * to each row of the bitmap inverted after a filter type byte of 0
+         */
+        uint8_t expected[40 * 3];
+        for(uint32_t y = 0; y < bitmap.height; y++) {
+            expected[y * 3] = 0;
+            expected[(y * 3) + 1] = (uint8_t)~bitmap.pixels[y * 2];
+            expected[(y * 3) + 2] = (uint8_t)(
+                ~bitmap.pixels[(y * 2) + 1] & 0xf8
+            );
+        }
+        uint8_t inflated[40 * 3 + 1];
+        uLongf inflated_size = sizeof(inflated);
+        if(
+            (
+                uncompress(inflated, &inflated_size, stream, stream_size) !=
+                Z_OK
+            ) ||
+            (inflated_size != sizeof(expected)) ||
+            (memcmp(inflated, expected, sizeof(expected)) != 0)
+        ) {
+            result = false;
+        }
+        #endif
+        free(stream);
+    }
+    free(buffer.bytes);
+    // invalid compression levels should be refused
+    options.level = 10;
+    buffer.bytes = NULL;
+    if(
+        sxbp_render_backend_png_parallel(bitmap, options, &buffer) !=
+        SXBP_OPERATION_FAIL
+    ) {
+        result = false;
+    }
+
+    // free memory
+    sxbp_free_bitmap(&bitmap);
+
+    return result;
+}
+
+static bool test_sxbp_render_backend_png_builtin(void) {
+    // success / failure variable
+    bool result = true;
+    // two identical rows, so the second should be coded as a repeat of the first
+    sxbp_bitmap_t bitmap = { .pixels = NULL, };
+    sxbp_init_bitmap(16, 2, &bitmap);
+    bitmap.pixels[0] = 0x81;
+    bitmap.pixels[2] = 0x81;
+    /*
+     * the zlib stream expected: three literals (filter type and inverted
+     * pixels), a match of 3 bytes from 3 bytes back, then the checksum
+     */
+    const uint8_t expected_idat[12] = {
+        0x78, 0x01, 0x63, 0xa8, 0xfb, 0x0f, 0x44, 0x00, 0x08, 0x73, 0x02, 0xfb,
+    };
+    const uint8_t signature[8] = {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n',
+    };
+    sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+    if(
+        (sxbp_render_backend_png_builtin(bitmap, &buffer) != SXBP_OPERATION_OK) ||
+        (buffer.size < 8) ||
+        (memcmp(buffer.bytes, signature, 8) != 0)
+    ) {
+        result = false;
+    } else {
+        // walk the chunks, which should end with IEND at the end of the buffer
+        size_t index = 8;
+        uint32_t idat_count = 0;
+        bool ended = false;
+        while(!ended && buffer.size - index >= 12) {
+            uint32_t length = (
+                ((uint32_t)buffer.bytes[index] << 24) |
+                ((uint32_t)buffer.bytes[index + 1] << 16) |
+                ((uint32_t)buffer.bytes[index + 2] << 8) |
+                (uint32_t)buffer.bytes[index + 3]
+            );
+            if(memcmp(buffer.bytes + index + 4, "IDAT", 4) == 0) {
+                idat_count++;
+                if(
+                    (length != 12) ||
+                    (memcmp(buffer.bytes + index + 8, expected_idat, 12) != 0)
+                ) {
+                    result = false;
+                }
+            }
+            ended = (memcmp(buffer.bytes + index + 4, "IEND", 4) == 0);
+            index += 12 + (size_t)length;
+        }
+        if(!ended || index != buffer.size || idat_count != 1) {
+            result = false;
+        }
+    }
+
+    // free memory
+    free(buffer.bytes);
+    sxbp_free_bitmap(&bitmap);
+
+    return result;
+}
+
+static bool test_sxbp_render_backend_tiff_g4(void) {
+    // success / failure variable
+    bool result = true;
+    // two identical rows, each with a black pixel at either end of a white run
+    sxbp_bitmap_t bitmap = { .pixels = NULL, };
+    sxbp_init_bitmap(16, 2, &bitmap);
+    bitmap.pixels[0] = 0x81;
+    bitmap.pixels[2] = 0x81;
+    /*
+     * the compressed image expected: the first row in horizontal mode, as the
+     * row above it is blank, then the second row all in vertical mode, then
+     * two end of line codes
+     */
+    const uint8_t expected_strip[8] = {
+        0x26, 0xa8, 0xf2, 0xfc, 0x00, 0x40, 0x04, 0x00,
+    };
+    sxbp_buffer_t buffer = { .size = 0, .bytes = NULL, };
+    if(
+        (sxbp_render_backend_tiff_g4(bitmap, &buffer) != SXBP_OPERATION_OK) ||
+        (buffer.size < 18) ||
+        // little-endian header pointing to the IFD straight after the strip
+        (memcmp(buffer.bytes, "II*\0\x10\0\0\0", 8) != 0) ||
+        (memcmp(buffer.bytes + 8, expected_strip, 8) != 0)
+    ) {
+        result = false;
+    } else {
+        // the IFD should fit in the buffer and flag the Group 4 compression
+        uint16_t entry_count = (uint16_t)(
+            buffer.bytes[16] | (buffer.bytes[17] << 8)
+        );
+        bool compression_found = false;
+        if(18 + (12 * (size_t)entry_count) + 4 <= buffer.size) {
+            for(uint16_t i = 0; i < entry_count; i++) {
+                const uint8_t* entry = buffer.bytes + 18 + (12 * i);
+                // tag 259 is Compression, where 4 is CCITT Group 4
+                if(entry[0] == 0x03 && entry[1] == 0x01) {
+                    compression_found = (entry[8] == 4);
+                }
+            }
+        }
+        if(!compression_found) {
+            result = false;
+        }
+    }
+
+    // free memory
+    free(buffer.bytes);
+    sxbp_free_bitmap(&bitmap);
+
+    return result;
+}
+
+static bool test_sxbp_render_spiral_rle(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_spiral_t spiral = make_overlapping_spiral(300);
+    sxbp_bitmap_t expected = { .pixels = NULL, };
+    sxbp_render_spiral_raw(spiral, &expected);
+    sxbp_rle_bitmap_t image = { .runs = NULL, };
+    size_t row_size = sxbp_bitmap_row_size(expected.width);
+    uint8_t* row = malloc(row_size);
+    if(
+        (sxbp_render_spiral_rle(spiral, &image) != SXBP_OPERATION_OK) ||
+        (image.width != expected.width) || (image.height != expected.height)
+    ) {
+        result = false;
+    } else {
+        // each row should have the same pixels, from runs which never touch
+        for(uint32_t y = 0; y < image.height && result; y++) {
+            for(
+                size_t i = image.row_starts[y] + 1;
+                i < image.row_starts[y + 1]; i++
+            ) {
+                if(
+                    image.runs[i].x <=
+                    image.runs[i - 1].x + image.runs[i - 1].length
+                ) {
+                    result = false;
+                }
+            }
+            sxbp_get_rle_bitmap_row(image, y, row);
+            if(memcmp(row, expected.pixels + (y * row_size), row_size) != 0) {
+                result = false;
+            }
+        }
+        // encoding from the runs should give the same files as from pixels
+        sxbp_status_t(* bitmap_backends[3])(sxbp_bitmap_t, sxbp_buffer_t*) = {
+            sxbp_render_backend_pbm, sxbp_render_backend_png_builtin,
+            sxbp_render_backend_tiff_g4,
+        };
+        sxbp_status_t(* rle_backends[3])(sxbp_rle_bitmap_t, sxbp_buffer_t*) = {
+            sxbp_render_backend_pbm_rle, sxbp_render_backend_png_builtin_rle,
+            sxbp_render_backend_tiff_g4_rle,
+        };
+        for(uint8_t i = 0; i < 3; i++) {
+            sxbp_buffer_t from_bitmap = { .bytes = NULL, };
+            sxbp_buffer_t from_rle = { .bytes = NULL, };
+            if(
+                (
+                    bitmap_backends[i](expected, &from_bitmap) !=
+                    SXBP_OPERATION_OK
+                ) ||
+                (rle_backends[i](image, &from_rle) != SXBP_OPERATION_OK) ||
+                (from_bitmap.size != from_rle.size) ||
+                (
+                    memcmp(from_bitmap.bytes, from_rle.bytes, from_rle.size) !=
+                    0
+                )
+            ) {
+                result = false;
+            }
+            free(from_bitmap.bytes);
+            free(from_rle.bytes);
+        }
+    }
+
+    // free memory
+    free(row);
+    sxbp_free_rle_bitmap(&image);
+    sxbp_free_bitmap(&expected);
+    free(spiral.lines);
+
+    return result;
+}
+
+static bool test_sxbp_render_spiral_raw_leaves_cache(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_spiral_t spiral = make_overlapping_spiral(300);
+    // rendering a spiral without a cache shouldn't need to give it one
+    sxbp_bitmap_t uncached = { .pixels = NULL, };
+    if(
+        (sxbp_render_spiral_raw(spiral, &uncached) != SXBP_OPERATION_OK) ||
+        (spiral.co_ord_cache.co_ords.items != NULL) ||
+        (spiral.co_ord_cache.validity != 0)
+    ) {
+        result = false;
+    }
+    // nor should rendering a spiral with a cache touch it
+    sxbp_cache_spiral_points(&spiral, spiral.size / 2);
+    sxbp_co_ord_cache_t cache = spiral.co_ord_cache;
+    sxbp_co_ord_t last = cache.co_ords.items[cache.co_ords.size - 1];
+    sxbp_bitmap_t cached = { .pixels = NULL, };
+    if(
+        (sxbp_render_spiral_raw(spiral, &cached) != SXBP_OPERATION_OK) ||
+        (spiral.co_ord_cache.co_ords.items != cache.co_ords.items) ||
+        (spiral.co_ord_cache.co_ords.size != cache.co_ords.size) ||
+        (spiral.co_ord_cache.validity != cache.validity) ||
+        (cache.co_ords.items[cache.co_ords.size - 1].x != last.x) ||
+        (cache.co_ords.items[cache.co_ords.size - 1].y != last.y)
+    ) {
+        result = false;
+    } else if(
+        (cached.width != uncached.width) ||
+        (cached.height != uncached.height) ||
+        (
+            memcmp(
+                cached.pixels, uncached.pixels,
+                sxbp_bitmap_row_size(cached.width) * cached.height
+            ) != 0
+        )
+    ) {
+        result = false;
+    }
+
+    // free memory
+    sxbp_free_bitmap(&uncached);
+    sxbp_free_bitmap(&cached);
+    free(spiral.co_ord_cache.co_ords.items);
+    free(spiral.lines);
+    return result;
+}
+
+/*
+ * private function, progress callback which checks that the bounds kept in the
+ * co-ord cache of a spiral being solved match those of all its cached co-ords
+ */
+static void check_cache_bounds_callback(
+    sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+    void* progress_callback_user_data
+) {
+    bool* result = (bool*)progress_callback_user_data;
+    sxbp_co_ord_array_t co_ords = spiral->co_ord_cache.co_ords;
+    sxbp_co_ord_t min = co_ords.items[0], max = co_ords.items[0];
+    for(size_t i = 1; i < co_ords.size; i++) {
+        min.x = (co_ords.items[i].x < min.x) ? co_ords.items[i].x : min.x;
+        min.y = (co_ords.items[i].y < min.y) ? co_ords.items[i].y : min.y;
+        max.x = (co_ords.items[i].x > max.x) ? co_ords.items[i].x : max.x;
+        max.y = (co_ords.items[i].y > max.y) ? co_ords.items[i].y : max.y;
+    }
+    if(
+        (spiral->co_ord_cache.validity != latest_line + 1U) ||
+        (spiral->co_ord_cache.bounds[0].x != min.x) ||
+        (spiral->co_ord_cache.bounds[0].y != min.y) ||
+        (spiral->co_ord_cache.bounds[1].x != max.x) ||
+        (spiral->co_ord_cache.bounds[1].y != max.y) ||
+        (latest_line >= target_line)
+    ) {
+        *result = false;
+    }
+}
+
+static bool test_sxbp_spiral_stats(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_spiral_t spiral = make_test_spiral(8);
+    // the bounds in the cache should be right after every line is solved
+    sxbp_plot_spiral(
+        &spiral, 1, spiral.size, check_cache_bounds_callback, (void*)&result
+    );
+    // stats read from the cache should match those found from the lines
+    sxbp_spiral_t uncached = spiral;
+    uncached.co_ord_cache = sxbp_blank_spiral().co_ord_cache;
+    sxbp_spiral_stats_t cached_stats = sxbp_spiral_stats(spiral);
+    sxbp_spiral_stats_t stats = sxbp_spiral_stats(uncached);
+    sxbp_bitmap_t image = { .pixels = NULL, };
+    sxbp_render_spiral_raw(spiral, &image);
+    if(
+        (spiral.co_ord_cache.validity != spiral.size) ||
+        (stats.length != sxbp_sum_lines(spiral, 0, spiral.size)) ||
+        (stats.points != spiral.co_ord_cache.co_ords.size) ||
+        (stats.width != image.width) || (stats.height != image.height)
+    ) {
+        result = false;
+    } else if(
+        (cached_stats.length != stats.length) ||
+        (cached_stats.points != stats.points) ||
+        (cached_stats.min.x != stats.min.x) ||
+        (cached_stats.min.y != stats.min.y) ||
+        (cached_stats.max.x != stats.max.x) ||
+        (cached_stats.max.y != stats.max.y) ||
+        (cached_stats.width != stats.width) ||
+        (cached_stats.height != stats.height)
+    ) {
+        result = false;
+    }
+
+    // free memory
+    sxbp_free_bitmap(&image);
+    free(spiral.co_ord_cache.co_ords.items);
+    free(spiral.lines);
+    return result;
+}
+
+static bool test_sxbp_render_spiral_image_pooled(void) {
+    // success / failure variable
+    bool result = true;
+    sxbp_render_context_t context = sxbp_blank_render_context();
+    // render spirals of different sizes, the largest first
+    size_t sizes[3] = { 300, 20, 120, };
+    uint8_t* first_pixels = NULL;
+    for(uint8_t s = 0; s < 3; s++) {
+        sxbp_spiral_t spiral = make_overlapping_spiral(sizes[s]);
+        sxbp_buffer_t expected_pbm = { .bytes = NULL, };
+        sxbp_buffer_t expected_png = { .bytes = NULL, };
+        sxbp_render_spiral_image(
+            spiral, &expected_pbm, sxbp_render_backend_pbm
+        );
+        sxbp_render_spiral_image(
+            spiral, &expected_png, sxbp_render_backend_png_builtin
+        );
+        sxbp_buffer_t pbm = { .bytes = NULL, };
+        sxbp_buffer_t png = { .bytes = NULL, };
+        if(
+            (
+                sxbp_render_spiral_image_pooled(
+                    &context, spiral, sxbp_render_backend_pbm_size,
+                    sxbp_render_backend_pbm_into, &pbm
+                ) != SXBP_OPERATION_OK
+            ) ||
+            (pbm.size != expected_pbm.size) ||
+            (memcmp(pbm.bytes, expected_pbm.bytes, pbm.size) != 0)
+        ) {
+            result = false;
+        }
+        // the memory of the first and largest image should be kept
+        if(s == 0) {
+            first_pixels = context.bitmap.pixels;
+        } else if(context.bitmap.pixels != first_pixels) {
+            result = false;
+        }
+        if(
+            (
+                sxbp_render_spiral_image_pooled(
+                    &context, spiral,
+                    sxbp_render_backend_png_builtin_size_bound,
+                    sxbp_render_backend_png_builtin_into, &png
+                ) != SXBP_OPERATION_OK
+            ) ||
+            (png.size != expected_png.size) ||
+            (memcmp(png.bytes, expected_png.bytes, png.size) != 0)
+        ) {
+            result = false;
+        }
+        free(expected_pbm.bytes);
+        free(expected_png.bytes);
+        free(spiral.lines);
+    }
+
+    // free memory
+    sxbp_free_render_context(&context);
+    return result;
+}
+
+/*
+ * private type, the user data of live_render_callback(), holding the live
+ * render, a copy of its pixels from before the last update and the result
+ */
+typedef struct live_render_test_t {
+    sxbp_live_render_t live;
+    uint8_t* previous;
+    bool result;
+} live_render_test_t;
+
+/*
+ * private function, progress callback which updates a live render and checks
+ * that its image matches a full render, and only changed in the dirty rect
+ */
+static void live_render_callback(
+    sxbp_spiral_t* spiral, uint32_t latest_line, uint32_t target_line,
+    void* progress_callback_user_data
+) {
+    live_render_test_t* test = (live_render_test_t*)progress_callback_user_data;
+    sxbp_bitmap_t before = test->live.image;
+    size_t size = sxbp_bitmap_row_size(before.width) * before.height;
+    test->previous = realloc(test->previous, size);
+    memcpy(test->previous, before.pixels, size);
+    sxbp_pixel_rect_t dirty;
+    sxbp_bitmap_t expected = { .pixels = NULL, };
+    sxbp_render_spiral_raw(*spiral, &expected);
+    if(
+        (sxbp_update_live_render(&test->live, *spiral, &dirty) !=
+        SXBP_OPERATION_OK) || (latest_line >= target_line)
+    ) {
+        test->result = false;
+    } else if(
+        (test->live.image.width != expected.width) ||
+        (test->live.image.height != expected.height) ||
+        (
+            memcmp(
+                test->live.image.pixels, expected.pixels,
+                sxbp_bitmap_row_size(expected.width) * expected.height
+            ) != 0
+        )
+    ) {
+        test->result = false;
+    } else if(
+        (before.width == expected.width) && (before.height == expected.height)
+    ) {
+        sxbp_bitmap_t after = test->live.image;
+        for(uint32_t y = 0; y < after.height; y++) {
+            for(uint32_t x = 0; x < after.width; x++) {
+                bool inside = (
+                    (x >= dirty.x) && (x < dirty.x + dirty.width) &&
+                    (y >= dirty.y) && (y < dirty.y + dirty.height)
+                );
+                bool changed = (
+                    sxbp_get_bitmap_pixel(after, x, y) !=
+                    sxbp_get_bitmap_pixel(
+                        (sxbp_bitmap_t){
+                            before.width, before.height, test->previous,
+                        }, x, y
+                    )
+                );
+                if(changed && !inside) {
+                    test->result = false;
+                }
+            }
+        }
+    }
+    sxbp_free_bitmap(&expected);
+}
+
+static bool test_sxbp_update_live_render(void) {
+    sxbp_spiral_t spiral = make_test_spiral(8);
+    live_render_test_t test = {
+        .live = { .image = { .pixels = NULL, }, },
+        .previous = NULL,
+        .result = true,
+    };
+    if(sxbp_begin_live_render(spiral, &test.live) != SXBP_OPERATION_OK) {
+        test.result = false;
+    } else {
+        // the live render should match a full render after every line
+        sxbp_plot_spiral(
+            &spiral, 1, spiral.size, live_render_callback, (void*)&test
+        );
+        /*
+         * and as the spiral shrinks from its end, one line at a time, and then
+         * grows back again, so that its bounds both shrink and grow
+         */
+        sxbp_length_t lengths[64];
+        for(uint32_t i = 64; i-- > 0; ) {
+            lengths[i] = spiral.lines[i].length;
+            spiral.lines[i].length = 0;
+            spiral.co_ord_cache.validity = 0;
+            live_render_callback(&spiral, 0, 1, (void*)&test);
+        }
+        for(uint32_t i = 0; i < 64; i++) {
+            spiral.lines[i].length = lengths[i];
+            spiral.co_ord_cache.validity = 0;
+            live_render_callback(&spiral, 0, 1, (void*)&test);
+        }
+        // and nothing should be dirty if nothing changed
+        sxbp_pixel_rect_t dirty;
+        if(
+            (sxbp_update_live_render(&test.live, spiral, &dirty) !=
+            SXBP_OPERATION_OK) || (dirty.width != 0) || (dirty.height != 0)
+        ) {
+            test.result = false;
+        }
+    }
+
+    // free memory
+    sxbp_free_live_render(&test.live);
+    free(test.previous);
+    free(spiral.co_ord_cache.co_ords.items);
+    free(spiral.lines);
+    return test.result;
+}
+
+static bool test_sxbp_render_spiral_atlas(void) {
+    // success / failure variable
+    bool result = true;
+    // spirals of a few different sizes
+    size_t sizes[5] = { 40, 3, 17, 1, 25, };
+    sxbp_spiral_t spirals[5];
+    for(uint8_t s = 0; s < 5; s++) {
+        spirals[s] = make_overlapping_spiral(sizes[s]);
+    }
+    sxbp_bitmap_t atlas = { .pixels = NULL, };
+    sxbp_pixel_rect_t placements[5];
+    if(
+        sxbp_render_spiral_atlas(spirals, 5, 0, 2, &atlas, placements) !=
+        SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else {
+        for(uint8_t s = 0; s < 5 && result; s++) {
+            sxbp_pixel_rect_t place = placements[s];
+            // each spiral should be fully inside, and clear of the others
+            if(
+                (place.x + place.width > atlas.width) ||
+                (place.y + place.height > atlas.height)
+            ) {
+                result = false;
+            }
+            for(uint8_t o = 0; o < s; o++) {
+                sxbp_pixel_rect_t other = placements[o];
+                if(
+                    (place.x < other.x + other.width + 2) &&
+                    (other.x < place.x + place.width + 2) &&
+                    (place.y < other.y + other.height + 2) &&
+                    (other.y < place.y + place.height + 2)
+                ) {
+                    result = false;
+                }
+            }
+            // and drawn exactly as it is on its own
+            sxbp_bitmap_t expected = { .pixels = NULL, };
+            sxbp_render_spiral_raw(spirals[s], &expected);
+            if(
+                (expected.width != place.width) ||
+                (expected.height != place.height)
+            ) {
+                result = false;
+            }
+            for(uint32_t y = 0; y < expected.height && result; y++) {
+                for(uint32_t x = 0; x < expected.width; x++) {
+                    if(
+                        sxbp_get_bitmap_pixel(expected, x, y) !=
+                        sxbp_get_bitmap_pixel(atlas, place.x + x, place.y + y)
+                    ) {
+                        result = false;
+                    }
+                }
+            }
+            sxbp_free_bitmap(&expected);
+        }
+    }
+
+    // free memory
+    sxbp_free_bitmap(&atlas);
+    for(uint8_t s = 0; s < 5; s++) {
+        free(spirals[s].lines);
+    }
+    return result;
+}
+
+static bool test_sxbp_write_file_atomic(void) {
+    // success / failure variable
+    bool result = true;
+    // path of the file to write - removed again at the end
+    const char* path = "test_atomic.bin";
+    uint8_t first[3] = { 1, 2, 3, };
+    uint8_t second[5] = { 4, 5, 6, 7, 8, };
+    sxbp_buffer_t buffer = { .bytes = first, .size = 3, };
+    // writing twice should leave only the second contents in the file
+    if(sxbp_write_file_atomic(buffer, path) != SXBP_OPERATION_OK) {
+        result = false;
+    }
+    buffer.bytes = second;
+    buffer.size = 5;
+    if(sxbp_write_file_atomic(buffer, path) != SXBP_OPERATION_OK) {
+        result = false;
+    }
+    sxbp_buffer_t read = { .bytes = NULL, .size = 0, };
+    if(sxbp_read_file(path, &read) != SXBP_OPERATION_OK) {
+        result = false;
+    } else if(read.size != 5 || memcmp(read.bytes, second, 5) != 0) {
+        result = false;
+    }
+    free(read.bytes);
+    // the old fixed temporary path should never be used or left behind
+    sxbp_buffer_t leftover = { .bytes = NULL, .size = 0, };
+    if(sxbp_read_file("test_atomic.bin.tmp", &leftover) == SXBP_OPERATION_OK) {
+        result = false;
+    }
+    free(leftover.bytes);
+    remove(path);
+    return result;
+}
+
+/*
+ * replaces the file at path with contents of a fixed size filled with the
+ * given writer number many times over, reading it back after each write.
+ * Returns whether every write succeeded and every file read back was filled
+ * with a single (non-zero) writer number, and so wasn't torn or truncated.
+ */
+static bool write_file_atomic_repeatedly(const char* path, uint8_t writer) {
+    bool result = true;
+    uint8_t contents[4096];
+    memset(contents, writer + 1, sizeof(contents));
+    sxbp_buffer_t buffer = { .bytes = contents, .size = sizeof(contents), };
+    for(uint8_t i = 0; i < 32; i++) {
+        if(sxbp_write_file_atomic(buffer, path) != SXBP_OPERATION_OK) {
+            result = false;
+            continue;
+        }
+        sxbp_buffer_t read = { .bytes = NULL, .size = 0, };
+        if(sxbp_read_file(path, &read) != SXBP_OPERATION_OK) {
+            result = false;
+        } else if(read.size != sizeof(contents) || read.bytes[0] == 0) {
+            result = false;
+        } else {
+            for(size_t j = 1; j < read.size; j++) {
+                if(read.bytes[j] != read.bytes[0]) {
+                    result = false;
+                }
+            }
+        }
+        free(read.bytes);
+    }
+    return result;
+}
+
+static bool test_sxbp_write_file_atomic_concurrently(void) {
+    // success / failure variable
+    bool result = true;
+    // path of the file all writers replace - removed again at the end
+    const char* path = "test_atomic_concurrent.bin";
+    #ifdef TESTS_POSIX_PROCESSES
+    /*
+     * writers in forked processes start with the same time, stack addresses
+     * and counts as each other, so only the process ID tells them apart
+     */
+    pid_t children[6];
+    for(uint8_t i = 0; i < 6; i++) {
+        children[i] = fork();
+        if(children[i] == 0) {
+            _exit(write_file_atomic_repeatedly(path, 8 + i) ? 0 : 1);
+        } else if(children[i] < 0) {
+            result = false;
+        }
+    }
+    #endif
+    // meanwhile, writers in several threads of this process do the same
+    #ifdef LIBSXBP_OPENMP_SUPPORT
+    #pragma omp parallel for num_threads(8) schedule(static, 1)
+    #endif
+    for(uint8_t writer = 0; writer < 8; writer++) {
+        if(!write_file_atomic_repeatedly(path, writer)) {
+            #ifdef LIBSXBP_OPENMP_SUPPORT
+            #pragma omp critical
+            #endif
+            result = false;
+        }
+    }
+    #ifdef TESTS_POSIX_PROCESSES
+    for(uint8_t i = 0; i < 6; i++) {
+        int status = 0;
+        if(
+            children[i] > 0 && (
+                waitpid(children[i], &status, 0) != children[i] ||
+                !WIFEXITED(status) || WEXITSTATUS(status) != 0
+            )
+        ) {
+            result = false;
+        }
+    }
+    #endif
+    remove(path);
+    return result;
+}
+
+static bool test_sxbp_plot_spiral_checkpointed(void) {
+    // success / failure variable
+    bool result = true;
+    // path of the checkpoint file to use - removed again at the end
+    const char* path = "test_checkpoint.sxbp";
+    // build input struct
+    sxbp_spiral_t spiral = { .size = 16, };
+    spiral.lines = calloc(sizeof(sxbp_line_t), 16);
+    sxbp_direction_t directions[16] = {
+        SXBP_UP, SXBP_LEFT, SXBP_DOWN, SXBP_LEFT, SXBP_DOWN, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT, SXBP_UP, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT,
+    };
+    sxbp_length_t lengths[16] = {
+        1, 1, 1, 1, 1, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 1,
+    };
+    for(uint8_t i = 0; i < 16; i++) {
+        spiral.lines[i].direction = directions[i];
+    }
+    sxbp_checkpoint_t checkpoint = {
+        .path = path, .line_interval = 4, .seconds_interval = 0,
+    };
+
+    // solve part of the spiral, then resume solving from the checkpoint
+    sxbp_spiral_t resumed = sxbp_blank_spiral();
+    if(
+        sxbp_plot_spiral_checkpointed(
+            &spiral, 1, 9, checkpoint, NULL, NULL
+        ) != SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else if(sxbp_load_checkpoint(path, &resumed).status != SXBP_OPERATION_OK) {
+        result = false;
+    } else if(resumed.solved_count != 9) {
+        result = false;
+    } else if(
+        sxbp_plot_spiral_checkpointed(
+            &resumed, 1, 16, checkpoint, NULL, NULL
+        ) != SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else {
+        // the final checkpoint should contain the fully solved spiral
+        sxbp_spiral_t output = sxbp_blank_spiral();
+        if(sxbp_load_checkpoint(path, &output).status != SXBP_OPERATION_OK) {
+            result = false;
+        } else {
+            if(output.solved_count != 16) {
+                result = false;
+            }
+            for(uint8_t i = 0; i < 16; i++) {
+                if(output.lines[i].length != lengths[i]) {
+                    result = false;
+                }
+            }
+            free(output.lines);
+        }
+    }
+    // checkpoints saved in the native and compact formats should load too
+    for(uint8_t f = 0; f < 2; f++) {
+        sxbp_buffer_t other = { .size = 0, .bytes = NULL, };
+        if(f == 0) {
+            sxbp_dump_spiral_native(spiral, &other);
+        } else {
+            sxbp_dump_spiral_compact(spiral, &other);
+        }
+        sxbp_spiral_t loaded = sxbp_blank_spiral();
+        if(
+            (sxbp_write_file_atomic(other, path) != SXBP_OPERATION_OK) ||
+            (sxbp_load_checkpoint(path, &loaded).status != SXBP_OPERATION_OK)
+        ) {
+            result = false;
+        } else if(loaded.solved_count != 9) {
+            result = false;
+        }
+        free(loaded.lines);
+        free(other.bytes);
+    }
+
+    // free memory and remove the checkpoint file
+    free(spiral.lines);
+    free(spiral.co_ord_cache.co_ords.items);
+    free(resumed.lines);
+    free(resumed.co_ord_cache.co_ords.items);
+    remove(path);
+
+    return result;
+}
+
+static bool test_sxbp_replay_and_compact_journal(void) {
+    // success / failure variable
+    bool result = true;
+    // paths of the base spiral and journal files - removed again at the end
+    const char* spiral_path = "test_journal_base.sxbp";
+    const char* journal_path = "test_journal.sxbj";
+    // build input struct
+    sxbp_spiral_t spiral = { .size = 16, };
+    spiral.lines = calloc(sizeof(sxbp_line_t), 16);
+    sxbp_direction_t directions[16] = {
+        SXBP_UP, SXBP_LEFT, SXBP_DOWN, SXBP_LEFT, SXBP_DOWN, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT, SXBP_UP, SXBP_RIGHT,
+        SXBP_DOWN, SXBP_RIGHT, SXBP_UP, SXBP_LEFT,
+    };
+    sxbp_length_t lengths[16] = {
+        1, 1, 1, 1, 1, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 1,
+    };
+    for(uint8_t i = 0; i < 16; i++) {
+        spiral.lines[i].direction = directions[i];
+    }
+    // write the unsolved spiral out as the base, then journal while solving
+    sxbp_journal_t journal = { .file = NULL, };
+    sxbp_save_checkpoint(spiral, spiral_path);
+    sxbp_open_journal(journal_path, spiral, &journal);
+    sxbp_plot_spiral(
+        &spiral, 1, 16, sxbp_journal_progress_callback, (void*)&journal
+    );
+    if(sxbp_close_journal(&journal) != SXBP_OPERATION_OK) {
+        result = false;
+    }
+
+    // replay the journal onto the base and check it matches the solved spiral
+    sxbp_spiral_t replayed = sxbp_blank_spiral();
+    sxbp_buffer_t buffer = { .bytes = NULL, .size = 0, };
+    sxbp_load_checkpoint(spiral_path, &replayed);
+    sxbp_read_file(journal_path, &buffer);
+    if(
+        (buffer.bytes == NULL) || (replayed.lines == NULL) ||
+        (sxbp_replay_journal(buffer, &replayed).status != SXBP_OPERATION_OK)
+    ) {
+        result = false;
+    } else if(replayed.solved_count != 16) {
+        result = false;
+    } else {
+        for(uint8_t i = 0; i < 16; i++) {
+            if(replayed.lines[i].length != lengths[i]) {
+                result = false;
+            }
+        }
+    }
+    free(buffer.bytes);
+    free(replayed.lines);
+
+    // compacting should fold the journal into the base file
+    sxbp_spiral_t compacted = sxbp_blank_spiral();
+    if(
+        sxbp_compact_journal(spiral_path, journal_path).status !=
+        SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else if(
+        sxbp_load_checkpoint(spiral_path, &compacted).status !=
+        SXBP_OPERATION_OK
+    ) {
+        result = false;
+    } else {
+        for(uint8_t i = 0; i < 16; i++) {
+            if(compacted.lines[i].length != lengths[i]) {
+                result = false;
+            }
+        }
+        free(compacted.lines);
+    }
+
+    // free memory and remove the files
+    free(spiral.lines);
+    free(spiral.co_ord_cache.co_ords.items);
+    remove(spiral_path);
+    remove(journal_path);
+
+    return result;
+}
+
+// this function takes a bool containing the test suite status,
+// a function pointer to a test case function, and a string containing the
+// test case's name. it will run the test case function and return the success
+// or failure status, which should be stored in the test suite status bool.
+static bool run_test_case(
+    bool test_suite_state, bool(* test_case_func)(), char* test_case_name
+) {
+    printf("%s: ", test_case_name);
+    fflush(stdout);
+    bool test_result = (*test_case_func)();
+    printf("%s\n", (test_result ? "PASS" : "FAIL"));
+    return test_suite_state && test_result;
+}
+
+int main(void) {
+    // set up test suite status flag
+    bool result = true;
+    // call run_test_case() for each test case
+    result = run_test_case(
+        result, test_sxbp_change_direction, "test_sxbp_change_direction"
+    );
+    result = run_test_case(
+        result, test_sxbp_init_spiral, "test_sxbp_init_spiral"
+    );
+    result = run_test_case(
+        result, test_sxbp_spiral_points, "test_sxbp_spiral_points"
+    );
+    result = run_test_case(
+        result, test_sxbp_cache_spiral_points_blank,
+        "test_sxbp_cache_spiral_points_blank"
+    );
+    result = run_test_case(
+        result, test_sxbp_plot_spiral, "test_sxbp_plot_spiral"
+    );
+    result = run_test_case(
+        result, test_sxbp_plot_spiral_partial, "test_sxbp_plot_spiral_partial"
+    );
+    result = run_test_case(
+        result, test_sxbp_plot_spiral_progress_callback,
+        "test_sxbp_plot_spiral_progress_callback"
+    );
+    result = run_test_case(
+        result, test_sxbp_load_spiral, "test_sxbp_load_spiral"
+    );
+    result = run_test_case(
+        result, test_sxbp_load_spiral_rejects_missing_magic_number,
+        "test_sxbp_load_spiral_rejects_missing_magic_number"
+    );
+    result = run_test_case(
+        result, test_sxbp_load_spiral_rejects_too_small_for_header,
+        "test_sxbp_load_spiral_rejects_too_small_for_header"
+    );
+    result = run_test_case(
+        result, test_sxbp_load_spiral_rejects_too_small_data_section,
+        "test_sxbp_load_spiral_rejects_too_small_data_section"
+    );
+    result = run_test_case(
+        result, test_sxbp_load_spiral_rejects_wrong_version,
+        "test_sxbp_load_spiral_rejects_wrong_version"
+    );
+    result = run_test_case(
+        result, test_sxbp_dump_spiral, "test_sxbp_dump_spiral"
+    );
+    result = run_test_case(
+        result, test_sxbp_dump_spiral_compact, "test_sxbp_dump_spiral_compact"
+    );
+    result = run_test_case(
+        result, test_sxbp_view_spiral, "test_sxbp_view_spiral"
+    );
+    result = run_test_case(
+        result, test_sxbp_dump_and_load_spiral_stream,
+        "test_sxbp_dump_and_load_spiral_stream"
+    );
+    result = run_test_case(
+        result, test_sxbp_dump_and_load_large_spiral,
+        "test_sxbp_dump_and_load_large_spiral"
+    );
+    result = run_test_case(
+        result, test_sxbp_peek_spiral_and_load_spiral_lines,
+        "test_sxbp_peek_spiral_and_load_spiral_lines"
+    );
+    result = run_test_case(result, test_sxbp_archive, "test_sxbp_archive");
+    result = run_test_case(
+        result, test_sxbp_dump_spiral_into, "test_sxbp_dump_spiral_into"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_raw, "test_sxbp_render_spiral_raw"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_backends_into,
+        "test_sxbp_render_backends_into"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_backend_streams,
+        "test_sxbp_render_backend_streams"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_tiles, "test_sxbp_render_spiral_tiles"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_parallel,
+        "test_sxbp_render_spiral_parallel"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_viewport,
+        "test_sxbp_render_spiral_viewport"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_scaled, "test_sxbp_render_spiral_scaled"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_backend_svg, "test_sxbp_render_backend_svg"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_backend_png_parallel,
+        "test_sxbp_render_backend_png_parallel"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_backend_png_builtin,
+        "test_sxbp_render_backend_png_builtin"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_backend_tiff_g4,
+        "test_sxbp_render_backend_tiff_g4"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_rle, "test_sxbp_render_spiral_rle"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_raw_leaves_cache,
+        "test_sxbp_render_spiral_raw_leaves_cache"
+    );
+    result = run_test_case(
+        result, test_sxbp_spiral_stats, "test_sxbp_spiral_stats"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_image_pooled,
+        "test_sxbp_render_spiral_image_pooled"
+    );
+    result = run_test_case(
+        result, test_sxbp_update_live_render, "test_sxbp_update_live_render"
+    );
+    result = run_test_case(
+        result, test_sxbp_render_spiral_atlas, "test_sxbp_render_spiral_atlas"
+    );
+    result = run_test_case(
+        result, test_sxbp_write_file_atomic, "test_sxbp_write_file_atomic"
+    );
+    result = run_test_case(
+        result, test_sxbp_write_file_atomic_concurrently,
+        "test_sxbp_write_file_atomic_concurrently"
+    );
+    result = run_test_case(
+        result, test_sxbp_plot_spiral_checkpointed,
+        "test_sxbp_plot_spiral_checkpointed"
+    );
+    result = run_test_case(
+        result, test_sxbp_replay_and_compact_journal,
+        "test_sxbp_replay_and_compact_journal"
     );
     return result ? 0 : 1;
 }